@@ -0,0 +1,48 @@
+/**
+ * @file AllocCounter.h
+ * @brief 替换全局operator new/delete，统计分配次数、释放次数和分配的字节数
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/*
+ * 用于在示例中比较不同写法的分配次数和分配量。替换的operator new/delete是普通的全局函数，
+ * 每个可执行文件只能有一个翻译单元包含本文件，否则链接时会出现重复定义。
+ * GCC会把替换后的operator delete内联进标准库代码，再把其中的free误报为与new不匹配，这里关掉这条警告
+ */
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#   pragma GCC diagnostic push
+#   pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static std::atomic<std::size_t> allocCount{0};
+static std::atomic<std::size_t> freeCount{0};
+static std::atomic<std::size_t> allocBytes{0};
+
+void* operator new(std::size_t n) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(n, std::memory_order_relaxed);
+    if (void* p = std::malloc(n == 0 ? 1 : n))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    if (p != nullptr)
+        freeCount.fetch_add(1, std::memory_order_relaxed);
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    operator delete(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#   pragma GCC diagnostic pop
+#endif
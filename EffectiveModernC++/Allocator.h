@@ -0,0 +1,484 @@
+/**
+ * @file Allocator.h
+ * @brief 可以挂到MyAllocList上的分配器：单调arena、定长内存池以及多态资源适配器
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/*
+ * 整体设计仿照C++17的std::pmr，但是只用到C++14的特性：
+ * - MemoryResource是所有内存资源的抽象基类，负责按字节分配
+ * - PolyAllocator<T>是一个满足Allocator要求的适配器，内部只持有一个MemoryResource*，因此
+ *   无论背后是arena还是内存池，容器的型别都是同一个（std::vector<T, PolyAllocator<T>>）
+ * - ArenaAllocator<T>/PoolAllocator<T>是不经过虚函数的直接版本，适合对型别没有要求的场合
+ */
+
+namespace detail {
+
+inline std::size_t alignUp(std::size_t n, std::size_t align) noexcept {
+    return (n + align - 1) & ~(align - 1);
+}
+
+/*
+ * C++14中的operator new不支持超对齐，这里多申请align字节，并在返回地址之前保存原始指针
+ */
+inline void* alignedNew(std::size_t bytes, std::size_t align) {
+    if (align <= alignof(std::max_align_t))
+        return ::operator new(bytes);
+    void* raw = ::operator new(bytes + align + sizeof(void*));
+    auto addr = reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*);
+    addr = alignUp(addr, align);
+    reinterpret_cast<void**>(addr)[-1] = raw;
+    return reinterpret_cast<void*>(addr);
+}
+
+inline void alignedDelete(void* p, std::size_t align) noexcept {
+    if (align <= alignof(std::max_align_t))
+        ::operator delete(p);
+    else
+        ::operator delete(reinterpret_cast<void**>(p)[-1]);
+}
+
+} // namespace detail
+
+class MemoryResource {
+public:
+    virtual ~MemoryResource() = default;
+
+    void* allocate(std::size_t bytes, std::size_t align = alignof(std::max_align_t)) {
+        return doAllocate(bytes, align);
+    }
+
+    void deallocate(void* p, std::size_t bytes, std::size_t align = alignof(std::max_align_t)) {
+        doDeallocate(p, bytes, align);
+    }
+
+    bool isEqual(const MemoryResource& other) const noexcept {
+        return this == &other || doIsEqual(other);
+    }
+
+private:
+    virtual void* doAllocate(std::size_t bytes, std::size_t align) = 0;
+    virtual void doDeallocate(void* p, std::size_t bytes, std::size_t align) = 0;
+    virtual bool doIsEqual(const MemoryResource&) const noexcept { return false; }
+};
+
+class NewDeleteResource : public MemoryResource {
+private:
+    void* doAllocate(std::size_t bytes, std::size_t align) override {
+        return detail::alignedNew(bytes, align);
+    }
+
+    void doDeallocate(void* p, std::size_t, std::size_t align) override {
+        detail::alignedDelete(p, align);
+    }
+
+    bool doIsEqual(const MemoryResource& other) const noexcept override {
+        return dynamic_cast<const NewDeleteResource*>(&other) != nullptr;
+    }
+};
+
+inline MemoryResource* newDeleteResource() noexcept {
+    static NewDeleteResource resource;
+    return &resource;
+}
+
+namespace detail {
+
+inline std::atomic<MemoryResource*>& defaultResourceSlot() noexcept {
+    static std::atomic<MemoryResource*> slot{newDeleteResource()};
+    return slot;
+}
+
+} // namespace detail
+
+inline MemoryResource* getDefaultResource() noexcept {
+    return detail::defaultResourceSlot().load(std::memory_order_acquire);
+}
+
+/**
+ * 设置默认的内存资源，返回之前的资源。传入nullptr表示恢复为new/delete
+ */
+inline MemoryResource* setDefaultResource(MemoryResource* r) noexcept {
+    if (r == nullptr)
+        r = newDeleteResource();
+    return detail::defaultResourceSlot().exchange(r, std::memory_order_acq_rel);
+}
+
+/**
+ * 在作用域内临时替换默认资源，离开作用域时恢复
+ */
+class ScopedDefaultResource {
+public:
+    explicit ScopedDefaultResource(MemoryResource* r) noexcept : prev(setDefaultResource(r)) {}
+    ~ScopedDefaultResource() { setDefaultResource(prev); }
+
+    ScopedDefaultResource(const ScopedDefaultResource&) = delete;
+    ScopedDefaultResource& operator=(const ScopedDefaultResource&) = delete;
+
+private:
+    MemoryResource* prev;
+};
+
+/**
+ * 单调arena：只做指针递增（bump pointer），deallocate什么都不做，内存在release()或者析构时一次性归还。
+ * 每次申请新的chunk时大小翻倍，因此chunk的数量是对数级别的。
+ *
+ * arena本身不是线程安全的，通常每个线程/每个请求各用一个
+ */
+class MonotonicArena : public MemoryResource {
+public:
+    explicit MonotonicArena(std::size_t initialSize = 4096,
+                            MemoryResource* upstream = newDeleteResource()) noexcept
+    : upstream(upstream), nextChunkSize(initialSize < 64 ? 64 : initialSize) {}
+
+    ~MonotonicArena() override { release(); }
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    /* 不经过虚函数的快速路径，ArenaAllocator直接调用 */
+    void* allocateBytes(std::size_t bytes, std::size_t align) {
+        auto p = detail::alignUp(reinterpret_cast<std::uintptr_t>(cur), align);
+        if (cur == nullptr || p + bytes > reinterpret_cast<std::uintptr_t>(end)) {
+            grow(bytes, align);
+            p = detail::alignUp(reinterpret_cast<std::uintptr_t>(cur), align);
+        }
+        cur = reinterpret_cast<char*>(p + bytes);
+        used += bytes;
+        return reinterpret_cast<void*>(p);
+    }
+
+    /**
+     * 批量释放：把所有chunk一次性还给上游资源
+     */
+    void release() noexcept {
+        while (head != nullptr) {
+            Chunk* next = head->next;
+            upstream->deallocate(head, head->size, alignof(Chunk));
+            head = next;
+        }
+        cur = end = nullptr;
+        used = reserved = 0;
+    }
+
+    /* 用户实际申请的字节数 */
+    std::size_t bytesUsed() const noexcept { return used; }
+    /* 从上游拿到的字节数，与bytesUsed之差就是对齐填充和chunk尾部的浪费 */
+    std::size_t bytesReserved() const noexcept { return reserved; }
+
+private:
+    struct Chunk {
+        Chunk* next;
+        std::size_t size;
+    };
+
+    void grow(std::size_t bytes, std::size_t align) {
+        std::size_t need = sizeof(Chunk) + bytes + align;
+        std::size_t size = nextChunkSize;
+        while (size < need)
+            size *= 2;
+        auto chunk = static_cast<Chunk*>(upstream->allocate(size, alignof(Chunk)));
+        chunk->next = head;
+        chunk->size = size;
+        head = chunk;
+        cur = reinterpret_cast<char*>(chunk + 1);
+        end = reinterpret_cast<char*>(chunk) + size;
+        reserved += size;
+        nextChunkSize = size * 2;
+    }
+
+    void* doAllocate(std::size_t bytes, std::size_t align) override {
+        return allocateBytes(bytes, align);
+    }
+
+    void doDeallocate(void*, std::size_t, std::size_t) override {}
+
+    MemoryResource* upstream;
+    Chunk* head = nullptr;
+    char* cur = nullptr;
+    char* end = nullptr;
+    std::size_t nextChunkSize;
+    std::size_t used = 0;
+    std::size_t reserved = 0;
+};
+
+/**
+ * 定长内存池：按16字节划分大小类别（最大256字节），每个类别一个全局的空闲链表，
+ * 每个线程在此之上再缓存一段thread_local的空闲链表，绝大多数分配/释放都不需要加锁。
+ *
+ * 线程本地缓存超过上限时成批归还给全局链表，为空时成批从全局链表取或者切一块新的slab。
+ * slab在进程结束之前不会还给操作系统，适合std::list/std::map这类节点容器。
+ */
+class FixedPool {
+public:
+    static constexpr std::size_t Granularity = 16;
+    static constexpr std::size_t MaxBlockSize = 256;
+    static constexpr std::size_t ClassCount = MaxBlockSize / Granularity;
+
+    static bool handles(std::size_t bytes, std::size_t align) noexcept {
+        return bytes != 0 && bytes <= MaxBlockSize && align <= Granularity;
+    }
+
+    static void* allocate(std::size_t bytes) {
+        std::size_t c = classOf(bytes);
+        Cache& cache = localCache();
+        if (cache.lists[c] == nullptr)
+            refill(cache, c);
+        Block* b = cache.lists[c];
+        cache.lists[c] = b->next;
+        --cache.counts[c];
+        return b;
+    }
+
+    static void deallocate(void* p, std::size_t bytes) noexcept {
+        std::size_t c = classOf(bytes);
+        Cache& cache = localCache();
+        auto b = static_cast<Block*>(p);
+        b->next = cache.lists[c];
+        cache.lists[c] = b;
+        if (++cache.counts[c] > 2 * BatchSize)
+            flush(cache, c, BatchSize);
+    }
+
+private:
+    static constexpr std::size_t BatchSize = 64;
+    static constexpr std::size_t SlabSize = 64 * 1024;
+
+    struct Block {
+        Block* next;
+    };
+
+    struct Cache {
+        Block* lists[ClassCount] = {};
+        std::size_t counts[ClassCount] = {};
+
+        ~Cache() {
+            for (std::size_t c = 0; c < ClassCount; ++c)
+                flush(*this, c, counts[c]);
+        }
+    };
+
+    struct Global {
+        std::mutex m;
+        Block* lists[ClassCount] = {};
+        std::vector<void*> slabs;
+
+        ~Global() {
+            for (void* s : slabs)
+                ::operator delete(s);
+        }
+    };
+
+    static std::size_t classOf(std::size_t bytes) noexcept {
+        return (bytes - 1) / Granularity;
+    }
+
+    static Global& global() {
+        static Global g;
+        return g;
+    }
+
+    static Cache& localCache() {
+        static thread_local Cache cache;
+        return cache;
+    }
+
+    static void refill(Cache& cache, std::size_t c) {
+        Global& g = global();
+        std::lock_guard<std::mutex> lk(g.m);
+        std::size_t n = 0;
+        while (g.lists[c] != nullptr && n < BatchSize) {
+            Block* b = g.lists[c];
+            g.lists[c] = b->next;
+            b->next = cache.lists[c];
+            cache.lists[c] = b;
+            ++n;
+        }
+        if (n == 0) {
+            /* 全局链表也空了，切一块新的slab */
+            std::size_t blockSize = (c + 1) * Granularity;
+            char* slab = static_cast<char*>(::operator new(SlabSize));
+            g.slabs.push_back(slab);
+            for (std::size_t off = 0; off + blockSize <= SlabSize; off += blockSize) {
+                auto b = reinterpret_cast<Block*>(slab + off);
+                b->next = cache.lists[c];
+                cache.lists[c] = b;
+                ++n;
+            }
+        }
+        cache.counts[c] += n;
+    }
+
+    static void flush(Cache& cache, std::size_t c, std::size_t n) noexcept {
+        if (n == 0)
+            return;
+        Global& g = global();
+        std::lock_guard<std::mutex> lk(g.m);
+        for (; n > 0 && cache.lists[c] != nullptr; --n) {
+            Block* b = cache.lists[c];
+            cache.lists[c] = b->next;
+            b->next = g.lists[c];
+            g.lists[c] = b;
+            --cache.counts[c];
+        }
+    }
+};
+
+/**
+ * 以MemoryResource的形式使用FixedPool，超过256字节的请求转交给上游资源
+ */
+class PoolResource : public MemoryResource {
+public:
+    explicit PoolResource(MemoryResource* upstream = newDeleteResource()) noexcept
+    : upstream(upstream) {}
+
+private:
+    void* doAllocate(std::size_t bytes, std::size_t align) override {
+        if (FixedPool::handles(bytes, align))
+            return FixedPool::allocate(bytes);
+        return upstream->allocate(bytes, align);
+    }
+
+    void doDeallocate(void* p, std::size_t bytes, std::size_t align) override {
+        if (FixedPool::handles(bytes, align))
+            FixedPool::deallocate(p, bytes);
+        else
+            upstream->deallocate(p, bytes, align);
+    }
+
+    bool doIsEqual(const MemoryResource& other) const noexcept override {
+        /* 池是全局共享的，只要上游相同就可以互相释放 */
+        auto o = dynamic_cast<const PoolResource*>(&other);
+        return o != nullptr && upstream->isEqual(*o->upstream);
+    }
+
+    MemoryResource* upstream;
+};
+
+/**
+ * 多态分配器适配器：型别与具体资源无关，默认构造时使用当前的默认资源
+ */
+template <typename T>
+class PolyAllocator {
+public:
+    using value_type = T;
+
+    PolyAllocator() noexcept : res(getDefaultResource()) {}
+    PolyAllocator(MemoryResource* r) noexcept : res(r) {}
+
+    template <typename U>
+    PolyAllocator(const PolyAllocator<U>& other) noexcept : res(other.resource()) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(res->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        res->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    /* 与std::pmr::polymorphic_allocator一致，复制容器时不传播资源 */
+    PolyAllocator select_on_container_copy_construction() const noexcept {
+        return PolyAllocator();
+    }
+
+    MemoryResource* resource() const noexcept { return res; }
+
+private:
+    MemoryResource* res;
+};
+
+template <typename T, typename U>
+bool operator==(const PolyAllocator<T>& a, const PolyAllocator<U>& b) noexcept {
+    return a.resource()->isEqual(*b.resource());
+}
+
+template <typename T, typename U>
+bool operator!=(const PolyAllocator<T>& a, const PolyAllocator<U>& b) noexcept {
+    return !(a == b);
+}
+
+/**
+ * 直接绑定到某个arena的分配器，不经过虚函数。
+ * 移动/交换容器时会把arena一起带走，因此propagate_on_container_*都设为true
+ */
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    explicit ArenaAllocator(MonotonicArena& a) noexcept : a(&a) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : a(other.arena()) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(a->allocateBytes(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, std::size_t) noexcept {}
+
+    MonotonicArena* arena() const noexcept { return a; }
+
+private:
+    MonotonicArena* a;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& x, const ArenaAllocator<U>& y) noexcept {
+    return x.arena() == y.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& x, const ArenaAllocator<U>& y) noexcept {
+    return !(x == y);
+}
+
+/**
+ * 无状态的内存池分配器，所有实例都相等。单个对象走FixedPool，数组或者大对象走operator new
+ */
+template <typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        std::size_t bytes = n * sizeof(T);
+        if (FixedPool::handles(bytes, alignof(T)))
+            return static_cast<T*>(FixedPool::allocate(bytes));
+        return static_cast<T*>(detail::alignedNew(bytes, alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        std::size_t bytes = n * sizeof(T);
+        if (FixedPool::handles(bytes, alignof(T)))
+            FixedPool::deallocate(p, bytes);
+        else
+            detail::alignedDelete(p, alignof(T));
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&) noexcept { return true; }
+
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&) noexcept { return false; }
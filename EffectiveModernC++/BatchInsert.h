@@ -0,0 +1,234 @@
+/**
+ * @file BatchInsert.h
+ * @brief 一次合并完成多个findAndInsert：先确定所有插入位置，再用一次归并生成结果
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/*
+ * 逐个调用findAndInsert时，每次insert都要把插入点之后的元素整体后移，N次插入的代价是O(N·size)。
+ *
+ * 批量版本不移动原容器中的任何元素，而是把每次插入记录为"插在某个位置之前"：
+ * - 插入点总是某个元素之前（或者末尾），因此把原容器中第i个元素之前的空隙称为槽i，末尾是槽size
+ * - 同一个槽里的新元素组成一个链表，插在某个新元素之前就是插在链表中它的前面
+ * - 后面的查找有可能命中前面刚插入的新元素，因此要为每个目标值记录它当前第一次出现的位置，
+ *   比较同一个槽内两个新元素的先后用的是order-maintenance的标签（64位整数，空间不够时局部重新分配）
+ *
+ * 所有插入位置确定以后，按槽的顺序把原元素和新元素一次归并到只分配一次的新缓冲区中。
+ * 结果与按顺序逐个调用findAndInsert完全一致。要求元素型别可以用std::hash做哈希
+ */
+
+namespace detail {
+
+template <typename V>
+class BatchInsertPlan {
+public:
+    static constexpr std::int64_t Original = -1;
+
+    explicit BatchInsertPlan(std::size_t size) : size(size) {}
+
+    /* 原容器中一个目标值第一次出现的下标 */
+    void seedOriginal(const V& value, std::size_t index) {
+        first.emplace(value, Ref{index, Original});
+    }
+
+    void trackValue(const V& value) { tracked.insert(value); }
+
+    void apply(const V& target, const V& insertVal) {
+        auto it = first.find(target);
+        Ref at = it == first.end() ? Ref{size, Original} : it->second;
+
+        std::int64_t node = static_cast<std::int64_t>(nodes.size());
+        nodes.push_back(Node{insertVal, 0, -1, -1});
+        Slot& slot = slots[at.slot];
+        if (at.node == Original)
+            link(slot, slot.tail, -1, node);
+        else
+            link(slot, nodes[at.node].prev, at.node, node);
+
+        if (tracked.count(insertVal) != 0) {
+            auto f = first.find(insertVal);
+            if (f == first.end())
+                first.emplace(insertVal, Ref{at.slot, node});
+            else if (less(Ref{at.slot, node}, f->second))
+                f->second = Ref{at.slot, node};
+        }
+    }
+
+    template <typename Container>
+    void merge(Container& container) {
+        Container result(container.get_allocator());
+        result.reserve(size + nodes.size());
+
+        std::vector<std::size_t> order;
+        order.reserve(slots.size());
+        for (const auto& s : slots)
+            order.push_back(s.first);
+        std::sort(order.begin(), order.end());
+
+        auto src = std::make_move_iterator(container.begin());
+        std::size_t done = 0;
+        for (std::size_t s : order) {
+            result.insert(result.end(), src + done, src + s);
+            done = s;
+            for (std::int64_t n = slots[s].head; n != -1; n = nodes[n].next)
+                result.push_back(std::move(nodes[n].value));
+        }
+        result.insert(result.end(), src + done, src + size);
+        container.swap(result);
+    }
+
+private:
+    /* 原元素用Original表示，它排在同一个槽中所有新元素之后 */
+    struct Ref {
+        std::size_t slot;
+        std::int64_t node;
+    };
+
+    struct Node {
+        V value;
+        std::uint64_t label;
+        std::int64_t prev;
+        std::int64_t next;
+    };
+
+    struct Slot {
+        std::int64_t head = -1;
+        std::int64_t tail = -1;
+    };
+
+    static constexpr std::uint64_t AppendGap = std::uint64_t(1) << 32;
+    static constexpr std::uint64_t MaxLabel = std::numeric_limits<std::uint64_t>::max();
+
+    bool less(const Ref& a, const Ref& b) const {
+        if (a.slot != b.slot)
+            return a.slot < b.slot;
+        std::uint64_t la = a.node == Original ? MaxLabel : nodes[a.node].label;
+        std::uint64_t lb = b.node == Original ? MaxLabel : nodes[b.node].label;
+        return la < lb;
+    }
+
+    std::uint64_t labelOf(std::int64_t n, std::uint64_t none) const {
+        return n == -1 ? none : nodes[n].label;
+    }
+
+    /* 把node插到prev和next之间（-1分别表示链表头和链表尾） */
+    void link(Slot& slot, std::int64_t prev, std::int64_t next, std::int64_t node) {
+        if (!assignLabel(prev, next, node)) {
+            relabel(prev, next);
+            assignLabel(prev, next, node);
+        }
+        nodes[node].prev = prev;
+        nodes[node].next = next;
+        (prev == -1 ? slot.head : nodes[prev].next) = node;
+        (next == -1 ? slot.tail : nodes[next].prev) = node;
+    }
+
+    bool assignLabel(std::int64_t prev, std::int64_t next, std::int64_t node) {
+        std::uint64_t lo = labelOf(prev, 0);
+        std::uint64_t hi = labelOf(next, MaxLabel);
+        if (hi - lo < 2)
+            return false;
+        /* 追加到链表尾部时留出固定的间隔，避免一直对半分 */
+        nodes[node].label = (next == -1 && hi - lo > AppendGap) ? lo + AppendGap : lo + (hi - lo) / 2;
+        return true;
+    }
+
+    /*
+     * prev和next之间没有空余的标签了：从它们向两边扩大窗口，直到窗口覆盖的标签区间足够稀疏，
+     * 再把窗口内的标签重新均匀分布。窗口每轮翻倍，均摊下来每次插入只需要重新标记很少的节点
+     */
+    void relabel(std::int64_t prev, std::int64_t next) {
+        std::int64_t lo = prev == -1 ? next : prev;
+        std::int64_t hi = next == -1 ? prev : next;
+        std::uint64_t count = (prev != -1 && next != -1) ? 2 : 1;
+        for (std::uint64_t want = 4;; want *= 2) {
+            while (count < want && (nodes[lo].prev != -1 || nodes[hi].next != -1)) {
+                if (nodes[lo].prev != -1) {
+                    lo = nodes[lo].prev;
+                    ++count;
+                }
+                if (count < want && nodes[hi].next != -1) {
+                    hi = nodes[hi].next;
+                    ++count;
+                }
+            }
+            std::uint64_t lower = labelOf(nodes[lo].prev, 0);
+            std::uint64_t upper = labelOf(nodes[hi].next, MaxLabel);
+            bool whole = nodes[lo].prev == -1 && nodes[hi].next == -1;
+            /* 重新分布后每个间隔至少要有2·count，窗口已经是整个槽时只能接受 */
+            if (whole || (upper - lower) / (count + 2) >= 2 * count) {
+                std::uint64_t step = (upper - lower) / (count + 2);
+                std::uint64_t label = lower;
+                for (std::int64_t n = lo;; n = nodes[n].next) {
+                    label += step;
+                    nodes[n].label = label;
+                    /* 在prev之后多留一个间隔给即将插入的新节点 */
+                    if (n == prev)
+                        label += step;
+                    if (n == hi)
+                        break;
+                }
+                return;
+            }
+        }
+    }
+
+    std::size_t size;
+    std::vector<Node> nodes;
+    std::unordered_map<std::size_t, Slot> slots;
+    std::unordered_map<V, Ref> first;
+    std::unordered_set<V> tracked;
+};
+
+template <typename V>
+constexpr std::int64_t BatchInsertPlan<V>::Original;
+template <typename V>
+constexpr std::uint64_t BatchInsertPlan<V>::AppendGap;
+template <typename V>
+constexpr std::uint64_t BatchInsertPlan<V>::MaxLabel;
+
+} // namespace detail
+
+/**
+ * 依次执行ops中的每个(targetVal, insertVal)：把insertVal插到当前第一个等于targetVal的元素之前，找不到则插到末尾。
+ * 结果等价于按顺序调用findAndInsert(container, targetVal, insertVal)，但是只扫描一遍原容器、只分配一次内存
+ */
+template <typename V, typename A>
+void findAndInsertBatch(std::vector<V, A>& container, const std::vector<std::pair<V, V>>& ops) {
+    if (ops.empty())
+        return;
+
+    detail::BatchInsertPlan<V> plan(container.size());
+    std::unordered_set<V> targets;
+    for (const auto& op : ops)
+        targets.insert(op.first);
+    for (const auto& t : targets)
+        plan.trackValue(t);
+
+    /* 一遍扫描找到每个目标值在原容器中的第一次出现，全部找到后提前结束 */
+    std::size_t remaining = targets.size();
+    for (std::size_t i = 0; i < container.size() && remaining > 0; ++i) {
+        auto it = targets.find(container[i]);
+        if (it != targets.end()) {
+            plan.seedOriginal(container[i], i);
+            targets.erase(it);
+            --remaining;
+        }
+    }
+
+    for (const auto& op : ops)
+        plan.apply(op.first, op.second);
+    plan.merge(container);
+}
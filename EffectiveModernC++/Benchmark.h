@@ -0,0 +1,365 @@
+/**
+ * @file Benchmark.h
+ * @brief 不依赖第三方库的微基准框架：预热、重复采样、剔除离群值、输出JSON、与基线比较
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * 每个基准是一个void(std::size_t iterations)的函数，执行iterations次被测代码：
+ *
+ *   BenchmarkSuite suite;
+ *   suite.add("item13/find/std::find", [&](std::size_t iters) {
+ *       for (std::size_t i = 0; i < iters; ++i)
+ *           doNotOptimize(std::find(v.begin(), v.end(), target));
+ *   });
+ *   return suite.run(BenchmarkOptions::parse(argc, argv));
+ *
+ * 运行一个基准的步骤：
+ * - 校准：iterations从1开始按上一次的耗时放大（每次2到10倍），直到一次采样不少于minSampleMs，校准过程同时充当预热
+ * - 再预热warmup次，然后采样repeats次，每次记录每次迭代的纳秒数
+ * - 剔除离群值：与中位数的距离超过outlierK倍MAD（中位数绝对偏差，乘1.4826换算成正态分布的标准差）的样本丢弃，
+ *   调度、缺页、频率变化造成的个别慢样本不影响结果
+ * - 报告保留样本的中位数、均值、标准差和最小值；与基线比较用的是中位数
+ *
+ * 与基线比较：当前中位数 > 基线中位数 * (1 + threshold)时判为退化，run()返回1；参数或文件错误返回2；否则返回0。
+ * 基线就是之前某次运行用--json写出的文件，只在同一台机器、同样的构建配置下比较才有意义
+ */
+
+/* 阻止编译器把结果没有被使用的计算优化掉 */
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+/* 阻止编译器把对内存的写入合并或者推迟到计时之外 */
+inline void clobberMemory() {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#endif
+}
+
+struct BenchmarkOptions {
+    int warmup = 2;
+    int repeats = 15;
+    double minSampleMs = 20;
+    /* 0表示不剔除；否则至少为1，保证与中位数距离不超过MAD的那一半样本总能保留下来 */
+    double outlierK = 3;
+    /* 退化判定的相对阈值，0.10表示慢10%以上 */
+    double threshold = 0.10;
+    /* 只运行名字包含filter的基准 */
+    std::string filter;
+    std::string jsonPath;
+    std::string baselinePath;
+    bool list = false;
+    /* 参数有误时为false，run()直接返回2 */
+    bool valid = true;
+
+    /**
+     * --warmup=N --repeats=N --min-time-ms=X --outlier-k=X --threshold=X --filter=S --json=PATH --baseline=PATH --list
+     */
+    static BenchmarkOptions parse(int argc, char* argv[]) {
+        BenchmarkOptions o;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            std::string key = arg.substr(0, arg.find('='));
+            std::string value = arg.find('=') == std::string::npos ? "" : arg.substr(arg.find('=') + 1);
+            if (key == "--warmup")
+                o.warmup = std::atoi(value.c_str());
+            else if (key == "--repeats")
+                o.repeats = std::max(1, std::atoi(value.c_str()));
+            else if (key == "--min-time-ms")
+                o.minSampleMs = std::atof(value.c_str());
+            else if (key == "--outlier-k")
+                o.outlierK = std::atof(value.c_str());
+            else if (key == "--threshold")
+                o.threshold = std::atof(value.c_str());
+            else if (key == "--filter")
+                o.filter = value;
+            else if (key == "--json")
+                o.jsonPath = value;
+            else if (key == "--baseline")
+                o.baselinePath = value;
+            else if (key == "--list")
+                o.list = true;
+            else {
+                std::cerr << "unknown option " << arg << "\n"
+                          << "usage: " << argv[0] << " [--filter=S] [--warmup=N] [--repeats=N] [--min-time-ms=X]"
+                          << " [--outlier-k=X] [--json=PATH] [--baseline=PATH] [--threshold=X] [--list]" << std::endl;
+                o.valid = false;
+            }
+        }
+        if (o.outlierK != 0 && !(o.outlierK >= 1)) {
+            std::cerr << "--outlier-k must be 0 (keep every sample) or at least 1" << std::endl;
+            o.valid = false;
+        }
+        return o;
+    }
+};
+
+struct BenchmarkResult {
+    std::string name;
+    std::size_t iterations = 0;
+    std::size_t samples = 0;
+    std::size_t rejected = 0;
+    double medianNs = 0;
+    double meanNs = 0;
+    double stddevNs = 0;
+    double minNs = 0;
+};
+
+namespace detail {
+
+inline double medianOf(std::vector<double> v) {
+    if (v.empty())
+        return 0;
+    std::size_t mid = v.size() / 2;
+    std::nth_element(v.begin(), v.begin() + mid, v.end());
+    double m = v[mid];
+    if (v.size() % 2 == 0)
+        m = (m + *std::max_element(v.begin(), v.begin() + mid)) / 2;
+    return m;
+}
+
+/* 去掉离群值后统计，samples是每次迭代的纳秒数 */
+inline void summarize(const std::vector<double>& samples, double outlierK, BenchmarkResult& r) {
+    double median = medianOf(samples);
+    std::vector<double> dev;
+    dev.reserve(samples.size());
+    for (double s : samples)
+        dev.push_back(std::abs(s - median));
+    double limit = outlierK * 1.4826 * medianOf(dev);
+
+    std::vector<double> kept;
+    for (double s : samples)
+        if (limit == 0 || std::abs(s - median) <= limit)
+            kept.push_back(s);
+    /* outlierK < 1时可能全部被剔除，此时保留全部样本 */
+    if (kept.empty())
+        kept = samples;
+    r.samples = kept.size();
+    r.rejected = samples.size() - kept.size();
+    r.medianNs = medianOf(kept);
+    r.minNs = *std::min_element(kept.begin(), kept.end());
+    double sum = 0;
+    for (double s : kept)
+        sum += s;
+    r.meanNs = sum / kept.size();
+    double var = 0;
+    for (double s : kept)
+        var += (s - r.meanNs) * (s - r.meanNs);
+    r.stddevNs = kept.size() > 1 ? std::sqrt(var / (kept.size() - 1)) : 0;
+}
+
+inline std::string jsonEscape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+/*
+ * 只读取这里写出的格式：{"benchmarks": [{"name": "...", "median_ns": ..., ...}, ...]}。
+ * 按顺序找"name"后面的字符串和"median_ns"后面的数字，不是通用的JSON解析器
+ */
+inline bool readBaseline(const std::string& path, std::vector<std::pair<std::string, double>>& out) {
+    std::ifstream in(path);
+    if (!in)
+        return false;
+    std::stringstream ss;
+    ss << in.rdbuf();
+    const std::string text = ss.str();
+
+    auto readString = [&](std::size_t& pos, std::string& s) {
+        pos = text.find('"', pos);
+        if (pos == std::string::npos)
+            return false;
+        for (++pos; pos < text.size() && text[pos] != '"'; ++pos) {
+            if (text[pos] == '\\' && pos + 1 < text.size()) {
+                ++pos;
+                if (text[pos] == 'u' && pos + 4 < text.size()) {
+                    s += static_cast<char>(std::strtol(text.substr(pos + 1, 4).c_str(), nullptr, 16));
+                    pos += 4;
+                    continue;
+                }
+            }
+            s += text[pos];
+        }
+        ++pos;
+        return true;
+    };
+
+    std::size_t pos = 0;
+    while ((pos = text.find("\"name\"", pos)) != std::string::npos) {
+        pos = text.find(':', pos + 6);
+        std::string name;
+        if (pos == std::string::npos || !readString(pos, name))
+            return false;
+        std::size_t m = text.find("\"median_ns\"", pos);
+        if (m == std::string::npos)
+            return false;
+        m = text.find(':', m);
+        out.emplace_back(name, std::strtod(text.c_str() + m + 1, nullptr));
+        pos = m;
+    }
+    return true;
+}
+
+} // namespace detail
+
+class BenchmarkSuite {
+public:
+    using Function = std::function<void(std::size_t)>;
+
+    void add(std::string name, Function f) { benchmarks.emplace_back(std::move(name), std::move(f)); }
+
+    /**
+     * 运行所有（或者名字匹配filter的）基准，打印结果，按需写JSON并与基线比较，返回进程退出码
+     */
+    int run(const BenchmarkOptions& options) {
+        if (!options.valid)
+            return 2;
+        if (options.list) {
+            for (const auto& b : benchmarks)
+                std::cout << b.first << std::endl;
+            return 0;
+        }
+
+        std::vector<std::pair<std::string, double>> baseline;
+        if (!options.baselinePath.empty() && !detail::readBaseline(options.baselinePath, baseline)) {
+            std::cerr << "cannot read baseline " << options.baselinePath << std::endl;
+            return 2;
+        }
+
+        std::vector<BenchmarkResult> results;
+        char line[256];
+        std::snprintf(line, sizeof(line), "%-48s %12s %12s %10s %12s %8s", "benchmark", "median ns", "mean ns",
+                      "stddev %", "iterations", "dropped");
+        std::cout << line << std::endl;
+        for (const auto& b : benchmarks) {
+            if (b.first.find(options.filter) == std::string::npos)
+                continue;
+            BenchmarkResult r = runOne(b.first, b.second, options);
+            std::snprintf(line, sizeof(line), "%-48s %12.2f %12.2f %10.1f %12zu %5zu/%zu", r.name.c_str(),
+                          r.medianNs, r.meanNs, r.meanNs > 0 ? 100 * r.stddevNs / r.meanNs : 0.0, r.iterations,
+                          r.rejected, r.rejected + r.samples);
+            std::cout << line << std::endl;
+            results.push_back(r);
+        }
+
+        if (!options.jsonPath.empty() && !writeJson(options.jsonPath, options, results)) {
+            std::cerr << "cannot write " << options.jsonPath << std::endl;
+            return 2;
+        }
+        return options.baselinePath.empty() ? 0 : compare(results, baseline, options.threshold);
+    }
+
+private:
+    static double sampleNs(const Function& f, std::size_t iterations) {
+        auto start = std::chrono::steady_clock::now();
+        f(iterations);
+        clobberMemory();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    static BenchmarkResult runOne(const std::string& name, const Function& f, const BenchmarkOptions& options) {
+        BenchmarkResult r;
+        r.name = name;
+        std::size_t iterations = 1;
+        const double minNs = options.minSampleMs * 1e6;
+        for (;;) {
+            double ns = sampleNs(f, iterations);
+            if (ns >= minNs || iterations >= (std::size_t(1) << 40))
+                break;
+            /* 按这次的耗时估计需要的次数，最多翻10倍，避免第一次太快时估计过头 */
+            double scale = ns <= 0 ? 10 : std::min(10.0, std::max(2.0, 1.2 * minNs / ns));
+            iterations = static_cast<std::size_t>(static_cast<double>(iterations) * scale);
+        }
+        for (int i = 0; i < options.warmup; ++i)
+            sampleNs(f, iterations);
+
+        std::vector<double> samples;
+        for (int i = 0; i < options.repeats; ++i)
+            samples.push_back(sampleNs(f, iterations) / static_cast<double>(iterations));
+        r.iterations = iterations;
+        detail::summarize(samples, options.outlierK, r);
+        return r;
+    }
+
+    static bool writeJson(const std::string& path, const BenchmarkOptions& options,
+                          const std::vector<BenchmarkResult>& results) {
+        std::ofstream out(path);
+        if (!out)
+            return false;
+        out << "{\n  \"warmup\": " << options.warmup << ",\n  \"repeats\": " << options.repeats
+            << ",\n  \"min_sample_ms\": " << options.minSampleMs << ",\n  \"benchmarks\": [\n";
+        out.precision(17);
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            const BenchmarkResult& r = results[i];
+            out << "    {\"name\": \"" << detail::jsonEscape(r.name) << "\", \"median_ns\": " << r.medianNs
+                << ", \"mean_ns\": " << r.meanNs << ", \"stddev_ns\": " << r.stddevNs << ", \"min_ns\": " << r.minNs
+                << ", \"iterations\": " << r.iterations << ", \"samples\": " << r.samples
+                << ", \"rejected\": " << r.rejected << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+        return static_cast<bool>(out);
+    }
+
+    static int compare(const std::vector<BenchmarkResult>& results,
+                       const std::vector<std::pair<std::string, double>>& baseline, double threshold) {
+        std::cout << "\ncomparison against baseline (threshold +" << threshold * 100 << "%)" << std::endl;
+        int regressions = 0;
+        char line[256];
+        for (const auto& r : results) {
+            auto it = std::find_if(baseline.begin(), baseline.end(),
+                                   [&](const std::pair<std::string, double>& b) { return b.first == r.name; });
+            if (it == baseline.end()) {
+                std::snprintf(line, sizeof(line), "%-48s %12s", r.name.c_str(), "new");
+                std::cout << line << std::endl;
+                continue;
+            }
+            double change = it->second > 0 ? r.medianNs / it->second - 1 : 0;
+            bool regressed = change > threshold;
+            regressions += regressed;
+            std::snprintf(line, sizeof(line), "%-48s %12.2f -> %12.2f %+8.1f%%%s", r.name.c_str(), it->second,
+                          r.medianNs, change * 100, regressed ? "  REGRESSION" : "");
+            std::cout << line << std::endl;
+        }
+        if (regressions > 0)
+            std::cout << regressions << " benchmark(s) regressed" << std::endl;
+        return regressions > 0 ? 1 : 0;
+    }
+
+    std::vector<std::pair<std::string, Function>> benchmarks;
+};
@@ -0,0 +1,576 @@
+/**
+ * @file Benchmarks.cpp
+ * @brief 各个Item中性能相关写法的统一基准，可以写出JSON并与基线比较，发现性能退化
+ * @date 2026/10/18
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Benchmark.h"
+#include "BatchInsert.h"
+#include "ConcurrentHashMap.h"
+#include "ConcurrentSkipList.h"
+#include "ConstexprMath.h"
+#include "Drain.h"
+#include "GapBuffer.h"
+#include "GatherAccess.h"
+#include "IndirectSort.h"
+#include "Item14ErrorPaths.h"
+#include "PointCloud.h"
+#include "SimdFind.h"
+#include "StaticKdTree.h"
+#include "StaticPow.h"
+
+/*
+ * 用法：
+ *   benchmarks                                  运行全部基准
+ *   benchmarks --filter=item13                  只运行名字包含item13的
+ *   benchmarks --json=current.json              保存结果
+ *   benchmarks --baseline=baseline.json --threshold=0.15
+ *                                               与之前保存的结果比较，任何基准的中位数慢15%以上时退出码为1
+ *
+ * 基准的名字是"itemN/场景/写法"，同一场景下的几种写法可以直接对比；
+ * 每个基准的数据在注册之前准备好，被测代码只包含各Item里讨论的那部分
+ */
+
+namespace {
+
+std::vector<std::string> makeStrings(std::size_t n) {
+    std::vector<std::string> v;
+    v.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+        v.push_back(std::string(40, 'a' + static_cast<char>(i % 26)));
+    return v;
+}
+
+template <typename Container, typename Index>
+decltype(auto) authAndAccessRV14(Container&& c, Index i) {
+    return std::forward<Container>(c)[i];
+}
+
+/* ---------------- Item3：从右值容器取元素，按一批下标访问 ---------------- */
+
+void addItem3(BenchmarkSuite& suite) {
+    auto source = std::make_shared<std::vector<std::string>>(makeStrings(1000));
+    suite.add("item3/take-all/authAndAccessRV14 loop", [source](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            auto c = *source;
+            std::vector<std::string> out;
+            out.reserve(c.size());
+            for (std::size_t i = 0; i < c.size(); ++i)
+                out.push_back(authAndAccessRV14(std::move(c), i));
+            doNotOptimize(out.data());
+        }
+    });
+    suite.add("item3/take-all/drainAll", [source](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            auto c = *source;
+            std::vector<std::string> out;
+            out.reserve(c.size());
+            drainAll(std::move(c), std::back_inserter(out));
+            doNotOptimize(out.data());
+        }
+    });
+
+    struct GatherData {
+        std::vector<int> table;
+        std::vector<std::uint32_t> idx;
+        std::vector<int> out;
+    };
+    auto g = std::make_shared<GatherData>();
+    std::mt19937 rng(3);
+    g->table.resize(1 << 14);
+    std::iota(g->table.begin(), g->table.end(), 0);
+    for (int i = 0; i < (1 << 16); ++i)
+        g->idx.push_back(static_cast<std::uint32_t>(rng() % g->table.size()));
+    g->out.resize(g->idx.size());
+    suite.add("item3/gather/checked single access", [g](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            for (std::size_t k = 0; k < g->idx.size(); ++k) {
+                if (g->idx[k] >= g->table.size())
+                    throw std::out_of_range("index out of range");
+                g->out[k] = g->table[g->idx[k]];
+            }
+            doNotOptimize(g->out.data());
+        }
+    });
+    suite.add("item3/gather/authAndAccessBatch", [g](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            authAndAccessBatch(g->table, g->idx).gather(g->out.data());
+            doNotOptimize(g->out.data());
+        }
+    });
+}
+
+/* ---------------- Item5：auto与显式型别、std::function与闭包 ---------------- */
+
+void addItem5(BenchmarkSuite& suite) {
+    auto m = std::make_shared<std::unordered_map<std::string, int>>();
+    for (int i = 0; i < 10000; ++i)
+        m->emplace(std::string(32, 'k') + std::to_string(i), i);
+    suite.add("item5/map-loop/explicit std::pair<std::string,int>", [m](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            std::size_t sum = 0;
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#   pragma GCC diagnostic push
+#   pragma GCC diagnostic ignored "-Wrange-loop-construct"
+#endif
+            /* 故意的写法：每个元素拷贝出一个临时pair */
+            for (const std::pair<std::string, int>& p : *m)
+                sum += p.first.size() + static_cast<std::size_t>(p.second);
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#   pragma GCC diagnostic pop
+#endif
+            doNotOptimize(sum);
+        }
+    });
+    suite.add("item5/map-loop/auto", [m](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            std::size_t sum = 0;
+            for (const auto& p : *m)
+                sum += p.first.size() + static_cast<std::size_t>(p.second);
+            doNotOptimize(sum);
+        }
+    });
+
+    /* 每次迭代先恢复同样的乱序，三种写法付出相同的打乱代价 */
+    auto pointers = std::make_shared<std::vector<std::unique_ptr<int>>>();
+    std::mt19937 rng(5);
+    for (int i = 0; i < 10000; ++i)
+        pointers->emplace_back(new int(static_cast<int>(rng() % 1000000)));
+    auto sortWith = [pointers](auto comp) {
+        return [pointers, comp](std::size_t iters) {
+            for (std::size_t it = 0; it < iters; ++it) {
+                std::shuffle(pointers->begin(), pointers->end(), std::mt19937(7));
+                comp(*pointers);
+            }
+        };
+    };
+    auto derefUPLess = [](const std::unique_ptr<int>& p1, const std::unique_ptr<int>& p2) { return *p1 < *p2; };
+    std::function<bool(const std::unique_ptr<int>&, const std::unique_ptr<int>&)> derefUPLessF = derefUPLess;
+    suite.add("item5/sort/std::function", sortWith([derefUPLessF](std::vector<std::unique_ptr<int>>& v) {
+        std::sort(v.begin(), v.end(), derefUPLessF);
+    }));
+    suite.add("item5/sort/auto closure", sortWith([derefUPLess](std::vector<std::unique_ptr<int>>& v) {
+        std::sort(v.begin(), v.end(), derefUPLess);
+    }));
+    suite.add("item5/sort/indirectSort", sortWith([](std::vector<std::unique_ptr<int>>& v) {
+        indirectSort(v.begin(), v.end(), DerefLess());
+    }));
+
+    /* 单线程下两种计数器的基本开销，多线程的伸缩性见Item5 */
+    auto keys = std::make_shared<std::vector<std::string>>();
+    for (int i = 0; i < 1000; ++i)
+        keys->push_back("counter/" + std::to_string(i));
+    struct LockedCounters {
+        std::mutex m;
+        std::unordered_map<std::string, int> map;
+    };
+    auto locked = std::make_shared<LockedCounters>();
+    auto sharded = std::make_shared<ConcurrentHashMap<std::string, int>>();
+    suite.add("item5/counters/unordered_map + mutex", [keys, locked](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            for (const auto& k : *keys) {
+                std::lock_guard<std::mutex> g(locked->m);
+                ++locked->map[k];
+            }
+        }
+    });
+    suite.add("item5/counters/ConcurrentHashMap", [keys, sharded](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it)
+            for (const auto& k : *keys)
+                sharded->fetchAdd(k, 1);
+    });
+}
+
+/* ---------------- Item6：代理类型 ---------------- */
+
+void addItem6(BenchmarkSuite& suite) {
+    const std::size_t n = 1 << 20;
+    auto bits = std::make_shared<std::vector<bool>>(n);
+    auto bytes = std::make_shared<std::vector<char>>(n);
+    std::mt19937 rng(6);
+    for (std::size_t i = 0; i < n; ++i)
+        (*bytes)[i] = (*bits)[i] = (rng() & 1) != 0;
+    suite.add("item6/count/std::vector<bool> auto proxy", [bits](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            std::size_t c = 0;
+            for (std::size_t i = 0; i < bits->size(); ++i) {
+                auto b = (*bits)[i];
+                c += b;
+            }
+            doNotOptimize(c);
+        }
+    });
+    suite.add("item6/count/std::vector<char>", [bytes](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            std::size_t c = 0;
+            for (char b : *bytes)
+                c += b != 0;
+            doNotOptimize(c);
+        }
+    });
+}
+
+/* ---------------- Item8：lockAndCall ---------------- */
+
+struct Widget {
+    int a;
+};
+
+using MuxGuard = std::lock_guard<std::mutex>;
+
+template <typename FuncType, typename MuxType, typename PtrType>
+auto lockAndCall(FuncType func, MuxType& mutex, PtrType ptr) -> decltype(func(ptr)) {
+    MuxGuard g(mutex);
+    return func(ptr);
+}
+
+bool f3(Widget* pw) {
+    return pw == nullptr || pw->a > 0;
+}
+
+void addItem8(BenchmarkSuite& suite) {
+    auto m = std::make_shared<std::mutex>();
+    suite.add("item8/call/direct", [](std::size_t iters) {
+        Widget w{1};
+        Widget* pw = &w;
+        for (std::size_t it = 0; it < iters; ++it) {
+            doNotOptimize(pw);
+            doNotOptimize(f3(pw));
+        }
+    });
+    suite.add("item8/call/lockAndCall", [m](std::size_t iters) {
+        Widget w{1};
+        Widget* pw = &w;
+        for (std::size_t it = 0; it < iters; ++it) {
+            doNotOptimize(pw);
+            doNotOptimize(lockAndCall(f3, *m, pw));
+        }
+    });
+}
+
+/* ---------------- Item13：查找、查找后插入、并发容器 ---------------- */
+
+void addItem13(BenchmarkSuite& suite) {
+    auto v = std::make_shared<std::vector<int>>(1 << 16);
+    std::iota(v->begin(), v->end(), 1);
+    const int target = static_cast<int>(v->size());
+    suite.add("item13/find/std::find", [v, target](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            int t = target;
+            doNotOptimize(t);
+            doNotOptimize(std::find(v->cbegin(), v->cend(), t));
+        }
+    });
+    suite.add("item13/find/simdFind", [v, target](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            int t = target;
+            doNotOptimize(t);
+            doNotOptimize(simdFind(v->data(), v->data() + v->size(), t));
+        }
+    });
+
+    /* 在1万个元素中做1000次findAndInsert */
+    auto ops = std::make_shared<std::vector<std::pair<int, int>>>();
+    std::mt19937 rng(13);
+    for (int i = 0; i < 1000; ++i)
+        ops->emplace_back(static_cast<int>(rng() % 20000), static_cast<int>(rng() % 20000));
+    auto base = std::make_shared<std::vector<int>>(10000);
+    std::iota(base->begin(), base->end(), 0);
+    suite.add("item13/find-and-insert/sequential", [base, ops](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            std::vector<int> c = *base;
+            for (const auto& op : *ops)
+                c.insert(containerFind(c, op.first), op.second);
+            doNotOptimize(c.data());
+        }
+    });
+    suite.add("item13/find-and-insert/findAndInsertBatch", [base, ops](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            std::vector<int> c = *base;
+            findAndInsertBatch(c, *ops);
+            doNotOptimize(c.data());
+        }
+    });
+
+    /* 光标附近的连续编辑 */
+    suite.add("item13/local-edits/std::vector", [](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            std::vector<int> c(100000);
+            for (int i = 0; i < 1000; ++i)
+                c.insert(c.begin() + 50000 + i, i);
+            doNotOptimize(c.data());
+        }
+    });
+    suite.add("item13/local-edits/GapBuffer", [](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            GapBuffer<int> c;
+            c.reserve(101000);
+            for (int i = 0; i < 100000; ++i)
+                c.push_back(0);
+            for (int i = 0; i < 1000; ++i)
+                c.insert(c.cbegin() + 50000 + i, i);
+            doNotOptimize(c.size());
+        }
+    });
+
+    suite.add("item13/ordered-insert/mutex+std::set", [](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            std::mutex m;
+            std::set<int> s;
+            std::mt19937 r(1);
+            for (int i = 0; i < 10000; ++i) {
+                std::lock_guard<std::mutex> lk(m);
+                s.insert(static_cast<int>(r() % 100000));
+            }
+            doNotOptimize(s.size());
+        }
+    });
+    suite.add("item13/ordered-insert/ConcurrentSkipListMap", [](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            ConcurrentSkipListMap<int, int> s;
+            std::mt19937 r(1);
+            for (int i = 0; i < 10000; ++i) {
+                int k = static_cast<int>(r() % 100000);
+                s.findOrInsert(k, k);
+            }
+            doNotOptimize(s.size());
+        }
+    });
+}
+
+/* ---------------- Item14：noexcept移动构造与vector扩容 ---------------- */
+
+struct ThrowingMove {
+    std::string s;
+    explicit ThrowingMove(std::string v) : s(std::move(v)) {}
+    ThrowingMove(const ThrowingMove&) = default;
+    /* 没有noexcept：vector扩容时为了强异常安全只能拷贝 */
+    ThrowingMove(ThrowingMove&& o) : s(std::move(o.s)) {}
+};
+
+struct NoexceptMove {
+    std::string s;
+    explicit NoexceptMove(std::string v) : s(std::move(v)) {}
+    NoexceptMove(const NoexceptMove&) = default;
+    NoexceptMove(NoexceptMove&& o) noexcept : s(std::move(o.s)) {}
+};
+
+template <typename T>
+void growVector(std::size_t iters) {
+    for (std::size_t it = 0; it < iters; ++it) {
+        std::vector<T> v;
+        for (int i = 0; i < 10000; ++i)
+            v.emplace_back(std::string(32, 'w'));
+        doNotOptimize(v.data());
+    }
+}
+
+void addItem14(BenchmarkSuite& suite) {
+    suite.add("item14/vector-growth/move without noexcept", growVector<ThrowingMove>);
+    suite.add("item14/vector-growth/noexcept move", growVector<NoexceptMove>);
+    /* 10%的输入非法：异常每次抛出都要分配异常对象并展开，Expected只是一次返回 */
+    auto inputs = std::make_shared<std::vector<std::string>>();
+    for (int i = 0; i < 1000; ++i)
+        inputs->push_back(i % 10 == 0 ? std::string("12a4") : std::to_string(1 + i * 997 % 1000000));
+    suite.add("item14/parse-10%-errors/exceptions", [inputs](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            long long sum = 0;
+            for (const auto& s : *inputs) {
+                try {
+                    sum += viaExceptions::score(s.c_str());
+                } catch (const ParseFailure&) {
+                    --sum;
+                }
+            }
+            doNotOptimize(sum);
+        }
+    });
+    suite.add("item14/parse-10%-errors/Expected", [inputs](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            long long sum = 0;
+            for (const auto& s : *inputs)
+                sum += viaExpected::score(s.c_str()).valueOr(-1);
+            doNotOptimize(sum);
+        }
+    });
+}
+
+/* ---------------- Item15：constexpr ---------------- */
+
+class Point {
+public:
+    constexpr Point(double xVal = 0, double yVal = 0) noexcept : x(xVal), y(yVal) {}
+
+    constexpr double xValue() const noexcept { return x; }
+    constexpr double yValue() const noexcept { return y; }
+    void setX(double newX) noexcept { x = newX; }
+    void setY(double newY) noexcept { y = newY; }
+
+private:
+    double x, y;
+};
+
+void addItem15(BenchmarkSuite& suite) {
+    auto exps = std::make_shared<std::vector<unsigned>>();
+    std::mt19937 rng(15);
+    for (int i = 0; i < 4096; ++i)
+        exps->push_back(rng() % 20);
+    suite.add("item15/pow10/ipow", [exps](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            std::uint64_t sum = 0;
+            for (unsigned e : *exps)
+                sum += ipow<std::uint64_t>(10, e);
+            doNotOptimize(sum);
+        }
+    });
+    suite.add("item15/pow10/constexpr table", [exps](std::size_t iters) {
+        const auto& table = StaticTable<PowerOf<std::uint64_t, 10>, 20>::value;
+        for (std::size_t it = 0; it < iters; ++it) {
+            std::uint64_t sum = 0;
+            for (unsigned e : *exps)
+                sum += table[e];
+            doNotOptimize(sum);
+        }
+    });
+
+    auto xs = std::make_shared<std::vector<double>>(4096);
+    for (auto& x : *xs)
+        x = 1.0 + (rng() % 1000) / 1000.0;
+    suite.add("item15/pow13/std::pow", [xs](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            double sum = 0;
+            for (double x : *xs)
+                sum += std::pow(x, 13);
+            doNotOptimize(sum);
+        }
+    });
+    suite.add("item15/pow13/pow<13>", [xs](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            double sum = 0;
+            for (double x : *xs)
+                sum += pow<13>(x);
+            doNotOptimize(sum);
+        }
+    });
+
+    auto aos = std::make_shared<std::vector<Point>>();
+    auto soa = std::make_shared<PointCloud<Point>>();
+    for (int i = 0; i < 65536; ++i) {
+        Point p((rng() % 100000) / 100.0, (rng() % 100000) / 100.0);
+        aos->push_back(p);
+        soa->push_back(p);
+    }
+    suite.add("item15/translate/std::vector<Point>", [aos](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            for (auto& p : *aos) {
+                p.setX(p.xValue() + 0.5);
+                p.setY(p.yValue() - 0.5);
+            }
+            doNotOptimize(aos->data());
+        }
+    });
+    suite.add("item15/translate/PointCloud", [soa](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it) {
+            soa->translate(0.5, -0.5);
+            doNotOptimize(soa->xData());
+        }
+    });
+
+    std::array<Point, 1024> pts;
+    for (auto& p : pts)
+        p = Point((rng() % 100000) / 100.0, (rng() % 100000) / 100.0);
+    auto tree = std::make_shared<StaticKdTree<Point, 1024>>(pts);
+    auto cloud = std::make_shared<PointCloud<Point>>();
+    for (const auto& p : pts)
+        cloud->push_back(p);
+    auto queries = std::make_shared<std::vector<Point>>();
+    for (int i = 0; i < 256; ++i)
+        queries->emplace_back((rng() % 100000) / 100.0, (rng() % 100000) / 100.0);
+    suite.add("item15/nearest/PointCloud scan", [cloud, queries](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it)
+            for (const auto& q : *queries)
+                doNotOptimize(cloud->nearest(q));
+    });
+    suite.add("item15/nearest/StaticKdTree", [tree, queries](std::size_t iters) {
+        for (std::size_t it = 0; it < iters; ++it)
+            for (const auto& q : *queries)
+                doNotOptimize(tree->nearest(q));
+    });
+}
+
+/* ---------------- Item39：一次性事件通知的往返 ---------------- */
+
+void addItem39(BenchmarkSuite& suite) {
+    /* 反应线程等待通知后回应一次，一次迭代是一次往返 */
+    suite.add("item39/round-trip/condition variable + flag", [](std::size_t iters) {
+        std::mutex m;
+        std::condition_variable cv;
+        std::size_t sent = 0, acked = 0;
+        std::thread react([&] {
+            std::unique_lock<std::mutex> lk(m);
+            for (std::size_t i = 1; i <= iters; ++i) {
+                cv.wait(lk, [&] { return sent == i; });
+                acked = i;
+                cv.notify_all();
+            }
+        });
+        std::unique_lock<std::mutex> lk(m);
+        for (std::size_t i = 1; i <= iters; ++i) {
+            sent = i;
+            cv.notify_all();
+            cv.wait(lk, [&] { return acked == i; });
+        }
+        lk.unlock();
+        react.join();
+    });
+    suite.add("item39/round-trip/std::promise<void>", [](std::size_t iters) {
+        /* 每次通知都需要新的promise/future，共享状态在堆上分配 */
+        std::vector<std::promise<void>> ping(iters), pong(iters);
+        std::thread react([&] {
+            for (std::size_t i = 0; i < iters; ++i) {
+                ping[i].get_future().wait();
+                pong[i].set_value();
+            }
+        });
+        for (std::size_t i = 0; i < iters; ++i) {
+            ping[i].set_value();
+            pong[i].get_future().wait();
+        }
+        react.join();
+    });
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchmarkSuite suite;
+    addItem3(suite);
+    addItem5(suite);
+    addItem6(suite);
+    addItem8(suite);
+    addItem13(suite);
+    addItem14(suite);
+    addItem15(suite);
+    addItem39(suite);
+    return suite.run(BenchmarkOptions::parse(argc, argv));
+}
@@ -0,0 +1,390 @@
+/**
+ * @file ConcurrentHashMap.h
+ * @brief 分片的并发哈希表：读不加锁，按分片加锁的原子upsert/fetchAdd，按分片快照一致的遍历
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Allocator.h"
+#include "EpochReclaimer.h"
+
+/*
+ * 多个线程共用一个std::unordered_map<std::string, int>时，只能像Item8的lockAndCall那样用一把全局互斥锁保护，
+ * 所有计数器的更新都被串行化。ConcurrentHashMap把键按哈希值分到若干个分片：
+ * - 每个分片一把互斥锁、一个开放寻址（线性探测）的槽数组，分片按缓存行对齐，不同分片的锁和计数不会伪共享
+ * - 读（find/contains）不加锁：槽里保存哈希值和指向元素的指针，元素和槽数组都通过EpochReclaimer延迟释放，
+ *   读线程在EpochGuard中可以放心地解引用。元素的键创建后不再改变，值是std::atomic<V>
+ * - 写（upsert/fetchAdd/findOrInsert/erase）只锁一个分片，并且把分片的序号（seqlock）在修改前后各加一
+ * - 遍历按分片进行：先不加锁地复制整个分片，序号前后不变（且为偶数）就说明复制期间没有写入，得到的是这个分片
+ *   在某一时刻的快照；反复失败时退回加锁复制。不同分片的快照不是同一时刻的
+ * - 删除在槽里留下墓碑，插入只使用空槽，墓碑在扩容时清理；因此槽一旦写入哈希值就不再改变
+ *
+ * V必须是可以放进std::atomic的平凡可复制类型（计数器、标志、指针等）
+ */
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+class ConcurrentHashMap {
+    static_assert(std::is_trivially_copyable<V>::value, "ConcurrentHashMap stores values in std::atomic<V>");
+
+public:
+    static constexpr std::size_t CacheLineSize = 64;
+
+    explicit ConcurrentHashMap(std::size_t shards = defaultShardCount(), Hash hash = Hash(),
+                               KeyEqual equal = KeyEqual())
+    : hash(hash), equal(equal) {
+        shardBits = 0;
+        while ((std::size_t(1) << shardBits) < shards)
+            ++shardBits;
+        nShards = std::size_t(1) << shardBits;
+        shardArray = static_cast<Shard*>(detail::alignedNew(nShards * sizeof(Shard), alignof(Shard)));
+        for (std::size_t i = 0; i < nShards; ++i)
+            ::new (static_cast<void*>(shardArray + i)) Shard;
+    }
+
+    ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+    ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+
+    /* 析构时要求没有其他线程在访问 */
+    ~ConcurrentHashMap() {
+        for (std::size_t i = 0; i < nShards; ++i) {
+            Table* t = shardArray[i].table.load(std::memory_order_relaxed);
+            if (t != nullptr) {
+                for (std::size_t k = 0; k <= t->mask; ++k) {
+                    Entry* e = t->slots[k].entry.load(std::memory_order_relaxed);
+                    if (e != nullptr && e != tombstone())
+                        delete e;
+                }
+                delete t;
+            }
+            shardArray[i].~Shard();
+        }
+        detail::alignedDelete(shardArray, alignof(Shard));
+    }
+
+    /**
+     * 查找key，找到时把值复制到out。不加锁
+     */
+    bool find(const K& key, V& out) const {
+        EpochGuard guard;
+        std::uint64_t h = hashOf(key);
+        Entry* e = lookup(shardOf(h).table.load(std::memory_order_acquire), h, key);
+        if (e == nullptr)
+            return false;
+        out = e->value.load(std::memory_order_acquire);
+        return true;
+    }
+
+    bool contains(const K& key) const {
+        EpochGuard guard;
+        std::uint64_t h = hashOf(key);
+        return lookup(shardOf(h).table.load(std::memory_order_acquire), h, key) != nullptr;
+    }
+
+    /**
+     * 原子的"查找，找不到就插入"：返回key对应的值以及是否由本次调用插入
+     */
+    std::pair<V, bool> findOrInsert(const K& key, const V& value) {
+        std::uint64_t h = hashOf(key);
+        Shard& s = shardOf(h);
+        /* 已经存在时不需要加锁 */
+        {
+            EpochGuard guard;
+            if (Entry* e = lookup(s.table.load(std::memory_order_acquire), h, key))
+                return {e->value.load(std::memory_order_acquire), false};
+        }
+        std::lock_guard<std::mutex> lock(s.m);
+        WriteSection ws(s);
+        Entry* e = lookupOrInsert(s, h, key, value);
+        if (e != nullptr)
+            return {e->value.load(std::memory_order_relaxed), false};
+        return {value, true};
+    }
+
+    /**
+     * 插入或者覆盖，返回是否由本次调用插入
+     */
+    bool upsert(const K& key, const V& value) {
+        std::uint64_t h = hashOf(key);
+        Shard& s = shardOf(h);
+        std::lock_guard<std::mutex> lock(s.m);
+        WriteSection ws(s);
+        Entry* e = lookupOrInsert(s, h, key, value);
+        if (e == nullptr)
+            return true;
+        e->value.store(value, std::memory_order_release);
+        return false;
+    }
+
+    /**
+     * 原子地把key对应的值加上delta，key不存在时先插入V()，返回加之前的值
+     */
+    V fetchAdd(const K& key, V delta) {
+        std::uint64_t h = hashOf(key);
+        Shard& s = shardOf(h);
+        std::lock_guard<std::mutex> lock(s.m);
+        WriteSection ws(s);
+        Entry* e = lookupOrInsert(s, h, key, delta);
+        if (e == nullptr)
+            return V();
+        /* 写入者之间已经由分片锁互斥，读-改-写不需要原子的RMW */
+        V old = e->value.load(std::memory_order_relaxed);
+        e->value.store(static_cast<V>(old + delta), std::memory_order_release);
+        return old;
+    }
+
+    /**
+     * 删除key，返回是否由本次调用删除
+     */
+    bool erase(const K& key) {
+        std::uint64_t h = hashOf(key);
+        Shard& s = shardOf(h);
+        std::lock_guard<std::mutex> lock(s.m);
+        Table* t = s.table.load(std::memory_order_relaxed);
+        if (t == nullptr)
+            return false;
+        for (std::size_t i = h & t->mask;; i = (i + 1) & t->mask) {
+            Entry* e = t->slots[i].entry.load(std::memory_order_relaxed);
+            if (e == nullptr)
+                return false;
+            if (e != tombstone() && t->slots[i].hash.load(std::memory_order_relaxed) == h && equal(e->key, key)) {
+                WriteSection ws(s);
+                t->slots[i].entry.store(tombstone(), std::memory_order_release);
+                --s.live;
+                s.count.store(s.live, std::memory_order_relaxed);
+                EpochReclaimer::instance().retire(e);
+                return true;
+            }
+        }
+    }
+
+    /* 各分片元素数之和，并发修改时只是近似值 */
+    std::size_t size() const noexcept {
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < nShards; ++i)
+            n += shardArray[i].count.load(std::memory_order_relaxed);
+        return n;
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+
+    std::size_t shardCount() const noexcept { return nShards; }
+
+    /**
+     * 对每个元素调用f(key, value)。每个分片先取一份快照再逐个调用，f中可以修改这个map
+     */
+    template <typename F>
+    void forEach(F&& f) const {
+        std::vector<std::pair<K, V>> items;
+        for (std::size_t i = 0; i < nShards; ++i) {
+            snapshotShard(shardArray[i], items);
+            for (const auto& kv : items)
+                f(kv.first, kv.second);
+        }
+    }
+
+    /* 所有元素的副本，每个分片内部是同一时刻的 */
+    std::vector<std::pair<K, V>> snapshot() const {
+        std::vector<std::pair<K, V>> all, items;
+        for (std::size_t i = 0; i < nShards; ++i) {
+            snapshotShard(shardArray[i], items);
+            all.insert(all.end(), items.begin(), items.end());
+        }
+        return all;
+    }
+
+private:
+    static constexpr std::size_t MinCapacity = 16;
+    static constexpr int OptimisticAttempts = 8;
+
+    struct Entry {
+        Entry(const K& key, const V& value) : key(key), value(value) {}
+
+        const K key;
+        std::atomic<V> value;
+    };
+
+    struct Slot {
+        std::atomic<std::uint64_t> hash{0};
+        std::atomic<Entry*> entry{nullptr};
+    };
+
+    /* 槽数组是2的幂，扩容时整体替换，旧数组延迟释放；元素由新旧数组共享，不随数组释放 */
+    struct Table {
+        explicit Table(std::size_t capacity) : mask(capacity - 1), slots(new Slot[capacity]) {}
+        ~Table() { delete[] slots; }
+
+        Table(const Table&) = delete;
+        Table& operator=(const Table&) = delete;
+
+        std::size_t mask;
+        Slot* slots;
+    };
+
+    struct alignas(CacheLineSize) Shard {
+        mutable std::mutex m;
+        /* 奇数表示有写入者正在修改 */
+        std::atomic<std::uint64_t> seq{0};
+        std::atomic<Table*> table{nullptr};
+        std::atomic<std::size_t> count{0};
+        /* 以下两项只在持有m时访问：live是元素数，used还包括墓碑 */
+        std::size_t live = 0;
+        std::size_t used = 0;
+    };
+
+    /* 持有分片锁时，修改前后各把序号加一 */
+    class WriteSection {
+    public:
+        explicit WriteSection(Shard& s) : s(s) {
+            s.seq.store(s.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+        ~WriteSection() { s.seq.store(s.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+        WriteSection(const WriteSection&) = delete;
+        WriteSection& operator=(const WriteSection&) = delete;
+
+    private:
+        Shard& s;
+    };
+
+    static std::size_t defaultShardCount() {
+        std::size_t threads = std::thread::hardware_concurrency();
+        std::size_t n = 16;
+        while (n < threads * 4 && n < 1024)
+            n *= 2;
+        return n;
+    }
+
+    /* 墓碑：不会被解引用的哨兵指针 */
+    static Entry* tombstone() noexcept {
+        static typename std::aligned_storage<sizeof(Entry), alignof(Entry)>::type tag;
+        return reinterpret_cast<Entry*>(&tag);
+    }
+
+    /* std::hash对整数是恒等映射，再混合一次，高位选分片，低位选槽 */
+    std::uint64_t hashOf(const K& key) const {
+        std::uint64_t h = static_cast<std::uint64_t>(hash(key));
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    Shard& shardOf(std::uint64_t h) const noexcept {
+        return shardArray[shardBits == 0 ? 0 : static_cast<std::size_t>(h >> (64 - shardBits))];
+    }
+
+    Entry* lookup(const Table* t, std::uint64_t h, const K& key) const {
+        if (t == nullptr)
+            return nullptr;
+        for (std::size_t i = h & t->mask;; i = (i + 1) & t->mask) {
+            Entry* e = t->slots[i].entry.load(std::memory_order_acquire);
+            if (e == nullptr)
+                return nullptr;
+            if (e != tombstone() && t->slots[i].hash.load(std::memory_order_relaxed) == h && equal(e->key, key))
+                return e;
+        }
+    }
+
+    /* 持有分片锁：找到时返回元素，否则插入(key, value)并返回nullptr */
+    Entry* lookupOrInsert(Shard& s, std::uint64_t h, const K& key, const V& value) {
+        Table* t = s.table.load(std::memory_order_relaxed);
+        if (Entry* e = lookup(t, h, key))
+            return e;
+        /* 槽（包括墓碑）最多用一半，保证探测序列总能遇到空槽 */
+        if (t == nullptr || (s.used + 1) * 2 > t->mask + 1)
+            t = rehash(s, s.live + 1);
+        place(t, h, new Entry(key, value));
+        ++s.live;
+        ++s.used;
+        s.count.store(s.live, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    static void place(Table* t, std::uint64_t h, Entry* e) {
+        std::size_t i = h & t->mask;
+        while (t->slots[i].entry.load(std::memory_order_relaxed) != nullptr)
+            i = (i + 1) & t->mask;
+        t->slots[i].hash.store(h, std::memory_order_relaxed);
+        t->slots[i].entry.store(e, std::memory_order_release);
+    }
+
+    /* 按needed个元素重建槽数组，丢掉墓碑；旧数组交给EpochReclaimer */
+    Table* rehash(Shard& s, std::size_t needed) {
+        std::size_t capacity = MinCapacity;
+        while (capacity < needed * 4)
+            capacity *= 2;
+        Table* fresh = new Table(capacity);
+        Table* old = s.table.load(std::memory_order_relaxed);
+        if (old != nullptr) {
+            for (std::size_t k = 0; k <= old->mask; ++k) {
+                Entry* e = old->slots[k].entry.load(std::memory_order_relaxed);
+                if (e != nullptr && e != tombstone())
+                    place(fresh, old->slots[k].hash.load(std::memory_order_relaxed), e);
+            }
+        }
+        s.table.store(fresh, std::memory_order_release);
+        s.used = s.live;
+        if (old != nullptr)
+            EpochReclaimer::instance().retire(old);
+        return fresh;
+    }
+
+    static void copyTable(const Table* t, std::vector<std::pair<K, V>>& out) {
+        if (t == nullptr)
+            return;
+        for (std::size_t k = 0; k <= t->mask; ++k) {
+            Entry* e = t->slots[k].entry.load(std::memory_order_acquire);
+            if (e != nullptr && e != tombstone())
+                out.emplace_back(e->key, e->value.load(std::memory_order_relaxed));
+        }
+    }
+
+    void snapshotShard(const Shard& s, std::vector<std::pair<K, V>>& out) const {
+        EpochGuard guard;
+        for (int attempt = 0; attempt < OptimisticAttempts; ++attempt) {
+            out.clear();
+            std::uint64_t before = s.seq.load(std::memory_order_acquire);
+            if ((before & 1) != 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            copyTable(s.table.load(std::memory_order_acquire), out);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.seq.load(std::memory_order_relaxed) == before)
+                return;
+        }
+        /* 写入太频繁，加锁复制 */
+        std::lock_guard<std::mutex> lock(s.m);
+        out.clear();
+        copyTable(s.table.load(std::memory_order_relaxed), out);
+    }
+
+    Hash hash;
+    KeyEqual equal;
+    std::size_t shardBits;
+    std::size_t nShards;
+    Shard* shardArray;
+};
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+constexpr std::size_t ConcurrentHashMap<K, V, Hash, KeyEqual>::CacheLineSize;
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+constexpr std::size_t ConcurrentHashMap<K, V, Hash, KeyEqual>::MinCapacity;
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+constexpr int ConcurrentHashMap<K, V, Hash, KeyEqual>::OptimisticAttempts;
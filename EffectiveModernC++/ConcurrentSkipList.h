@@ -0,0 +1,353 @@
+/**
+ * @file ConcurrentSkipList.h
+ * @brief 无锁跳表实现的并发有序map，支持多线程的查找后插入
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <utility>
+
+#include "EpochReclaimer.h"
+
+/*
+ * 结构沿用Herlihy & Shavit的LockFreeSkipList：
+ * - 每一层都是一个Harris链表，删除时先在next指针的最低位打标记（逻辑删除），再由任何经过的线程用CAS摘除（物理删除）
+ * - 第0层的标记决定元素是否还在集合中，高层只是加速查找的索引
+ * - 插入先在第0层链接（线性化点），再自底向上链接各个高层
+ *
+ * 内存回收使用EpochReclaimer。节点只有在所有层都被摘除以后才能retire，而插入线程可能还在链接高层时，
+ * 删除线程就已经打完标记了，因此节点上有一个状态字：插入线程链接完毕、删除线程打完标记各自置一位，
+ * 后到的一方负责做最后一次清扫并retire，保证每个节点恰好retire一次，并且retire时已经不可到达。
+ *
+ * 所有操作都在EpochGuard中进行，遍历是弱一致的：能看到遍历开始前已完成的修改，但不保证看到并发进行中的修改
+ */
+template <typename K, typename V, typename Compare = std::less<K>>
+class ConcurrentSkipListMap {
+public:
+    static constexpr int MaxLevel = 24;
+
+    explicit ConcurrentSkipListMap(Compare comp = Compare()) : comp(comp) {
+        for (auto& h : head)
+            h.store(0, std::memory_order_relaxed);
+    }
+
+    ConcurrentSkipListMap(const ConcurrentSkipListMap&) = delete;
+    ConcurrentSkipListMap& operator=(const ConcurrentSkipListMap&) = delete;
+
+    /* 析构时要求没有其他线程在访问 */
+    ~ConcurrentSkipListMap() {
+        Node* n = ptr(head[0].load(std::memory_order_acquire));
+        while (n != nullptr) {
+            Node* next = ptr(n->next[0].load(std::memory_order_relaxed));
+            destroyNode(n);
+            n = next;
+        }
+    }
+
+    /**
+     * 插入(key, value)，key已经存在时返回false
+     */
+    bool insert(const K& key, const V& value) {
+        return findOrInsert(key, value).second;
+    }
+
+    /**
+     * 原子的"查找，找不到就插入"：返回key对应的值以及是否由本次调用插入。
+     * 相当于并发版本的findAndInsert，查找与插入之间不会有其他线程插入相同的key
+     */
+    std::pair<V, bool> findOrInsert(const K& key, const V& value) {
+        EpochGuard guard;
+        Node* preds[MaxLevel];
+        Node* succs[MaxLevel];
+        int level = randomLevel();
+        Node* node = nullptr;
+        while (true) {
+            if (find(key, preds, succs)) {
+                if (node != nullptr)
+                    destroyNode(node);
+                return {succs[0]->value, false};
+            }
+            if (node == nullptr)
+                node = createNode(key, value, level);
+            for (int i = 0; i < level; ++i)
+                node->next[i].store(reinterpret_cast<std::uintptr_t>(succs[i]), std::memory_order_relaxed);
+
+            /* 线性化点：在第0层链接成功 */
+            std::uintptr_t expected = reinterpret_cast<std::uintptr_t>(succs[0]);
+            if (!nextOf(preds[0], 0).compare_exchange_strong(expected, reinterpret_cast<std::uintptr_t>(node),
+                                                             std::memory_order_release, std::memory_order_relaxed))
+                continue;
+            break;
+        }
+        count.fetch_add(1, std::memory_order_relaxed);
+        V result = node->value;
+        linkUpperLevels(node, level, preds, succs);
+        return {result, true};
+    }
+
+    /**
+     * 查找key，找到时把值复制到out
+     */
+    bool find(const K& key, V& out) const {
+        EpochGuard guard;
+        Node* n = lowerBound(key);
+        if (n == nullptr || comp(key, n->key))
+            return false;
+        out = n->value;
+        return true;
+    }
+
+    bool contains(const K& key) const {
+        EpochGuard guard;
+        Node* n = lowerBound(key);
+        return n != nullptr && !comp(key, n->key);
+    }
+
+    /**
+     * 删除key，返回是否由本次调用删除
+     */
+    bool erase(const K& key) {
+        EpochGuard guard;
+        Node* preds[MaxLevel];
+        Node* succs[MaxLevel];
+        if (!find(key, preds, succs))
+            return false;
+        Node* victim = succs[0];
+        /* 自顶向下给高层打标记 */
+        for (int i = victim->level - 1; i > 0; --i) {
+            std::uintptr_t next = victim->next[i].load(std::memory_order_acquire);
+            while (!marked(next))
+                victim->next[i].compare_exchange_weak(next, next | 1, std::memory_order_acq_rel);
+        }
+        /* 第0层的标记决定谁删除成功 */
+        std::uintptr_t next = victim->next[0].load(std::memory_order_acquire);
+        while (true) {
+            if (marked(next))
+                return false;
+            if (victim->next[0].compare_exchange_weak(next, next | 1, std::memory_order_acq_rel))
+                break;
+        }
+        count.fetch_sub(1, std::memory_order_relaxed);
+        finish(victim, Deleted);
+        return true;
+    }
+
+    /**
+     * 按key的顺序遍历所有元素，f(key, value)返回false时提前结束
+     */
+    template <typename F>
+    void forEach(F&& f) const {
+        EpochGuard guard;
+        visit(ptr(head[0].load(std::memory_order_acquire)), f);
+    }
+
+    /**
+     * 从第一个不小于key的元素开始按顺序遍历
+     */
+    template <typename F>
+    void forEachFrom(const K& key, F&& f) const {
+        EpochGuard guard;
+        visit(lowerBound(key), f);
+    }
+
+    /* 并发修改时只是近似值 */
+    std::size_t size() const noexcept { return count.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr unsigned Inserted = 1;
+    static constexpr unsigned Deleted = 2;
+
+    struct Node {
+        K key;
+        V value;
+        int level;
+        std::atomic<unsigned> state;
+        std::atomic<std::uintptr_t> next[1];
+    };
+
+    static bool marked(std::uintptr_t p) noexcept { return (p & 1) != 0; }
+    static Node* ptr(std::uintptr_t p) noexcept { return reinterpret_cast<Node*>(p & ~std::uintptr_t(1)); }
+
+    /* 节点的next数组按实际层数分配 */
+    static Node* createNode(const K& key, const V& value, int level) {
+        std::size_t bytes = sizeof(Node) + (level - 1) * sizeof(std::atomic<std::uintptr_t>);
+        void* raw = ::operator new(bytes);
+        Node* n = static_cast<Node*>(raw);
+        ::new (static_cast<void*>(&n->key)) K(key);
+        try {
+            ::new (static_cast<void*>(&n->value)) V(value);
+        } catch (...) {
+            n->key.~K();
+            ::operator delete(raw);
+            throw;
+        }
+        n->level = level;
+        ::new (static_cast<void*>(&n->state)) std::atomic<unsigned>(0);
+        for (int i = 0; i < level; ++i)
+            ::new (static_cast<void*>(&n->next[i])) std::atomic<std::uintptr_t>(0);
+        return n;
+    }
+
+    static void destroyNode(void* p) {
+        Node* n = static_cast<Node*>(p);
+        n->value.~V();
+        n->key.~K();
+        ::operator delete(p);
+    }
+
+    static int randomLevel() {
+        static thread_local std::uint64_t seed =
+            0x9E3779B97F4A7C15ull ^ reinterpret_cast<std::uintptr_t>(&seed);
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        /* 每层晋升的概率是1/2 */
+        int level = 1;
+        for (std::uint64_t bits = seed; level < MaxLevel && (bits & 1) != 0; bits >>= 1)
+            ++level;
+        return level;
+    }
+
+    /* preds中的nullptr表示表头 */
+    std::atomic<std::uintptr_t>& nextOf(Node* n, int level) const {
+        return n == nullptr ? head[level] : n->next[level];
+    }
+
+    /* 在每一层找到key的前驱和后继，顺路摘除被标记的节点 */
+    bool find(const K& key, Node** preds, Node** succs) {
+    retry:
+        Node* pred = nullptr;
+        for (int level = MaxLevel - 1; level >= 0; --level) {
+            Node* curr = ptr(nextOf(pred, level).load(std::memory_order_acquire));
+            while (curr != nullptr) {
+                std::uintptr_t succ = curr->next[level].load(std::memory_order_acquire);
+                if (marked(succ)) {
+                    std::uintptr_t expected = reinterpret_cast<std::uintptr_t>(curr);
+                    if (!nextOf(pred, level).compare_exchange_strong(expected, succ & ~std::uintptr_t(1),
+                                                                     std::memory_order_acq_rel))
+                        goto retry;
+                    curr = ptr(succ);
+                    continue;
+                }
+                if (!comp(curr->key, key))
+                    break;
+                pred = curr;
+                curr = ptr(succ);
+            }
+            preds[level] = pred;
+            succs[level] = curr;
+        }
+        return succs[0] != nullptr && !comp(key, succs[0]->key);
+    }
+
+    /*
+     * 摘除每一层上所有key相等且被标记的节点。
+     * 相同key的节点可能不止一个（旧节点被删除的同时插入了新节点），因此下降时使用的前驱始终是小于key的节点，
+     * 在每一层上把等于key的一段完整扫一遍
+     */
+    void sweep(const K& key) {
+    retry:
+        Node* pred = nullptr;
+        for (int level = MaxLevel - 1; level >= 0; --level) {
+            Node* curr = ptr(nextOf(pred, level).load(std::memory_order_acquire));
+            Node* p = pred;
+            while (curr != nullptr && !comp(key, curr->key)) {
+                std::uintptr_t succ = curr->next[level].load(std::memory_order_acquire);
+                if (marked(succ)) {
+                    std::uintptr_t expected = reinterpret_cast<std::uintptr_t>(curr);
+                    if (!nextOf(p, level).compare_exchange_strong(expected, succ & ~std::uintptr_t(1),
+                                                                  std::memory_order_acq_rel))
+                        goto retry;
+                    curr = ptr(succ);
+                    continue;
+                }
+                if (comp(curr->key, key))
+                    pred = curr;
+                p = curr;
+                curr = ptr(succ);
+            }
+        }
+    }
+
+    /* 只读的查找，不摘除节点，跳过被标记的节点 */
+    Node* lowerBound(const K& key) const {
+        Node* pred = nullptr;
+        Node* curr = nullptr;
+        for (int level = MaxLevel - 1; level >= 0; --level) {
+            curr = ptr(nextOf(pred, level).load(std::memory_order_acquire));
+            while (curr != nullptr) {
+                std::uintptr_t succ = curr->next[level].load(std::memory_order_acquire);
+                if (marked(succ)) {
+                    curr = ptr(succ);
+                    continue;
+                }
+                if (!comp(curr->key, key))
+                    break;
+                pred = curr;
+                curr = ptr(succ);
+            }
+        }
+        return curr;
+    }
+
+    template <typename F>
+    void visit(Node* n, F& f) const {
+        while (n != nullptr) {
+            std::uintptr_t next = n->next[0].load(std::memory_order_acquire);
+            if (!marked(next) && !f(n->key, n->value))
+                return;
+            n = ptr(next);
+        }
+    }
+
+    void linkUpperLevels(Node* node, int level, Node** preds, Node** succs) {
+        for (int i = 1; i < level; ++i) {
+            while (true) {
+                /* 节点已经被删除，不再继续链接 */
+                std::uintptr_t own = node->next[i].load(std::memory_order_acquire);
+                if (marked(own))
+                    goto done;
+                if (own != reinterpret_cast<std::uintptr_t>(succs[i]) &&
+                    !node->next[i].compare_exchange_strong(own, reinterpret_cast<std::uintptr_t>(succs[i]),
+                                                           std::memory_order_acq_rel))
+                    goto done;
+                std::uintptr_t expected = reinterpret_cast<std::uintptr_t>(succs[i]);
+                if (nextOf(preds[i], i).compare_exchange_strong(expected, reinterpret_cast<std::uintptr_t>(node),
+                                                                std::memory_order_release, std::memory_order_relaxed))
+                    break;
+                /* 前驱变了，重新定位；如果自己已经被删除，find会把它摘掉 */
+                find(node->key, preds, succs);
+                if (succs[0] != node)
+                    goto done;
+            }
+        }
+    done:
+        finish(node, Inserted);
+    }
+
+    /* 插入线程和删除线程中后完成的一方负责清扫残留的链接并retire */
+    void finish(Node* node, unsigned who) {
+        unsigned prev = node->state.fetch_or(who, std::memory_order_acq_rel);
+        if ((prev | who) != (Inserted | Deleted))
+            return;
+        sweep(node->key);
+        EpochReclaimer::instance().retire(node, &ConcurrentSkipListMap::destroyNode);
+    }
+
+    Compare comp;
+    mutable std::atomic<std::uintptr_t> head[MaxLevel];
+    std::atomic<std::size_t> count{0};
+};
+
+template <typename K, typename V, typename Compare>
+constexpr int ConcurrentSkipListMap<K, V, Compare>::MaxLevel;
+template <typename K, typename V, typename Compare>
+constexpr unsigned ConcurrentSkipListMap<K, V, Compare>::Inserted;
+template <typename K, typename V, typename Compare>
+constexpr unsigned ConcurrentSkipListMap<K, V, Compare>::Deleted;
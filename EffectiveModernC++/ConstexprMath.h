@@ -0,0 +1,173 @@
+/**
+ * @file ConstexprMath.h
+ * @brief 平方求幂的constexpr整数幂（编译期拒绝溢出），以及在编译期填充std::array查找表的工具
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/*
+ * C++14的constexpr函数可以包含循环和局部变量，因此：
+ * - 整数幂可以用平方求幂，只需要O(log exp)次乘法，也就不会碰到递归深度的限制（GCC默认512层）
+ * - 溢出时执行throw：在常量表达式中求值到throw会导致编译错误，运行期调用则抛出std::overflow_error
+ * - 查找表由index_sequence展开成一个聚合初始化，生成函数必须是带constexpr operator()的函数对象
+ *   （C++14的lambda不能是constexpr的，std::array的非const operator[]也不是constexpr的）
+ */
+
+namespace detail {
+
+template <typename T>
+constexpr bool mulOverflows(T a, T b, std::false_type /* unsigned */) {
+    return b != 0 && a > std::numeric_limits<T>::max() / b;
+}
+
+template <typename T>
+constexpr bool mulOverflows(T a, T b, std::true_type /* signed */) {
+    constexpr T max = std::numeric_limits<T>::max();
+    constexpr T min = std::numeric_limits<T>::min();
+    if (a > 0)
+        return b > 0 ? a > max / b : b < min / a;
+    if (b > 0)
+        return a < min / b;
+    return a != 0 && b < max / a;
+}
+
+template <typename T>
+constexpr T checkedMul(T a, T b) {
+#if defined(__GNUC__)
+    /* 内建函数在常量表达式中同样可用，运行期只是一次乘法加溢出标志位检查，不需要除法 */
+    T r = 0;
+    return __builtin_mul_overflow(a, b, &r) ? throw std::overflow_error("integer power overflows") : r;
+#else
+    return mulOverflows(a, b, std::is_signed<T>()) ? throw std::overflow_error("integer power overflows") : a * b;
+#endif
+}
+
+} // namespace detail
+
+/**
+ * base的exp次幂，结果超出T的范围时抛出std::overflow_error（常量表达式中即为编译错误）
+ */
+template <typename T>
+constexpr T ipow(T base, unsigned exp) {
+    static_assert(std::is_integral<T>::value, "ipow requires an integral type");
+    T result = 1;
+    for (;;) {
+        if (exp & 1u)
+            result = detail::checkedMul(result, base);
+        exp >>= 1;
+        if (exp == 0)
+            return result;
+        base = detail::checkedMul(base, base);
+    }
+}
+
+namespace detail {
+
+template <typename F, std::size_t... I>
+constexpr auto makeTable(F f, std::index_sequence<I...>) {
+    return std::array<decltype(f(std::size_t())), sizeof...(I)>{{f(I)...}};
+}
+
+} // namespace detail
+
+/**
+ * 返回{f(0), f(1), ..., f(N - 1)}，f是constexpr时整张表在编译期生成
+ */
+template <std::size_t N, typename F>
+constexpr auto makeTable(F f) {
+    return detail::makeTable(f, std::make_index_sequence<N>());
+}
+
+/**
+ * 编译期生成的表放在静态数据区，程序中的多处使用共享同一份
+ */
+template <typename F, std::size_t N>
+struct StaticTable {
+    using Table = decltype(makeTable<N>(F()));
+    static constexpr Table value = makeTable<N>(F());
+};
+
+template <typename F, std::size_t N>
+constexpr typename StaticTable<F, N>::Table StaticTable<F, N>::value;
+
+/* ---------------- 常用的表生成函数 ---------------- */
+
+/* Base的i次幂 */
+template <typename T, T Base>
+struct PowerOf {
+    constexpr T operator()(std::size_t i) const { return ipow(Base, static_cast<unsigned>(i)); }
+};
+
+/* 按字节查表的CRC-32（反射形式，多项式0xEDB88320，与zlib相同） */
+struct Crc32Entry {
+    constexpr std::uint32_t operator()(std::size_t i) const {
+        std::uint32_t c = static_cast<std::uint32_t>(i);
+        for (int k = 0; k < 8; ++k)
+            c = (c & 1u) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        return c;
+    }
+};
+
+/* i的低Bits位逆序，FFT的位反转置换会用到 */
+template <unsigned Bits>
+struct BitReverse {
+    constexpr std::uint32_t operator()(std::size_t i) const {
+        std::uint32_t r = 0;
+        for (unsigned k = 0; k < Bits; ++k)
+            r |= static_cast<std::uint32_t>((i >> k) & 1u) << (Bits - 1 - k);
+        return r;
+    }
+};
+
+namespace detail {
+
+constexpr double Pi = 3.14159265358979323846;
+
+/* 先把x规约到[-π/2, π/2]，再用泰勒级数，误差远小于定点数的精度 */
+constexpr double constexprSin(double x) {
+    while (x > Pi)
+        x -= 2 * Pi;
+    while (x < -Pi)
+        x += 2 * Pi;
+    if (x > Pi / 2)
+        x = Pi - x;
+    else if (x < -Pi / 2)
+        x = -Pi - x;
+    double term = x, sum = x;
+    for (int n = 1; n < 12; ++n) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+} // namespace detail
+
+/* 一周分成Steps份的正弦表，Q(FracBits)定点数：sin(2πi/Steps) * 2^FracBits，四舍五入 */
+template <std::size_t Steps, unsigned FracBits>
+struct FixedSin {
+    constexpr std::int32_t operator()(std::size_t i) const {
+        double v = detail::constexprSin(2 * detail::Pi * static_cast<double>(i) / Steps) * (1 << FracBits);
+        return static_cast<std::int32_t>(v < 0 ? v - 0.5 : v + 0.5);
+    }
+};
+
+/* ---------------- 基于表的运行期函数 ---------------- */
+
+inline std::uint32_t crc32(const void* data, std::size_t len, std::uint32_t crc = 0) {
+    const auto& table = StaticTable<Crc32Entry, 256>::value;
+    auto p = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    for (std::size_t i = 0; i < len; ++i)
+        crc = table[(crc ^ p[i]) & 0xFFu] ^ (crc >> 8);
+    return ~crc;
+}
@@ -0,0 +1,491 @@
+/**
+ * @file Coroutine.h
+ * @brief C++20协程版的一次性事件通知：可等待的OneShotEvent、惰性的Task<T>、单线程与线程池调度器
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#if __cplusplus < 202002L && !(defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+#   error "Coroutine.h requires C++20, configure with -DCPPNOTE_COROUTINES=ON"
+#endif
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/*
+ * Item39中的反应任务无论用条件变量还是期值，等待期间都要占住一整个被阻塞的线程：
+ * 每个线程有自己的栈（默认预留8MB地址空间）、内核调度实体，唤醒一次要经过futex和一次上下文切换。
+ * 协程等待时只剩下一个堆上的协程帧（通常几十到几百字节），挂起的协程不占用任何线程。
+ *
+ *   Task<> react(OneShotEvent& ready, Scheduler& scheduler) {
+ *       co_await ready.wait(scheduler);   // 反应任务：挂起，不阻塞线程
+ *       ...
+ *   }
+ *
+ *   OneShotEvent ready;
+ *   SingleThreadScheduler scheduler;
+ *   scheduler.spawn(react(ready, scheduler));
+ *   ready.set();                          // 检测任务：可以在任意线程调用
+ *   scheduler.run();
+ *
+ * 协程的参数按值或按引用保存在协程帧里；lambda协程的捕获却保存在闭包对象里，
+ * 闭包临时对象在第一次挂起后就销毁了，所以反应任务要写成普通函数（或者把状态作为参数传入）
+ *
+ * - OneShotEvent相当于std::promise<void>/std::shared_future<void>：set之前的等待者挂起，set之后的等待者
+ *   不挂起直接继续，不存在条件变量那样"先通知后等待"丢失通知的问题，也没有虚假唤醒；不需要互斥锁和堆上的共享状态。
+ *   等待者链表就放在各自的协程帧里（awaiter对象），set时逐个恢复
+ * - co_await event直接在调用set的线程上恢复等待者；co_await event.wait(scheduler)把等待者交给调度器，
+ *   set只负责入队，耗时的反应不会拖住检测任务
+ * - Task<T>是惰性的：创建时不运行，被co_await时才开始，结束时通过对称转移直接恢复等待它的协程，
+ *   嵌套很深也不会耗尽栈。异常在co_await处重新抛出
+ * - Scheduler::spawn启动一个不被等待的Task<void>，异常会导致std::terminate（与std::thread相同）；
+ *   SingleThreadScheduler在调用run的线程上执行，ThreadPoolScheduler在固定数量的工作线程上执行
+ * - syncWait在普通函数里阻塞等待一个Task的结果
+ */
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+class TaskPromiseBase {
+public:
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        /* 结束时直接转到等待者，没有等待者就回到恢复它的人 */
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+            std::coroutine_handle<> next = h.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { exception = std::current_exception(); }
+
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+};
+
+template <typename T>
+class TaskPromise : public TaskPromiseBase {
+public:
+    Task<T> get_return_object() noexcept;
+
+    template <typename U>
+    void return_value(U&& v) {
+        value.emplace(std::forward<U>(v));
+    }
+
+    T result() {
+        if (exception)
+            std::rethrow_exception(exception);
+        return std::move(*value);
+    }
+
+private:
+    std::optional<T> value;
+};
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase {
+public:
+    Task<void> get_return_object() noexcept;
+
+    void return_void() const noexcept {}
+
+    void result() {
+        if (exception)
+            std::rethrow_exception(exception);
+    }
+};
+
+/* 立即开始、结束时自己销毁的协程，用来实现spawn和syncWait */
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+} // namespace detail
+
+template <typename T>
+class [[nodiscard]] Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle)
+                handle.destroy();
+            handle = std::exchange(other.handle, {});
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        if (handle)
+            handle.destroy();
+    }
+
+    bool done() const noexcept { return !handle || handle.done(); }
+
+    /* 只能co_await右值：co_await std::move(task)，结果只能取一次 */
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> h;
+
+            bool await_ready() const noexcept { return h.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                h.promise().continuation = awaiting;
+                return h;
+            }
+
+            T await_resume() { return h.promise().result(); }
+        };
+        return Awaiter{handle};
+    }
+
+private:
+    friend promise_type;
+
+    explicit Task(std::coroutine_handle<promise_type> h) noexcept : handle(h) {}
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+} // namespace detail
+
+class Scheduler;
+
+namespace detail {
+Detached runDetached(Scheduler& scheduler, Task<void> task);
+} // namespace detail
+
+/**
+ * 调度器的公共接口：post把一个就绪的协程放进队列，由具体的调度器决定在哪个线程上恢复
+ */
+class Scheduler {
+public:
+    virtual ~Scheduler() = default;
+
+    virtual void post(std::coroutine_handle<> h) = 0;
+
+    /* co_await scheduler.schedule()：挂起当前协程，之后在调度器的线程上继续 */
+    auto schedule() noexcept {
+        struct Awaiter {
+            Scheduler& scheduler;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) { scheduler.post(h); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this};
+    }
+
+    /* 在调度器上启动task，不等待它的结果 */
+    void spawn(Task<void> task);
+
+    /* 已经spawn、还没有结束的任务数 */
+    std::size_t pendingTasks() const noexcept { return pending.load(std::memory_order_acquire); }
+
+protected:
+    /* pendingTasks()降到0时调用 */
+    virtual void onIdle() noexcept {}
+
+private:
+    friend detail::Detached detail::runDetached(Scheduler&, Task<void>);
+
+    void finishTask() noexcept {
+        if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            onIdle();
+    }
+
+    std::atomic<std::size_t> pending{0};
+};
+
+namespace detail {
+
+inline Detached runDetached(Scheduler& scheduler, Task<void> task) {
+    co_await scheduler.schedule();
+    co_await std::move(task);
+    scheduler.finishTask();
+}
+
+} // namespace detail
+
+inline void Scheduler::spawn(Task<void> task) {
+    pending.fetch_add(1, std::memory_order_relaxed);
+    detail::runDetached(*this, std::move(task));
+}
+
+/**
+ * 所有协程都在调用run()的线程上执行；post可以来自任意线程
+ */
+class SingleThreadScheduler : public Scheduler {
+public:
+    void post(std::coroutine_handle<> h) override {
+        std::lock_guard<std::mutex> lock(m);
+        ready.push_back(h);
+    }
+
+    /**
+     * 依次恢复就绪的协程，直到队列为空（还在等待事件的协程不算就绪），返回恢复的次数
+     */
+    std::size_t run() {
+        std::size_t resumed = 0;
+        for (;;) {
+            std::coroutine_handle<> h;
+            {
+                std::lock_guard<std::mutex> lock(m);
+                if (ready.empty())
+                    return resumed;
+                h = ready.front();
+                ready.pop_front();
+            }
+            h.resume();
+            ++resumed;
+        }
+    }
+
+private:
+    std::mutex m;
+    std::deque<std::coroutine_handle<>> ready;
+};
+
+/**
+ * 固定数量的工作线程共享一个就绪队列。析构前应当先waitIdle()：
+ * 析构时还挂起在事件上的协程不会再被恢复
+ */
+class ThreadPoolScheduler : public Scheduler {
+public:
+    explicit ThreadPoolScheduler(std::size_t threads = std::thread::hardware_concurrency()) {
+        if (threads == 0)
+            threads = 1;
+        workers.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i)
+            workers.emplace_back([this] { work(); });
+    }
+
+    ThreadPoolScheduler(const ThreadPoolScheduler&) = delete;
+    ThreadPoolScheduler& operator=(const ThreadPoolScheduler&) = delete;
+
+    ~ThreadPoolScheduler() override {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stopping = true;
+        }
+        readyCv.notify_all();
+        for (auto& t : workers)
+            t.join();
+    }
+
+    void post(std::coroutine_handle<> h) override {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            ready.push_back(h);
+        }
+        readyCv.notify_one();
+    }
+
+    /* 阻塞到所有spawn的任务都结束 */
+    void waitIdle() {
+        std::unique_lock<std::mutex> lock(m);
+        idleCv.wait(lock, [this] { return pendingTasks() == 0; });
+    }
+
+    std::size_t threadCount() const noexcept { return workers.size(); }
+
+protected:
+    void onIdle() noexcept override {
+        std::lock_guard<std::mutex> lock(m);
+        idleCv.notify_all();
+    }
+
+private:
+    void work() {
+        for (;;) {
+            std::coroutine_handle<> h;
+            {
+                std::unique_lock<std::mutex> lock(m);
+                readyCv.wait(lock, [this] { return stopping || !ready.empty(); });
+                if (ready.empty())
+                    return;
+                h = ready.front();
+                ready.pop_front();
+            }
+            h.resume();
+        }
+    }
+
+    std::mutex m;
+    std::condition_variable readyCv;
+    std::condition_variable idleCv;
+    std::deque<std::coroutine_handle<>> ready;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
+
+/**
+ * 一次性事件，可以被任意多个协程等待，set只能生效一次（reset之后可以再用）。
+ * state为nullptr表示未触发且无人等待，为this表示已触发，否则指向等待者链表的表头
+ */
+class OneShotEvent {
+public:
+    class Awaiter {
+    public:
+        Awaiter(const OneShotEvent& event, Scheduler* scheduler) noexcept : event(event), scheduler(scheduler) {}
+
+        bool await_ready() const noexcept { return event.isSet(); }
+
+        /* 把自己压入等待者链表；压入前事件已经触发就不挂起 */
+        bool await_suspend(std::coroutine_handle<> h) noexcept {
+            handle = h;
+            void* old = event.state.load(std::memory_order_acquire);
+            do {
+                if (old == event.setState())
+                    return false;
+                next = static_cast<Awaiter*>(old);
+            } while (!event.state.compare_exchange_weak(old, this, std::memory_order_release,
+                                                        std::memory_order_acquire));
+            return true;
+        }
+
+        void await_resume() const noexcept {}
+
+    private:
+        friend class OneShotEvent;
+
+        void resume() {
+            if (scheduler != nullptr)
+                scheduler->post(handle);
+            else
+                handle.resume();
+        }
+
+        const OneShotEvent& event;
+        Scheduler* scheduler;
+        std::coroutine_handle<> handle;
+        Awaiter* next = nullptr;
+    };
+
+    OneShotEvent() noexcept = default;
+    OneShotEvent(const OneShotEvent&) = delete;
+    OneShotEvent& operator=(const OneShotEvent&) = delete;
+
+    bool isSet() const noexcept { return state.load(std::memory_order_acquire) == setState(); }
+
+    /**
+     * 触发事件并恢复所有等待者（后等待的先恢复）。重复调用没有效果
+     */
+    void set() {
+        void* old = state.exchange(setState(), std::memory_order_acq_rel);
+        if (old == setState())
+            return;
+        auto* w = static_cast<Awaiter*>(old);
+        while (w != nullptr) {
+            /* 恢复之后awaiter所在的协程帧可能已经销毁，先取next */
+            Awaiter* next = w->next;
+            w->resume();
+            w = next;
+        }
+    }
+
+    /* 回到未触发状态；有协程正在等待时调用没有效果 */
+    void reset() noexcept {
+        void* expected = setState();
+        state.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+    }
+
+    /* 在调用set()的线程上恢复 */
+    Awaiter operator co_await() const noexcept { return Awaiter(*this, nullptr); }
+
+    /* 把恢复交给scheduler */
+    Awaiter wait(Scheduler& scheduler) const noexcept { return Awaiter(*this, &scheduler); }
+
+private:
+    void* setState() const noexcept { return const_cast<OneShotEvent*>(this); }
+
+    mutable std::atomic<void*> state{nullptr};
+};
+
+namespace detail {
+
+inline Detached signalWhenDone(Task<void> task, std::exception_ptr& error, std::mutex& m,
+                               std::condition_variable& cv, bool& done) {
+    try {
+        co_await std::move(task);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    /* 持锁通知：syncWait返回后m和cv就被销毁了 */
+    std::lock_guard<std::mutex> lock(m);
+    done = true;
+    cv.notify_one();
+}
+
+template <typename T>
+Task<void> storeResult(Task<T> task, std::optional<T>& out) {
+    out.emplace(co_await std::move(task));
+}
+
+} // namespace detail
+
+/**
+ * 在当前线程上开始task，阻塞到它结束（task可能在其他线程上完成），返回结果或者重新抛出异常
+ */
+inline void syncWait(Task<void> task) {
+    std::exception_ptr error;
+    std::mutex m;
+    std::condition_variable cv;
+    bool done = false;
+    detail::signalWhenDone(std::move(task), error, m, cv, done);
+    {
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [&] { return done; });
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+template <typename T>
+T syncWait(Task<T> task) {
+    std::optional<T> out;
+    syncWait(detail::storeResult(std::move(task), out));
+    return std::move(*out);
+}
@@ -0,0 +1,90 @@
+/**
+ * @file Drain.h
+ * @brief 从右值容器中批量移出元素：一次遍历，不拷贝元素，容器的存储只释放一次
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ * authAndAccessRV14(std::move(c), i)把右值容器完美转发给operator[]，但是std::vector/std::deque/std::string
+ * 的operator[]没有右值重载，返回的仍然是左值引用，decltype(auto)推导出T&，调用方拿到结果时会拷贝一次；
+ * 想取多个元素只能对同一个"右值"反复调用，每次都拷贝。
+ *
+ * 这里的做法是让一个对象接管容器（移动构造，不拷贝元素；std::vector/std::string只转移存储的所有权，
+ * libstdc++的std::deque移动时还要为被掏空的一方分配新的map，可能抛出std::bad_alloc），
+ * 然后按下标或者整体把元素移动出去，对象析构时容器的存储只释放一次：
+ * - consume(std::move(c))返回一个拥有容器的区间，迭代器是move_iterator，可以直接用于范围for
+ * - drain(std::move(c), indices, out)按indices的顺序移出选中的元素，下标在移动任何元素之前统一检查
+ * - drainAll(std::move(c), out)移出全部元素
+ * 只接受右值，传入左值会在编译期报错，避免意外掏空调用方仍在使用的容器
+ */
+
+template <typename Container>
+class ConsumingRange {
+public:
+    using value_type = typename Container::value_type;
+    using iterator = std::move_iterator<typename Container::iterator>;
+
+    explicit ConsumingRange(Container&& c) noexcept(std::is_nothrow_move_constructible<Container>::value)
+    : c(std::move(c)) {}
+
+    iterator begin() { return std::make_move_iterator(c.begin()); }
+    iterator end() { return std::make_move_iterator(c.end()); }
+    std::size_t size() const noexcept { return c.size(); }
+
+    /* 移出第i个元素，之后它处于"已被移动"的状态 */
+    value_type take(std::size_t i) { return std::move(c[i]); }
+
+private:
+    Container c;
+};
+
+template <typename Container>
+ConsumingRange<Container> consume(Container&& c) {
+    static_assert(!std::is_lvalue_reference<Container>::value, "consume requires an rvalue container");
+    return ConsumingRange<Container>(std::move(c));
+}
+
+/**
+ * 按indices的顺序把c中对应的元素移动到out，返回输出的末尾。下标越界时抛出std::out_of_range，此时没有元素被移动；
+ * 同一个下标出现多次时，后面得到的是已被移动过的元素
+ */
+template <typename Container, typename Indices, typename OutIt>
+OutIt drain(Container&& c, const Indices& indices, OutIt out) {
+    static_assert(!std::is_lvalue_reference<Container>::value, "drain requires an rvalue container");
+    auto range = consume(std::move(c));
+    const std::size_t n = range.size();
+    if (std::any_of(std::begin(indices), std::end(indices), [n](std::size_t i) { return i >= n; }))
+        throw std::out_of_range("drain: index out of range");
+    for (std::size_t i : indices)
+        *out++ = range.take(i);
+    return out;
+}
+
+/**
+ * 取出选中的元素放进一个新的std::vector，结果只分配一次
+ */
+template <typename Container, typename Indices>
+std::vector<typename std::decay_t<Container>::value_type> drain(Container&& c, const Indices& indices) {
+    static_assert(!std::is_lvalue_reference<Container>::value, "drain requires an rvalue container");
+    std::vector<typename std::decay_t<Container>::value_type> result;
+    result.reserve(static_cast<std::size_t>(std::distance(std::begin(indices), std::end(indices))));
+    drain(std::move(c), indices, std::back_inserter(result));
+    return result;
+}
+
+template <typename Container, typename OutIt>
+OutIt drainAll(Container&& c, OutIt out) {
+    static_assert(!std::is_lvalue_reference<Container>::value, "drainAll requires an rvalue container");
+    auto range = consume(std::move(c));
+    return std::copy(range.begin(), range.end(), out);
+}
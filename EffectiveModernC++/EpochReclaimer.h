@@ -0,0 +1,199 @@
+/**
+ * @file EpochReclaimer.h
+ * @brief 基于epoch的内存回收（EBR），供无锁数据结构延迟释放被摘除的节点
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "Allocator.h"
+
+/*
+ * 无锁结构中，一个节点被摘除以后，其他线程可能还拿着指向它的指针，不能立即delete。
+ *
+ * EBR的做法：
+ * - 全局维护一个epoch计数，线程访问共享结构之前进入临界区（Guard），记录下当时的全局epoch
+ * - 被摘除的节点不立即释放，而是连同当前epoch一起放进本线程的待回收列表（retire）
+ * - 只有当所有处于临界区的线程都已经看到了epoch e，全局epoch才能推进到e + 1；
+ *   因此全局epoch到达e + 2时，在epoch e被retire的节点不可能再被任何线程引用，可以安全释放
+ *
+ * 要求：retire的节点必须已经无法从共享结构中到达
+ */
+class EpochReclaimer {
+public:
+    using Deleter = void (*)(void*);
+
+private:
+    static constexpr std::size_t ScanThreshold = 64;
+    static constexpr std::uint64_t Inactive = ~std::uint64_t(0);
+
+    struct Retired {
+        void* ptr;
+        Deleter deleter;
+        std::uint64_t epoch;
+    };
+
+    /* 每个线程一条记录，按缓存行对齐避免伪共享；线程退出后记录留给新线程复用 */
+    struct alignas(64) Record {
+        std::atomic<std::uint64_t> epoch{Inactive};
+        std::atomic<bool> inUse{true};
+        unsigned nesting = 0;
+        std::vector<Retired> retired;
+        Record* next = nullptr;
+    };
+
+public:
+    static EpochReclaimer& instance() {
+        static EpochReclaimer reclaimer;
+        return reclaimer;
+    }
+
+    /**
+     * RAII的临界区，可以嵌套
+     */
+    class Guard {
+    public:
+        Guard() : rec(EpochReclaimer::instance().local()) { EpochReclaimer::instance().enter(*rec); }
+        ~Guard() { EpochReclaimer::instance().leave(*rec); }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+    private:
+        Record* rec;
+    };
+
+    /**
+     * 延迟释放p，等所有可能引用它的线程都离开临界区后调用deleter(p)
+     */
+    void retire(void* p, Deleter deleter) {
+        Record& r = *local();
+        r.retired.push_back(Retired{p, deleter, globalEpoch.load(std::memory_order_acquire)});
+        if (r.retired.size() >= ScanThreshold) {
+            tryAdvance();
+            collect(r.retired);
+        }
+    }
+
+    template <typename T>
+    void retire(T* p) {
+        retire(p, [](void* q) { delete static_cast<T*>(q); });
+    }
+
+    ~EpochReclaimer() {
+        /* 进程退出时不再有线程访问共享结构，剩下的全部释放 */
+        for (Record* r = records.load(); r != nullptr;) {
+            for (auto& x : r->retired)
+                x.deleter(x.ptr);
+            Record* next = r->next;
+            r->~Record();
+            detail::alignedDelete(r, alignof(Record));
+            r = next;
+        }
+        for (auto& x : orphans)
+            x.deleter(x.ptr);
+    }
+
+private:
+    /* 线程退出时把本线程的记录交还，尚未释放的节点转入孤儿列表 */
+    struct LocalHandle {
+        Record* rec = nullptr;
+
+        ~LocalHandle() {
+            if (rec == nullptr)
+                return;
+            EpochReclaimer& self = EpochReclaimer::instance();
+            self.tryAdvance();
+            self.collect(rec->retired);
+            if (!rec->retired.empty()) {
+                std::lock_guard<std::mutex> lk(self.orphanMutex);
+                self.orphans.insert(self.orphans.end(), rec->retired.begin(), rec->retired.end());
+            }
+            rec->retired.clear();
+            rec->inUse.store(false, std::memory_order_release);
+        }
+    };
+
+    EpochReclaimer() = default;
+
+    Record* local() {
+        static thread_local LocalHandle handle;
+        if (handle.rec == nullptr)
+            handle.rec = acquireRecord();
+        return handle.rec;
+    }
+
+    Record* acquireRecord() {
+        for (Record* r = records.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+            bool expected = false;
+            if (!r->inUse.load(std::memory_order_relaxed) &&
+                r->inUse.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+                return r;
+        }
+        /* C++14的new不保证超过max_align_t的对齐 */
+        Record* r = ::new (detail::alignedNew(sizeof(Record), alignof(Record))) Record;
+        Record* head = records.load(std::memory_order_relaxed);
+        do {
+            r->next = head;
+        } while (!records.compare_exchange_weak(head, r, std::memory_order_release, std::memory_order_relaxed));
+        return r;
+    }
+
+    void enter(Record& r) {
+        if (r.nesting++ == 0) {
+            /*
+             * 公布自己所在的epoch。seq_cst的store只和seq_cst的load排序，之后对共享结构的acquire/relaxed读取
+             * 仍可能被重排到store之前，所以用relaxed store加seq_cst fence，与tryAdvance中的fence配对：
+             * 要么tryAdvance看到这次公布，要么这里之后的读取看到摘除节点之前的所有写入
+             */
+            r.epoch.store(globalEpoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    void leave(Record& r) {
+        if (--r.nesting == 0)
+            r.epoch.store(Inactive, std::memory_order_release);
+    }
+
+    /* 所有处于临界区的线程都看到了当前epoch时，推进全局epoch */
+    void tryAdvance() {
+        /* 与enter中的fence配对 */
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::uint64_t e = globalEpoch.load(std::memory_order_relaxed);
+        for (Record* r = records.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+            std::uint64_t re = r->epoch.load(std::memory_order_relaxed);
+            if (re != Inactive && re != e)
+                return;
+        }
+        globalEpoch.compare_exchange_strong(e, e + 1, std::memory_order_seq_cst);
+
+        std::unique_lock<std::mutex> lk(orphanMutex, std::try_to_lock);
+        if (lk.owns_lock())
+            collect(orphans);
+    }
+
+    /* 待回收列表按epoch递增排列，释放前面所有满足epoch + 2 <= 全局epoch的节点 */
+    void collect(std::vector<Retired>& list) {
+        std::uint64_t e = globalEpoch.load(std::memory_order_acquire);
+        std::size_t n = 0;
+        while (n < list.size() && list[n].epoch + 2 <= e) {
+            list[n].deleter(list[n].ptr);
+            ++n;
+        }
+        list.erase(list.begin(), list.begin() + n);
+    }
+
+    std::atomic<std::uint64_t> globalEpoch{0};
+    std::atomic<Record*> records{nullptr};
+    std::mutex orphanMutex;
+    std::vector<Retired> orphans;
+};
+
+using EpochGuard = EpochReclaimer::Guard;
@@ -0,0 +1,520 @@
+/**
+ * @file Expected.h
+ * @brief C++14版本的Expected<T, E>：用返回值而不是异常报告错误，支持链式的andThen/transform/orElse，不分配堆内存
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/*
+ * Item14说noexcept能让编译器生成更好的代码，但会失败的函数仍然要报告错误。抛异常的代价：
+ * - 抛出一次要在堆上分配异常对象、查找展开表、逐帧展开，比一次返回慢两到三个数量级，错误频繁时非常明显
+ * - 可能抛异常的调用点要保留landing pad和展开表，函数不能是noexcept
+ *
+ * Expected<T, E>把"值或者错误"放在同一个对象里返回：
+ *
+ *   Expected<int, ParseErrc> parse(const char* s) noexcept;
+ *
+ *   auto r = parse(s).andThen(checkRange).transform([](int v) { return v * 2; });
+ *   if (r)
+ *       use(*r);
+ *   else
+ *       report(r.error());
+ *
+ * - 值和错误放在对象内部的union里，Expected本身不分配内存；T和E的构造函数不抛异常时，所有操作都是noexcept
+ * - T和E都是平凡可复制的类型时，Expected的拷贝、移动和析构也是平凡的，和std::optional一样：
+ *   Expected<int, ParseErrc>可以放在寄存器里返回，而不是通过隐藏的指针写回调用方的栈
+ * - andThen(f)：有值时返回f(value)（f返回Expected），否则原样传递错误；transform(f)：有值时把f(value)包装成Expected；
+ *   orElse(f)：有错误时返回f(error)；transformError(f)：把错误换成f(error)。f可以返回void，得到Expected<void, E>
+ * - operator*和->不检查，value()在没有值时调用std::abort而不是抛异常；error()要求确实是错误
+ * - 要求E的移动构造函数不抛异常，这样在值和错误之间赋值时能保证强异常安全
+ */
+
+template <typename E>
+class Unexpected {
+public:
+    explicit Unexpected(const E& e) : err(e) {}
+    explicit Unexpected(E&& e) noexcept(std::is_nothrow_move_constructible<E>::value) : err(std::move(e)) {}
+
+    const E& error() const& noexcept { return err; }
+    E& error() & noexcept { return err; }
+    E&& error() && noexcept { return std::move(err); }
+
+private:
+    E err;
+};
+
+template <typename E>
+Unexpected<std::decay_t<E>> makeUnexpected(E&& e) {
+    return Unexpected<std::decay_t<E>>(std::forward<E>(e));
+}
+
+template <typename T, typename E>
+class Expected;
+
+template <typename T>
+struct IsExpected : std::false_type {};
+
+template <typename T, typename E>
+struct IsExpected<Expected<T, E>> : std::true_type {};
+
+namespace detail {
+
+[[noreturn]] inline void badExpectedAccess() noexcept {
+    std::abort();
+}
+
+/* 调用f(args...)，f返回void时得到Expected<void, E>，否则得到Expected<U, E> */
+template <typename E, typename F, typename... Args>
+auto invokeToExpectedImpl(std::false_type, F&& f, Args&&... args) {
+    using U = std::decay_t<decltype(std::forward<F>(f)(std::forward<Args>(args)...))>;
+    return Expected<U, E>(std::forward<F>(f)(std::forward<Args>(args)...));
+}
+
+template <typename E, typename F, typename... Args>
+auto invokeToExpectedImpl(std::true_type, F&& f, Args&&... args) {
+    std::forward<F>(f)(std::forward<Args>(args)...);
+    return Expected<void, E>();
+}
+
+template <typename E, typename F, typename... Args>
+auto invokeToExpected(F&& f, Args&&... args) {
+    using R = decltype(std::forward<F>(f)(std::forward<Args>(args)...));
+    return invokeToExpectedImpl<E>(std::is_void<R>(), std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+struct ExpectedValueTag {};
+struct ExpectedErrorTag {};
+
+/* Expected<void, E>存放的"值" */
+struct ExpectedNoValue {};
+
+/* 先在旁边构造好新值，失败时s不变；T的移动构造抛异常时恢复原来的错误 */
+template <typename S, typename U>
+void assignExpectedValue(S& s, U&& v) {
+    using T = decltype(s.val);
+    using E = decltype(s.err);
+    if (s.has) {
+        s.val = std::forward<U>(v);
+        return;
+    }
+    T tmp(std::forward<U>(v));
+    E saved(std::move(s.err));
+    s.err.~E();
+    try {
+        ::new (&s.val) T(std::move(tmp));
+    } catch (...) {
+        ::new (&s.err) E(std::move(saved));
+        throw;
+    }
+    s.has = true;
+}
+
+template <typename S, typename G>
+void assignExpectedError(S& s, G&& g) {
+    using T = decltype(s.val);
+    using E = decltype(s.err);
+    if (!s.has) {
+        s.err = std::forward<G>(g);
+        return;
+    }
+    E tmp(std::forward<G>(g));
+    s.val.~T();
+    ::new (&s.err) E(std::move(tmp));
+    s.has = false;
+}
+
+/*
+ * Expected的存储。T和E都是平凡可复制的类型时，拷贝、移动和析构都用编译器生成的平凡版本，
+ * 否则按has拷贝/移动/析构union中活跃的成员
+ */
+template <typename T, typename E,
+          bool Trivial = std::is_trivially_copyable<T>::value && std::is_trivially_copyable<E>::value>
+struct ExpectedStorage {
+    template <typename... Args>
+    explicit ExpectedStorage(ExpectedValueTag, Args&&... args) : val(std::forward<Args>(args)...), has(true) {}
+
+    template <typename... Args>
+    explicit ExpectedStorage(ExpectedErrorTag, Args&&... args) : err(std::forward<Args>(args)...), has(false) {}
+
+    union {
+        T val;
+        E err;
+    };
+    bool has;
+};
+
+template <typename T, typename E>
+struct ExpectedStorage<T, E, false> {
+    template <typename... Args>
+    explicit ExpectedStorage(ExpectedValueTag, Args&&... args) : val(std::forward<Args>(args)...), has(true) {}
+
+    template <typename... Args>
+    explicit ExpectedStorage(ExpectedErrorTag, Args&&... args) : err(std::forward<Args>(args)...), has(false) {}
+
+    ExpectedStorage(const ExpectedStorage& other) noexcept(std::is_nothrow_copy_constructible<T>::value &&
+                                                           std::is_nothrow_copy_constructible<E>::value)
+    : has(other.has) {
+        if (has)
+            ::new (&val) T(other.val);
+        else
+            ::new (&err) E(other.err);
+    }
+
+    ExpectedStorage(ExpectedStorage&& other) noexcept(std::is_nothrow_move_constructible<T>::value)
+    : has(other.has) {
+        if (has)
+            ::new (&val) T(std::move(other.val));
+        else
+            ::new (&err) E(std::move(other.err));
+    }
+
+    ExpectedStorage& operator=(const ExpectedStorage& other) {
+        if (other.has)
+            assignExpectedValue(*this, other.val);
+        else
+            assignExpectedError(*this, other.err);
+        return *this;
+    }
+
+    ExpectedStorage& operator=(ExpectedStorage&& other) noexcept(std::is_nothrow_move_assignable<T>::value &&
+                                                                 std::is_nothrow_move_constructible<T>::value &&
+                                                                 std::is_nothrow_move_assignable<E>::value) {
+        if (other.has)
+            assignExpectedValue(*this, std::move(other.val));
+        else
+            assignExpectedError(*this, std::move(other.err));
+        return *this;
+    }
+
+    ~ExpectedStorage() {
+        if (has)
+            val.~T();
+        else
+            err.~E();
+    }
+
+    union {
+        T val;
+        E err;
+    };
+    bool has;
+};
+
+} // namespace detail
+
+template <typename T, typename E>
+class Expected : private detail::ExpectedStorage<T, E> {
+    static_assert(!std::is_reference<T>::value && !std::is_reference<E>::value, "Expected does not hold references");
+    static_assert(std::is_nothrow_move_constructible<E>::value, "the error type must be nothrow move constructible");
+
+    using Storage = detail::ExpectedStorage<T, E>;
+    using Storage::val;
+    using Storage::err;
+    using Storage::has;
+
+public:
+    using value_type = T;
+    using error_type = E;
+
+    Expected() noexcept(std::is_nothrow_default_constructible<T>::value) : Storage(detail::ExpectedValueTag()) {}
+
+    Expected(const T& v) noexcept(std::is_nothrow_copy_constructible<T>::value)
+    : Storage(detail::ExpectedValueTag(), v) {}
+
+    Expected(T&& v) noexcept(std::is_nothrow_move_constructible<T>::value)
+    : Storage(detail::ExpectedValueTag(), std::move(v)) {}
+
+    template <typename G>
+    Expected(const Unexpected<G>& u) noexcept(std::is_nothrow_constructible<E, const G&>::value)
+    : Storage(detail::ExpectedErrorTag(), u.error()) {}
+
+    template <typename G>
+    Expected(Unexpected<G>&& u) noexcept(std::is_nothrow_constructible<E, G&&>::value)
+    : Storage(detail::ExpectedErrorTag(), std::move(u).error()) {}
+
+    /* 拷贝、移动和析构由Storage提供 */
+
+    Expected& operator=(const T& v) {
+        detail::assignExpectedValue(storage(), v);
+        return *this;
+    }
+
+    Expected& operator=(T&& v) {
+        detail::assignExpectedValue(storage(), std::move(v));
+        return *this;
+    }
+
+    template <typename G>
+    Expected& operator=(const Unexpected<G>& u) {
+        detail::assignExpectedError(storage(), u.error());
+        return *this;
+    }
+
+    template <typename G>
+    Expected& operator=(Unexpected<G>&& u) {
+        detail::assignExpectedError(storage(), std::move(u).error());
+        return *this;
+    }
+
+    bool hasValue() const noexcept { return has; }
+    explicit operator bool() const noexcept { return has; }
+
+    /* 不检查是否有值 */
+    T& operator*() & noexcept { return val; }
+    const T& operator*() const& noexcept { return val; }
+    T&& operator*() && noexcept { return std::move(val); }
+    T* operator->() noexcept { return &val; }
+    const T* operator->() const noexcept { return &val; }
+
+    /* 没有值时终止程序 */
+    T& value() & noexcept {
+        if (!has)
+            detail::badExpectedAccess();
+        return val;
+    }
+
+    const T& value() const& noexcept {
+        if (!has)
+            detail::badExpectedAccess();
+        return val;
+    }
+
+    T&& value() && noexcept {
+        if (!has)
+            detail::badExpectedAccess();
+        return std::move(val);
+    }
+
+    const E& error() const& noexcept { return err; }
+    E& error() & noexcept { return err; }
+    E&& error() && noexcept { return std::move(err); }
+
+    template <typename U>
+    T valueOr(U&& fallback) const& {
+        return has ? val : static_cast<T>(std::forward<U>(fallback));
+    }
+
+    template <typename U>
+    T valueOr(U&& fallback) && {
+        return has ? std::move(val) : static_cast<T>(std::forward<U>(fallback));
+    }
+
+    /**
+     * 有值时返回f(value)，f必须返回错误类型相同的Expected；否则传递错误
+     */
+    template <typename F>
+    auto andThen(F&& f) const& {
+        using R = std::decay_t<decltype(std::forward<F>(f)(val))>;
+        static_assert(IsExpected<R>::value, "andThen: f must return an Expected");
+        static_assert(std::is_same<typename R::error_type, E>::value, "andThen: f must keep the error type");
+        if (has)
+            return R(std::forward<F>(f)(val));
+        return R(makeUnexpected(err));
+    }
+
+    template <typename F>
+    auto andThen(F&& f) && {
+        using R = std::decay_t<decltype(std::forward<F>(f)(std::move(val)))>;
+        static_assert(IsExpected<R>::value, "andThen: f must return an Expected");
+        static_assert(std::is_same<typename R::error_type, E>::value, "andThen: f must keep the error type");
+        if (has)
+            return R(std::forward<F>(f)(std::move(val)));
+        return R(makeUnexpected(std::move(err)));
+    }
+
+    /**
+     * 有值时返回Expected<U, E>(f(value))，否则传递错误
+     */
+    template <typename F>
+    auto transform(F&& f) const& {
+        using R = decltype(detail::invokeToExpected<E>(std::forward<F>(f), val));
+        if (has)
+            return detail::invokeToExpected<E>(std::forward<F>(f), val);
+        return R(makeUnexpected(err));
+    }
+
+    template <typename F>
+    auto transform(F&& f) && {
+        using R = decltype(detail::invokeToExpected<E>(std::forward<F>(f), std::move(val)));
+        if (has)
+            return detail::invokeToExpected<E>(std::forward<F>(f), std::move(val));
+        return R(makeUnexpected(std::move(err)));
+    }
+
+    /**
+     * 有错误时返回f(error)，f必须返回值类型相同的Expected；否则传递值
+     */
+    template <typename F>
+    auto orElse(F&& f) const& {
+        using R = std::decay_t<decltype(std::forward<F>(f)(err))>;
+        static_assert(IsExpected<R>::value, "orElse: f must return an Expected");
+        static_assert(std::is_same<typename R::value_type, T>::value, "orElse: f must keep the value type");
+        if (has)
+            return R(val);
+        return R(std::forward<F>(f)(err));
+    }
+
+    template <typename F>
+    auto orElse(F&& f) && {
+        using R = std::decay_t<decltype(std::forward<F>(f)(std::move(err)))>;
+        static_assert(IsExpected<R>::value, "orElse: f must return an Expected");
+        static_assert(std::is_same<typename R::value_type, T>::value, "orElse: f must keep the value type");
+        if (has)
+            return R(std::move(val));
+        return R(std::forward<F>(f)(std::move(err)));
+    }
+
+    /**
+     * 有错误时把错误换成f(error)
+     */
+    template <typename F>
+    auto transformError(F&& f) const& {
+        using G = std::decay_t<decltype(std::forward<F>(f)(err))>;
+        if (has)
+            return Expected<T, G>(val);
+        return Expected<T, G>(makeUnexpected(std::forward<F>(f)(err)));
+    }
+
+    template <typename F>
+    auto transformError(F&& f) && {
+        using G = std::decay_t<decltype(std::forward<F>(f)(std::move(err)))>;
+        if (has)
+            return Expected<T, G>(std::move(val));
+        return Expected<T, G>(makeUnexpected(std::forward<F>(f)(std::move(err))));
+    }
+
+private:
+    Storage& storage() noexcept { return *this; }
+};
+
+/**
+ * 只表示成功或者错误，没有值
+ */
+template <typename E>
+class Expected<void, E> : private detail::ExpectedStorage<detail::ExpectedNoValue, E> {
+    static_assert(!std::is_reference<E>::value, "Expected does not hold references");
+    static_assert(std::is_nothrow_move_constructible<E>::value, "the error type must be nothrow move constructible");
+
+    using Storage = detail::ExpectedStorage<detail::ExpectedNoValue, E>;
+    using Storage::err;
+    using Storage::has;
+
+public:
+    using value_type = void;
+    using error_type = E;
+
+    Expected() noexcept : Storage(detail::ExpectedValueTag()) {}
+
+    template <typename G>
+    Expected(const Unexpected<G>& u) noexcept(std::is_nothrow_constructible<E, const G&>::value)
+    : Storage(detail::ExpectedErrorTag(), u.error()) {}
+
+    template <typename G>
+    Expected(Unexpected<G>&& u) noexcept(std::is_nothrow_constructible<E, G&&>::value)
+    : Storage(detail::ExpectedErrorTag(), std::move(u).error()) {}
+
+    template <typename G>
+    Expected& operator=(const Unexpected<G>& u) {
+        detail::assignExpectedError(storage(), u.error());
+        return *this;
+    }
+
+    template <typename G>
+    Expected& operator=(Unexpected<G>&& u) {
+        detail::assignExpectedError(storage(), std::move(u).error());
+        return *this;
+    }
+
+    bool hasValue() const noexcept { return has; }
+    explicit operator bool() const noexcept { return has; }
+
+    void value() const noexcept {
+        if (!has)
+            detail::badExpectedAccess();
+    }
+
+    const E& error() const& noexcept { return err; }
+    E& error() & noexcept { return err; }
+    E&& error() && noexcept { return std::move(err); }
+
+    template <typename F>
+    auto andThen(F&& f) const& {
+        using R = std::decay_t<decltype(std::forward<F>(f)())>;
+        static_assert(IsExpected<R>::value, "andThen: f must return an Expected");
+        static_assert(std::is_same<typename R::error_type, E>::value, "andThen: f must keep the error type");
+        if (has)
+            return R(std::forward<F>(f)());
+        return R(makeUnexpected(err));
+    }
+
+    template <typename F>
+    auto andThen(F&& f) && {
+        using R = std::decay_t<decltype(std::forward<F>(f)())>;
+        static_assert(IsExpected<R>::value, "andThen: f must return an Expected");
+        static_assert(std::is_same<typename R::error_type, E>::value, "andThen: f must keep the error type");
+        if (has)
+            return R(std::forward<F>(f)());
+        return R(makeUnexpected(std::move(err)));
+    }
+
+    template <typename F>
+    auto transform(F&& f) const& {
+        using R = decltype(detail::invokeToExpected<E>(std::forward<F>(f)));
+        if (has)
+            return detail::invokeToExpected<E>(std::forward<F>(f));
+        return R(makeUnexpected(err));
+    }
+
+    template <typename F>
+    auto transform(F&& f) && {
+        using R = decltype(detail::invokeToExpected<E>(std::forward<F>(f)));
+        if (has)
+            return detail::invokeToExpected<E>(std::forward<F>(f));
+        return R(makeUnexpected(std::move(err)));
+    }
+
+    template <typename F>
+    auto orElse(F&& f) const& {
+        using R = std::decay_t<decltype(std::forward<F>(f)(err))>;
+        static_assert(IsExpected<R>::value, "orElse: f must return an Expected");
+        static_assert(std::is_void<typename R::value_type>::value, "orElse: f must keep the value type");
+        if (has)
+            return R();
+        return R(std::forward<F>(f)(err));
+    }
+
+    template <typename F>
+    auto orElse(F&& f) && {
+        using R = std::decay_t<decltype(std::forward<F>(f)(std::move(err)))>;
+        static_assert(IsExpected<R>::value, "orElse: f must return an Expected");
+        static_assert(std::is_void<typename R::value_type>::value, "orElse: f must keep the value type");
+        if (has)
+            return R();
+        return R(std::forward<F>(f)(std::move(err)));
+    }
+
+    template <typename F>
+    auto transformError(F&& f) const& {
+        using G = std::decay_t<decltype(std::forward<F>(f)(err))>;
+        if (has)
+            return Expected<void, G>();
+        return Expected<void, G>(makeUnexpected(std::forward<F>(f)(err)));
+    }
+
+    template <typename F>
+    auto transformError(F&& f) && {
+        using G = std::decay_t<decltype(std::forward<F>(f)(std::move(err)))>;
+        if (has)
+            return Expected<void, G>();
+        return Expected<void, G>(makeUnexpected(std::forward<F>(f)(std::move(err))));
+    }
+
+private:
+    Storage& storage() noexcept { return *this; }
+};
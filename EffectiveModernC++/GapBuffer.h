@@ -0,0 +1,298 @@
+/**
+ * @file GapBuffer.h
+ * @brief 针对反复在序列中间插入而优化的gap buffer，接口与findAndInsert使用的cbegin/cend/insert一致
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "SimdFind.h"
+
+/*
+ * 在std::vector中间插入要把插入点之后的所有元素后移一格。gap buffer在缓冲区中间保留一段空隙（gap）：
+ *
+ *   [ 前半段 | ....gap.... | 后半段 ]
+ *
+ * 插入时先把gap移动到插入点，只需要搬动旧插入点与新插入点之间的元素，然后直接写进gap。
+ * 编辑集中在某个"光标"附近时（文本编辑器的典型场景），每次插入几乎都是O(1)。
+ *
+ * 元素始终存放在两段连续内存中，扫描时分别对两段做线性查找（算术类型会使用SimdFind.h的向量化内核），
+ * 仍然是缓存友好的
+ */
+template <typename T>
+class GapBuffer {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+
+    template <bool Const>
+    class Iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+        using reference = std::conditional_t<Const, const T&, T&>;
+        using Owner = std::conditional_t<Const, const GapBuffer, GapBuffer>;
+
+        Iterator() noexcept = default;
+        Iterator(Owner* owner, size_type index) noexcept : owner(owner), index(index) {}
+
+        /* iterator可以隐式转换为const_iterator */
+        template <bool C = Const, typename = std::enable_if_t<C>>
+        Iterator(const Iterator<false>& other) noexcept : owner(other.owner), index(other.index) {}
+
+        reference operator*() const noexcept { return (*owner)[index]; }
+        pointer operator->() const noexcept { return &(*owner)[index]; }
+        reference operator[](difference_type n) const noexcept { return (*owner)[index + n]; }
+
+        Iterator& operator++() noexcept { ++index; return *this; }
+        Iterator operator++(int) noexcept { Iterator t = *this; ++index; return t; }
+        Iterator& operator--() noexcept { --index; return *this; }
+        Iterator operator--(int) noexcept { Iterator t = *this; --index; return t; }
+        Iterator& operator+=(difference_type n) noexcept { index += n; return *this; }
+        Iterator& operator-=(difference_type n) noexcept { index -= n; return *this; }
+
+        friend Iterator operator+(Iterator it, difference_type n) noexcept { return it += n; }
+        friend Iterator operator+(difference_type n, Iterator it) noexcept { return it += n; }
+        friend Iterator operator-(Iterator it, difference_type n) noexcept { return it -= n; }
+        friend difference_type operator-(const Iterator& a, const Iterator& b) noexcept {
+            return static_cast<difference_type>(a.index) - static_cast<difference_type>(b.index);
+        }
+
+        friend bool operator==(const Iterator& a, const Iterator& b) noexcept { return a.index == b.index; }
+        friend bool operator!=(const Iterator& a, const Iterator& b) noexcept { return a.index != b.index; }
+        friend bool operator<(const Iterator& a, const Iterator& b) noexcept { return a.index < b.index; }
+        friend bool operator>(const Iterator& a, const Iterator& b) noexcept { return a.index > b.index; }
+        friend bool operator<=(const Iterator& a, const Iterator& b) noexcept { return a.index <= b.index; }
+        friend bool operator>=(const Iterator& a, const Iterator& b) noexcept { return a.index >= b.index; }
+
+        size_type position() const noexcept { return index; }
+
+    private:
+        friend class GapBuffer;
+        friend class Iterator<true>;
+
+        Owner* owner = nullptr;
+        size_type index = 0;
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    GapBuffer() noexcept = default;
+
+    GapBuffer(std::initializer_list<T> init) {
+        reserve(init.size());
+        for (const auto& v : init)
+            push_back(v);
+    }
+
+    template <typename It, typename = typename std::iterator_traits<It>::iterator_category>
+    GapBuffer(It first, It last) {
+        for (; first != last; ++first)
+            push_back(*first);
+    }
+
+    GapBuffer(const GapBuffer& other) : GapBuffer() {
+        reserve(other.size());
+        other.forEachSegment([this](const T* b, const T* e) {
+            for (; b != e; ++b)
+                push_back(*b);
+        });
+    }
+
+    GapBuffer(GapBuffer&& other) noexcept
+    : buf(other.buf), cap(other.cap), gapBegin(other.gapBegin), gapEnd(other.gapEnd) {
+        other.buf = nullptr;
+        other.cap = other.gapBegin = other.gapEnd = 0;
+    }
+
+    GapBuffer& operator=(GapBuffer other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ~GapBuffer() {
+        clear();
+        std::allocator<T>().deallocate(buf, cap);
+    }
+
+    void swap(GapBuffer& other) noexcept {
+        std::swap(buf, other.buf);
+        std::swap(cap, other.cap);
+        std::swap(gapBegin, other.gapBegin);
+        std::swap(gapEnd, other.gapEnd);
+    }
+
+    size_type size() const noexcept { return cap - (gapEnd - gapBegin); }
+    size_type capacity() const noexcept { return cap; }
+    bool empty() const noexcept { return size() == 0; }
+
+    T& operator[](size_type i) noexcept { return buf[physical(i)]; }
+    const T& operator[](size_type i) const noexcept { return buf[physical(i)]; }
+
+    iterator begin() noexcept { return iterator(this, 0); }
+    iterator end() noexcept { return iterator(this, size()); }
+    const_iterator begin() const noexcept { return const_iterator(this, 0); }
+    const_iterator end() const noexcept { return const_iterator(this, size()); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    void reserve(size_type n) {
+        if (n > cap)
+            regrow(n);
+    }
+
+    void push_back(const T& v) { insert(cend(), v); }
+    void push_back(T&& v) { insert(cend(), std::move(v)); }
+
+    iterator insert(const_iterator pos, const T& v) { return emplace(pos, v); }
+    iterator insert(const_iterator pos, T&& v) { return emplace(pos, std::move(v)); }
+
+    template <typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args) {
+        size_type i = pos.index;
+        /* 参数可能引用缓冲区中的元素，先构造好再搬动gap */
+        T value(std::forward<Args>(args)...);
+        if (gapBegin == gapEnd)
+            regrow(cap == 0 ? 16 : cap * 2);
+        moveGap(i);
+        ::new (static_cast<void*>(buf + gapBegin)) T(std::move(value));
+        ++gapBegin;
+        return iterator(this, i);
+    }
+
+    iterator erase(const_iterator pos) {
+        size_type i = pos.index;
+        moveGap(i);
+        buf[gapEnd].~T();
+        ++gapEnd;
+        return iterator(this, i);
+    }
+
+    void clear() noexcept {
+        for (size_type i = 0; i < gapBegin; ++i)
+            buf[i].~T();
+        for (size_type i = gapEnd; i < cap; ++i)
+            buf[i].~T();
+        gapBegin = 0;
+        gapEnd = cap;
+    }
+
+    /**
+     * 按顺序访问存放元素的两段连续内存，f的参数是[begin, end)指针
+     */
+    template <typename F>
+    void forEachSegment(F&& f) const {
+        if (gapBegin > 0)
+            f(static_cast<const T*>(buf), static_cast<const T*>(buf + gapBegin));
+        if (gapEnd < cap)
+            f(static_cast<const T*>(buf + gapEnd), static_cast<const T*>(buf + cap));
+    }
+
+    /* gap之前的元素个数，也就是上一次编辑的位置 */
+    size_type gapPosition() const noexcept { return gapBegin; }
+
+private:
+    size_type physical(size_type i) const noexcept {
+        return i < gapBegin ? i : i + (gapEnd - gapBegin);
+    }
+
+    static void relocate(T* dst, T* src) {
+        ::new (static_cast<void*>(dst)) T(std::move(*src));
+        src->~T();
+    }
+
+    /* 把[src, src + n)搬到dst，两段可能重叠；平凡可复制的元素直接memmove */
+    static void relocateRange(T* dst, T* src, size_type n, std::true_type) {
+        if (n > 0)
+            std::memmove(static_cast<void*>(dst), static_cast<const void*>(src), n * sizeof(T));
+    }
+
+    static void relocateRange(T* dst, T* src, size_type n, std::false_type) {
+        /* gap长度为0时移动gap，源和目标是同一段 */
+        if (dst == src)
+            return;
+        if (dst > src) {
+            for (size_type k = n; k > 0; --k)
+                relocate(dst + k - 1, src + k - 1);
+        } else {
+            for (size_type k = 0; k < n; ++k)
+                relocate(dst + k, src + k);
+        }
+    }
+
+    static void relocateRange(T* dst, T* src, size_type n) {
+        relocateRange(dst, src, n, std::is_trivially_copyable<T>());
+    }
+
+    /* 把gap移动到逻辑位置i，只搬动两者之间的元素 */
+    void moveGap(size_type i) {
+        if (i < gapBegin) {
+            /* gap左移：[i, gapBegin)搬到gap的右端 */
+            size_type n = gapBegin - i;
+            relocateRange(buf + gapEnd - n, buf + i, n);
+            gapBegin -= n;
+            gapEnd -= n;
+        } else if (i > gapBegin) {
+            size_type n = i - gapBegin;
+            relocateRange(buf + gapBegin, buf + gapEnd, n);
+            gapBegin += n;
+            gapEnd += n;
+        }
+    }
+
+    void regrow(size_type n) {
+        std::allocator<T> alloc;
+        T* nb = alloc.allocate(n);
+        size_type tail = cap - gapEnd;
+        relocateRange(nb, buf, gapBegin);
+        relocateRange(nb + n - tail, buf + gapEnd, tail);
+        alloc.deallocate(buf, cap);
+        buf = nb;
+        gapEnd = n - tail;
+        cap = n;
+    }
+
+    T* buf = nullptr;
+    size_type cap = 0;
+    size_type gapBegin = 0;
+    size_type gapEnd = 0;
+};
+
+template <typename T>
+void swap(GapBuffer<T>& a, GapBuffer<T>& b) noexcept {
+    a.swap(b);
+}
+
+/**
+ * 对GapBuffer分两段查找，findAndInsert中的containerFind会通过ADL选中这个重载
+ */
+template <typename T, typename V>
+typename GapBuffer<T>::const_iterator containerFind(const GapBuffer<T>& c, const V& value) {
+    std::size_t offset = 0;
+    std::size_t found = c.size();
+    c.forEachSegment([&](const T* b, const T* e) {
+        if (found != c.size())
+            return;
+        const T* hit = contiguousFind(b, e, value);
+        if (hit != e)
+            found = offset + (hit - b);
+        offset += e - b;
+    });
+    return c.cbegin() + found;
+}
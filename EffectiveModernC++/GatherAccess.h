@@ -0,0 +1,431 @@
+/**
+ * @file GatherAccess.h
+ * @brief authAndAccess的批量版本：整批下标只做一次认证和越界检查，连续存放的4/8字节元素用硬件gather取出
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "SimdFind.h"
+
+/*
+ * authAndAccess(c, i)一次取一个元素，认证和越界检查每次都要做一遍。按一批下标访问时：
+ * - authAndAccessBatch(c, indices[, authenticate])先调用一次authenticate()，再检查整批下标，
+ *   之后的访问不再检查。下标按无符号数取最大值，有符号的负下标转成无符号后是一个很大的数，
+ *   所以一次无符号max同时覆盖了min >= 0和max < size两个条件；max用AVX2/AVX-512的max_epu32/max_epu64求
+ * - 返回的BatchAccess[k]就是c[indices[k]]，与authAndAccessDecltype14一样按decltype(auto)返回引用，可以赋值
+ * - gather(out)把整批元素拷贝出来。容器和下标都连续存放、元素是4或8字节的平凡类型、下标是4或8字节整数时，
+ *   用vpgatherdd/vpgatherqq这类指令一次取8或16个元素，其余情况逐个调用operator[]
+ * - 表大于GatherPrefetchBytes时，元素基本都不在缓存中，gather的每个lane都是一次独立的缓存缺失，
+ *   这时提前GatherPrefetchDistance个下标发出软件预取，让多个缺失重叠
+ *
+ * BatchAccess只保存容器和下标的引用，二者都必须比它活得久，因此下标不能是临时对象（传入右值时编译报错）；
+ * 检查之后不能再改变容器的大小
+ */
+
+/* 表超过这个大小时gather会提前预取，大致是L2的容量 */
+constexpr std::size_t GatherPrefetchBytes = std::size_t(1) << 21;
+/* 提前多少个下标预取 */
+constexpr std::size_t GatherPrefetchDistance = 64;
+
+namespace detail {
+
+/* ---------------- 下标的最大值（按无符号比较） ---------------- */
+
+template <typename U>
+U scalarMaxIndex(const U* p, std::size_t n) {
+    U m = 0;
+    for (std::size_t i = 0; i < n; ++i)
+        m = p[i] > m ? p[i] : m;
+    return m;
+}
+
+template <typename U>
+using MaxIndexKernel = U (*)(const U*, std::size_t);
+
+/* ---------------- 按下标取元素：out[k] = base[idx[k]] ---------------- */
+
+template <typename T, typename U>
+void scalarGather(const T* base, const U* idx, std::size_t n, T* out, bool prefetch) {
+    std::size_t k = 0;
+    if (prefetch) {
+        for (; k + GatherPrefetchDistance < n; ++k) {
+            __builtin_prefetch(base + idx[k + GatherPrefetchDistance]);
+            out[k] = base[idx[k]];
+        }
+    }
+    for (; k < n; ++k)
+        out[k] = base[idx[k]];
+}
+
+template <typename T, typename U>
+using GatherKernel = void (*)(const T*, const U*, std::size_t, T*, bool);
+
+/* 为[k, k + lanes)之后GatherPrefetchDistance处的一组元素发出预取 */
+template <typename T, typename U>
+inline void prefetchAhead(const T* base, const U* idx, std::size_t k, std::size_t lanes, std::size_t n) {
+    std::size_t p = k + GatherPrefetchDistance;
+    std::size_t e = p + lanes < n ? p + lanes : n;
+    for (; p < e; ++p)
+        __builtin_prefetch(base + idx[p]);
+}
+
+#if CPPNOTE_SIMD_X86
+
+__attribute__((target("avx2"))) inline std::uint32_t maxIndexAvx2(const std::uint32_t* p, std::size_t n) {
+    __m256i m0 = _mm256_setzero_si256(), m1 = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        m0 = _mm256_max_epu32(m0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)));
+        m1 = _mm256_max_epu32(m1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i + 8)));
+    }
+    alignas(32) std::uint32_t lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_max_epu32(m0, m1));
+    std::uint32_t m = scalarMaxIndex(p + i, n - i);
+    for (std::uint32_t x : lanes)
+        m = x > m ? x : m;
+    return m;
+}
+
+/* AVX2没有64位无符号max，8字节下标在AVX2下走标量 */
+inline std::uint64_t maxIndexAvx2(const std::uint64_t* p, std::size_t n) { return scalarMaxIndex(p, n); }
+
+/*
+ * 结尾用掩码加载，未加载的lane为0，不影响最大值。
+ * GCC 12中不带掩码的AVX-512 max/gather内部用_mm512_undefined_*()作为源操作数，会被误报为未初始化，
+ * 这里都写成全1掩码、以0为源的形式，结果相同
+ */
+__attribute__((target("avx512f"))) inline std::uint32_t maxIndexAvx512(const std::uint32_t* p, std::size_t n) {
+    __m512i m0 = _mm512_setzero_si512(), m1 = _mm512_setzero_si512();
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        m0 = _mm512_maskz_max_epu32(0xFFFF, m0, _mm512_loadu_si512(p + i));
+        m1 = _mm512_maskz_max_epu32(0xFFFF, m1, _mm512_loadu_si512(p + i + 16));
+    }
+    for (; i < n; i += 16) {
+        __mmask16 mask = n - i >= 16 ? __mmask16(0xFFFF) : static_cast<__mmask16>((1u << (n - i)) - 1);
+        m0 = _mm512_maskz_max_epu32(0xFFFF, m0, _mm512_maskz_loadu_epi32(mask, p + i));
+    }
+    alignas(64) std::uint32_t lanes[16];
+    _mm512_store_si512(lanes, _mm512_maskz_max_epu32(0xFFFF, m0, m1));
+    return scalarMaxIndex(lanes, 16);
+}
+
+__attribute__((target("avx512f"))) inline std::uint64_t maxIndexAvx512(const std::uint64_t* p, std::size_t n) {
+    __m512i m0 = _mm512_setzero_si512(), m1 = _mm512_setzero_si512();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        m0 = _mm512_maskz_max_epu64(0xFF, m0, _mm512_loadu_si512(p + i));
+        m1 = _mm512_maskz_max_epu64(0xFF, m1, _mm512_loadu_si512(p + i + 8));
+    }
+    for (; i < n; i += 8) {
+        __mmask8 mask = n - i >= 8 ? __mmask8(0xFF) : static_cast<__mmask8>((1u << (n - i)) - 1);
+        m0 = _mm512_maskz_max_epu64(0xFF, m0, _mm512_maskz_loadu_epi64(mask, p + i));
+    }
+    alignas(64) std::uint64_t lanes[8];
+    _mm512_store_si512(lanes, _mm512_maskz_max_epu64(0xFF, m0, m1));
+    return scalarMaxIndex(lanes, 8);
+}
+
+/*
+ * 按(元素宽度, 下标宽度)给出一个向量的gather。32位下标的gather把下标当作有符号数，
+ * 调用方保证表的大小不超过INT32_MAX
+ */
+template <std::size_t TBytes, std::size_t UBytes>
+struct GatherOps;
+
+template <>
+struct GatherOps<4, 4> {
+    static constexpr std::size_t Avx2Lanes = 8, Avx512Lanes = 16;
+    __attribute__((target("avx2"))) static void avx2(const void* base, const void* idx, void* out) {
+        __m256i i = _mm256_loadu_si256(static_cast<const __m256i*>(idx));
+        _mm256_storeu_si256(static_cast<__m256i*>(out),
+                            _mm256_i32gather_epi32(static_cast<const int*>(base), i, 4));
+    }
+    __attribute__((target("avx512f"))) static void avx512(const void* base, const void* idx, void* out) {
+        _mm512_storeu_si512(out, _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, _mm512_loadu_si512(idx), base, 4));
+    }
+};
+
+template <>
+struct GatherOps<8, 4> {
+    static constexpr std::size_t Avx2Lanes = 4, Avx512Lanes = 8;
+    __attribute__((target("avx2"))) static void avx2(const void* base, const void* idx, void* out) {
+        __m128i i = _mm_loadu_si128(static_cast<const __m128i*>(idx));
+        _mm256_storeu_si256(static_cast<__m256i*>(out),
+                            _mm256_i32gather_epi64(static_cast<const long long*>(base), i, 8));
+    }
+    __attribute__((target("avx512f"))) static void avx512(const void* base, const void* idx, void* out) {
+        __m256i i = _mm256_loadu_si256(static_cast<const __m256i*>(idx));
+        _mm512_storeu_si512(out, _mm512_mask_i32gather_epi64(_mm512_setzero_si512(), 0xFF, i, base, 8));
+    }
+};
+
+template <>
+struct GatherOps<4, 8> {
+    static constexpr std::size_t Avx2Lanes = 4, Avx512Lanes = 8;
+    __attribute__((target("avx2"))) static void avx2(const void* base, const void* idx, void* out) {
+        __m256i i = _mm256_loadu_si256(static_cast<const __m256i*>(idx));
+        _mm_storeu_si128(static_cast<__m128i*>(out), _mm256_i64gather_epi32(static_cast<const int*>(base), i, 4));
+    }
+    __attribute__((target("avx512f"))) static void avx512(const void* base, const void* idx, void* out) {
+        _mm256_storeu_si256(static_cast<__m256i*>(out), _mm512_mask_i64gather_epi32(_mm256_setzero_si256(), 0xFF, _mm512_loadu_si512(idx), base, 4));
+    }
+};
+
+template <>
+struct GatherOps<8, 8> {
+    static constexpr std::size_t Avx2Lanes = 4, Avx512Lanes = 8;
+    __attribute__((target("avx2"))) static void avx2(const void* base, const void* idx, void* out) {
+        __m256i i = _mm256_loadu_si256(static_cast<const __m256i*>(idx));
+        _mm256_storeu_si256(static_cast<__m256i*>(out),
+                            _mm256_i64gather_epi64(static_cast<const long long*>(base), i, 8));
+    }
+    __attribute__((target("avx512f"))) static void avx512(const void* base, const void* idx, void* out) {
+        _mm512_storeu_si512(out, _mm512_mask_i64gather_epi64(_mm512_setzero_si512(), 0xFF, _mm512_loadu_si512(idx), base, 8));
+    }
+};
+
+template <typename T, typename U>
+__attribute__((target("avx2"))) void gatherAvx2(const T* base, const U* idx, std::size_t n, T* out, bool prefetch) {
+    using Ops = GatherOps<sizeof(T), sizeof(U)>;
+    constexpr std::size_t Lanes = Ops::Avx2Lanes;
+    std::size_t k = 0;
+    for (; k + Lanes <= n; k += Lanes) {
+        if (prefetch)
+            prefetchAhead(base, idx, k, Lanes, n);
+        Ops::avx2(base, idx + k, out + k);
+    }
+    scalarGather(base, idx + k, n - k, out + k, false);
+}
+
+template <typename T, typename U>
+__attribute__((target("avx512f"))) void gatherAvx512(const T* base, const U* idx, std::size_t n, T* out,
+                                                     bool prefetch) {
+    using Ops = GatherOps<sizeof(T), sizeof(U)>;
+    constexpr std::size_t Lanes = Ops::Avx512Lanes;
+    std::size_t k = 0;
+    for (; k + Lanes <= n; k += Lanes) {
+        if (prefetch)
+            prefetchAhead(base, idx, k, Lanes, n);
+        Ops::avx512(base, idx + k, out + k);
+    }
+    scalarGather(base, idx + k, n - k, out + k, false);
+}
+
+#endif // CPPNOTE_SIMD_X86
+
+template <typename U>
+MaxIndexKernel<U> maxIndexKernel(SimdLevel level) noexcept {
+#if CPPNOTE_SIMD_X86
+    switch (level) {
+        case SimdLevel::AVX512: return static_cast<MaxIndexKernel<U>>(&maxIndexAvx512);
+        case SimdLevel::AVX2:   return static_cast<MaxIndexKernel<U>>(&maxIndexAvx2);
+        default:                break;
+    }
+#else
+    (void)level;
+#endif
+    return &scalarMaxIndex<U>;
+}
+
+template <typename T, typename U>
+GatherKernel<T, U> gatherKernel(SimdLevel level) noexcept {
+#if CPPNOTE_SIMD_X86
+    switch (level) {
+        case SimdLevel::AVX512: return &gatherAvx512<T, U>;
+        case SimdLevel::AVX2:   return &gatherAvx2<T, U>;
+        default:                break;
+    }
+#else
+    (void)level;
+#endif
+    return &scalarGather<T, U>;
+}
+
+/* 4或8字节的整数下标可以用向量求最大值和做gather的下标 */
+template <typename I>
+using IsGatherIndex = std::integral_constant<bool, std::is_integral<I>::value && !std::is_same<I, bool>::value &&
+                                                       (sizeof(I) == 4 || sizeof(I) == 8)>;
+
+/* 4或8字节、可以按位拷贝的元素可以用gather */
+template <typename T>
+using IsGatherElement =
+    std::integral_constant<bool, std::is_trivially_copyable<T>::value && (sizeof(T) == 4 || sizeof(T) == 8)>;
+
+template <typename I>
+using GatherIndexBits = std::conditional_t<sizeof(I) == 4, std::uint32_t, std::uint64_t>;
+
+} // namespace detail
+
+/**
+ * 按无符号比较求下标的最大值，指定指令集，主要给测试和基准使用；n为0时返回0
+ */
+template <typename I>
+std::make_unsigned_t<I> maxIndexWith(SimdLevel level, const I* indices, std::size_t n) {
+    static_assert(detail::IsGatherIndex<I>::value, "maxIndex requires 4 or 8 byte integer indices");
+    using U = detail::GatherIndexBits<I>;
+    return detail::maxIndexKernel<U>(level)(reinterpret_cast<const U*>(indices), n);
+}
+
+template <typename I>
+std::make_unsigned_t<I> maxIndex(const I* indices, std::size_t n) {
+    static_assert(detail::IsGatherIndex<I>::value, "maxIndex requires 4 or 8 byte integer indices");
+    using U = detail::GatherIndexBits<I>;
+    static const detail::MaxIndexKernel<U> kernel = detail::maxIndexKernel<U>(detectSimdLevel());
+    return kernel(reinterpret_cast<const U*>(indices), n);
+}
+
+/**
+ * out[k] = base[indices[k]]，k < n，指定指令集和是否预取。不检查下标，调用方保证所有下标都小于baseSize
+ */
+template <typename T, typename I>
+void simdGatherWith(SimdLevel level, const T* base, std::size_t baseSize, const I* indices, std::size_t n, T* out,
+                    bool prefetch) {
+    static_assert(detail::IsGatherElement<T>::value, "simdGather requires 4 or 8 byte trivially copyable elements");
+    static_assert(detail::IsGatherIndex<I>::value, "simdGather requires 4 or 8 byte integer indices");
+    using U = detail::GatherIndexBits<I>;
+    /* 32位下标的gather按有符号数缩放 */
+    if (sizeof(I) == 4 && baseSize > static_cast<std::size_t>(std::numeric_limits<std::int32_t>::max()))
+        level = SimdLevel::Scalar;
+    detail::gatherKernel<T, U>(level)(base, reinterpret_cast<const U*>(indices), n, out, prefetch);
+}
+
+/**
+ * out[k] = base[indices[k]]，第一次调用时选择指令集，表大于GatherPrefetchBytes时预取。不检查下标
+ */
+template <typename T, typename I>
+void simdGather(const T* base, std::size_t baseSize, const I* indices, std::size_t n, T* out) {
+    static const SimdLevel level = detectSimdLevel();
+    simdGatherWith(level, base, baseSize, indices, n, out, baseSize * sizeof(T) > GatherPrefetchBytes);
+}
+
+namespace detail {
+
+template <typename Indices>
+using IndexOf = std::decay_t<decltype(*std::begin(std::declval<const Indices&>()))>;
+
+template <typename Container>
+using ElementOf = std::decay_t<decltype(*std::begin(std::declval<Container&>()))>;
+
+/*
+ * 返回最大的下标，有负下标时返回SIZE_MAX，保证任何负下标都不会小于表的大小
+ */
+template <typename Indices>
+std::size_t batchMaxIndex(const Indices& indices, std::true_type) {
+    using I = IndexOf<Indices>;
+    auto n = static_cast<std::size_t>(std::distance(std::begin(indices), std::end(indices)));
+    if (n == 0)
+        return 0;
+    auto m = maxIndex(&*std::begin(indices), n);
+    /* 按无符号数比较时负下标是最大的那些值，4字节的-1只是4294967295，要单独识别 */
+    if (std::is_signed<I>::value && m > static_cast<decltype(m)>(std::numeric_limits<I>::max()))
+        return std::numeric_limits<std::size_t>::max();
+    return static_cast<std::size_t>(m);
+}
+
+template <typename Indices>
+std::size_t batchMaxIndex(const Indices& indices, std::false_type) {
+    using I = IndexOf<Indices>;
+    static_assert(std::is_integral<I>::value, "authAndAccessBatch requires integer indices");
+    /* 先扩展到std::size_t再比较：有符号的短下标按符号扩展，-1变成SIZE_MAX，而不是65535或255 */
+    std::size_t m = 0;
+    for (I i : indices)
+        m = static_cast<std::size_t>(i) > m ? static_cast<std::size_t>(i) : m;
+    return m;
+}
+
+} // namespace detail
+
+template <typename Container, typename Indices>
+class BatchAccess {
+public:
+    using index_type = detail::IndexOf<Indices>;
+    using value_type = detail::ElementOf<Container>;
+
+    std::size_t size() const noexcept {
+        return static_cast<std::size_t>(std::distance(std::begin(indices), std::end(indices)));
+    }
+
+    /* 与authAndAccessDecltype14(c, indices[k])相同，返回c[indices[k]]本身 */
+    decltype(auto) operator[](std::size_t k) const { return c[std::begin(indices)[k]]; }
+
+    /**
+     * 把整批元素依次写到out，返回输出的末尾
+     */
+    template <typename OutIt>
+    OutIt gather(OutIt out) const {
+        using UseSimd = std::integral_constant<
+            bool, std::is_same<OutIt, value_type*>::value && IsContiguousContainer<std::remove_const_t<Container>>::value &&
+                      IsContiguousContainer<Indices>::value && detail::IsGatherElement<value_type>::value &&
+                      detail::IsGatherIndex<index_type>::value>;
+        return gather(out, UseSimd());
+    }
+
+    std::vector<value_type> gather() const {
+        std::vector<value_type> result(size());
+        gather(result.data());
+        return result;
+    }
+
+private:
+    template <typename C, typename I, typename Auth>
+    friend BatchAccess<C, I> authAndAccessBatch(C& c, const I& indices, Auth&& authenticate);
+
+    BatchAccess(Container& c, const Indices& indices) : c(c), indices(indices) {}
+
+    template <typename OutIt>
+    OutIt gather(OutIt out, std::false_type) const {
+        for (index_type i : indices)
+            *out++ = c[i];
+        return out;
+    }
+
+    value_type* gather(value_type* out, std::true_type) const {
+        std::size_t n = size();
+        if (n == 0)
+            return out;
+        auto tableSize = static_cast<std::size_t>(std::distance(std::begin(c), std::end(c)));
+        simdGather(&*std::begin(c), tableSize, &*std::begin(indices), n, out);
+        return out + n;
+    }
+
+    Container& c;
+    const Indices& indices;
+};
+
+/**
+ * 先调用一次authenticate()（认证失败时由它抛出异常），再检查整批下标，任何下标越界都抛出std::out_of_range
+ */
+template <typename Container, typename Indices, typename Auth>
+BatchAccess<Container, Indices> authAndAccessBatch(Container& c, const Indices& indices, Auth&& authenticate) {
+    using I = detail::IndexOf<Indices>;
+    std::forward<Auth>(authenticate)();
+    auto tableSize = static_cast<std::size_t>(std::distance(std::begin(c), std::end(c)));
+    if (std::begin(indices) != std::end(indices) &&
+        detail::batchMaxIndex(indices, std::integral_constant<bool, IsContiguousContainer<Indices>::value &&
+                                                                        detail::IsGatherIndex<I>::value>()) >= tableSize)
+        throw std::out_of_range("authAndAccessBatch: index out of range");
+    return BatchAccess<Container, Indices>(c, indices);
+}
+
+template <typename Container, typename Indices>
+BatchAccess<Container, Indices> authAndAccessBatch(Container& c, const Indices& indices) {
+    return authAndAccessBatch(c, indices, [] {});
+}
+
+/* BatchAccess保存下标的引用，临时的下标容器在语句结束时就被销毁，不允许传入 */
+template <typename Container, typename Indices, typename Auth>
+void authAndAccessBatch(Container& c, const Indices&& indices, Auth&& authenticate) = delete;
+
+template <typename Container, typename Indices>
+void authAndAccessBatch(Container& c, const Indices&& indices) = delete;
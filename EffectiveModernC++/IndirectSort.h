@@ -0,0 +1,479 @@
+/**
+ * @file IndirectSort.h
+ * @brief 间接排序：先把键一次性提取到连续的(键, 下标)缓冲区中排好序，再按下标重排原序列
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ * 用derefUPLess这样的比较器对std::vector<std::unique_ptr<int>>排序时，每次比较都要解引用两个指针，
+ * 指向的对象散落在堆上，缓存命中率很低，比较次数是O(N log N)。
+ *
+ * indirectSort的调用方式与std::sort(v.begin(), v.end(), comp)相同，只要比较器能给出"键"：
+ * 1. 对每个元素只解引用一次，把(键, 下标)写进连续的缓冲区
+ * 2. 键是整数且按<比较时用LSD基数排序（每趟8位，所有键在某一位上都相同的趟会被跳过），
+ *    否则用pdqsort（pattern-defeating quicksort）
+ * 3. 最后沿着置换的环移动原序列中的元素，每个元素只移动一次，不需要额外的元素缓冲区
+ *
+ * 比较器通过byKey(keyFn)构造，它本身也是普通的比较器，可以直接交给std::sort；
+ * 不提供键的比较器会退回std::sort
+ */
+
+/**
+ * 按keyFn(x)比较的比较器，key()供indirectSort提取键
+ */
+template <typename KeyFn, typename KeyLess = std::less<>>
+class KeyCompare {
+public:
+    constexpr KeyCompare() = default;
+    constexpr explicit KeyCompare(KeyFn keyFn, KeyLess keyLess = KeyLess()) : keyFn(keyFn), keyLess(keyLess) {}
+
+    template <typename T>
+    decltype(auto) key(const T& x) const { return keyFn(x); }
+
+    const KeyLess& keyComp() const noexcept { return keyLess; }
+
+    template <typename T>
+    bool operator()(const T& a, const T& b) const { return keyLess(keyFn(a), keyFn(b)); }
+
+private:
+    KeyFn keyFn;
+    KeyLess keyLess;
+};
+
+template <typename KeyFn, typename KeyLess = std::less<>>
+KeyCompare<KeyFn, KeyLess> byKey(KeyFn keyFn, KeyLess keyLess = KeyLess()) {
+    return KeyCompare<KeyFn, KeyLess>(keyFn, keyLess);
+}
+
+/* 键就是指针指向的值：适用于原始指针、unique_ptr、shared_ptr */
+struct DerefKey {
+    template <typename P>
+    auto operator()(const P& p) const -> decltype(*p) { return *p; }
+};
+
+using DerefLess = KeyCompare<DerefKey>;
+
+/* ---------------- pdqsort ---------------- */
+
+namespace detail {
+
+constexpr std::ptrdiff_t PdqInsertionThreshold = 24;
+constexpr std::ptrdiff_t PdqNintherThreshold = 128;
+constexpr std::size_t PdqPartialInsertionLimit = 8;
+
+template <typename It, typename Compare>
+void pdqInsertionSort(It begin, It end, Compare& comp) {
+    if (begin == end)
+        return;
+    for (It cur = begin + 1; cur != end; ++cur) {
+        It sift = cur;
+        It sift1 = cur - 1;
+        if (comp(*sift, *sift1)) {
+            auto tmp = std::move(*sift);
+            do {
+                *sift-- = std::move(*sift1);
+            } while (sift != begin && comp(tmp, *--sift1));
+            *sift = std::move(tmp);
+        }
+    }
+}
+
+/* 要求begin之前的元素不大于区间内的任何元素，可以省掉边界检查 */
+template <typename It, typename Compare>
+void pdqUnguardedInsertionSort(It begin, It end, Compare& comp) {
+    if (begin == end)
+        return;
+    for (It cur = begin + 1; cur != end; ++cur) {
+        It sift = cur;
+        It sift1 = cur - 1;
+        if (comp(*sift, *sift1)) {
+            auto tmp = std::move(*sift);
+            do {
+                *sift-- = std::move(*sift1);
+            } while (comp(tmp, *--sift1));
+            *sift = std::move(tmp);
+        }
+    }
+}
+
+/* 移动次数超过限制就放弃并返回false，用来以很小的代价识别已经（几乎）有序的区间 */
+template <typename It, typename Compare>
+bool pdqPartialInsertionSort(It begin, It end, Compare& comp) {
+    if (begin == end)
+        return true;
+    std::size_t limit = 0;
+    for (It cur = begin + 1; cur != end; ++cur) {
+        It sift = cur;
+        It sift1 = cur - 1;
+        if (comp(*sift, *sift1)) {
+            auto tmp = std::move(*sift);
+            do {
+                *sift-- = std::move(*sift1);
+            } while (sift != begin && comp(tmp, *--sift1));
+            *sift = std::move(tmp);
+            limit += static_cast<std::size_t>(cur - sift);
+        }
+        if (limit > PdqPartialInsertionLimit)
+            return false;
+    }
+    return true;
+}
+
+template <typename It, typename Compare>
+void pdqSort2(It a, It b, Compare& comp) {
+    if (comp(*b, *a))
+        std::iter_swap(a, b);
+}
+
+template <typename It, typename Compare>
+void pdqSort3(It a, It b, It c, Compare& comp) {
+    pdqSort2(a, b, comp);
+    pdqSort2(b, c, comp);
+    pdqSort2(a, b, comp);
+}
+
+/* 以*begin为枢轴划分，等于枢轴的元素放到右边；返回枢轴的最终位置以及划分前是否已经有序 */
+template <typename It, typename Compare>
+std::pair<It, bool> pdqPartitionRight(It begin, It end, Compare& comp) {
+    auto pivot = std::move(*begin);
+    It first = begin;
+    It last = end;
+    while (comp(*++first, pivot)) {
+    }
+    if (first - 1 == begin) {
+        while (first < last && !comp(*--last, pivot)) {
+        }
+    } else {
+        while (!comp(*--last, pivot)) {
+        }
+    }
+    bool alreadyPartitioned = first >= last;
+    while (first < last) {
+        std::iter_swap(first, last);
+        while (comp(*++first, pivot)) {
+        }
+        while (!comp(*--last, pivot)) {
+        }
+    }
+    It pivotPos = first - 1;
+    *begin = std::move(*pivotPos);
+    *pivotPos = std::move(pivot);
+    return {pivotPos, alreadyPartitioned};
+}
+
+/* 等于枢轴的元素放到左边；枢轴等于前一段的最大值时使用，一次就把所有相等元素分出去 */
+template <typename It, typename Compare>
+It pdqPartitionLeft(It begin, It end, Compare& comp) {
+    auto pivot = std::move(*begin);
+    It first = begin;
+    It last = end;
+    while (comp(pivot, *--last)) {
+    }
+    if (last + 1 == end) {
+        while (first < last && !comp(pivot, *++first)) {
+        }
+    } else {
+        while (!comp(pivot, *++first)) {
+        }
+    }
+    while (first < last) {
+        std::iter_swap(first, last);
+        while (comp(pivot, *--last)) {
+        }
+        while (!comp(pivot, *++first)) {
+        }
+    }
+    It pivotPos = last;
+    *begin = std::move(*pivotPos);
+    *pivotPos = std::move(pivot);
+    return pivotPos;
+}
+
+template <typename It, typename Compare>
+void pdqSortLoop(It begin, It end, Compare& comp, int badAllowed, bool leftmost) {
+    for (;;) {
+        std::ptrdiff_t size = end - begin;
+        if (size < PdqInsertionThreshold) {
+            if (leftmost)
+                pdqInsertionSort(begin, end, comp);
+            else
+                pdqUnguardedInsertionSort(begin, end, comp);
+            return;
+        }
+
+        /* 枢轴取三数中值，区间较大时取九数中值（ninther），放到begin */
+        std::ptrdiff_t s2 = size / 2;
+        if (size > PdqNintherThreshold) {
+            pdqSort3(begin, begin + s2, end - 1, comp);
+            pdqSort3(begin + 1, begin + (s2 - 1), end - 2, comp);
+            pdqSort3(begin + 2, begin + (s2 + 1), end - 3, comp);
+            pdqSort3(begin + (s2 - 1), begin + s2, begin + (s2 + 1), comp);
+            std::iter_swap(begin, begin + s2);
+        } else {
+            pdqSort3(begin + s2, begin, end - 1, comp);
+        }
+
+        /* 枢轴等于前一段的最大值：等于它的元素都已经在正确的位置上，跳过 */
+        if (!leftmost && !comp(*(begin - 1), *begin)) {
+            begin = pdqPartitionLeft(begin, end, comp) + 1;
+            continue;
+        }
+
+        auto part = pdqPartitionRight(begin, end, comp);
+        It pivotPos = part.first;
+        std::ptrdiff_t lSize = pivotPos - begin;
+        std::ptrdiff_t rSize = end - (pivotPos + 1);
+
+        if (lSize < size / 8 || rSize < size / 8) {
+            /* 划分严重不平衡的次数过多时改用堆排序，保证最坏O(N log N) */
+            if (--badAllowed == 0) {
+                std::make_heap(begin, end, comp);
+                std::sort_heap(begin, end, comp);
+                return;
+            }
+            /* 打乱一些元素，破坏可能导致坏划分的模式 */
+            if (lSize >= PdqInsertionThreshold) {
+                std::iter_swap(begin, begin + lSize / 4);
+                std::iter_swap(pivotPos - 1, pivotPos - lSize / 4);
+                if (lSize > PdqNintherThreshold) {
+                    std::iter_swap(begin + 1, begin + (lSize / 4 + 1));
+                    std::iter_swap(begin + 2, begin + (lSize / 4 + 2));
+                    std::iter_swap(pivotPos - 2, pivotPos - (lSize / 4 + 1));
+                    std::iter_swap(pivotPos - 3, pivotPos - (lSize / 4 + 2));
+                }
+            }
+            if (rSize >= PdqInsertionThreshold) {
+                std::iter_swap(pivotPos + 1, pivotPos + (1 + rSize / 4));
+                std::iter_swap(end - 1, end - rSize / 4);
+                if (rSize > PdqNintherThreshold) {
+                    std::iter_swap(pivotPos + 2, pivotPos + (2 + rSize / 4));
+                    std::iter_swap(pivotPos + 3, pivotPos + (3 + rSize / 4));
+                    std::iter_swap(end - 2, end - (1 + rSize / 4));
+                    std::iter_swap(end - 3, end - (2 + rSize / 4));
+                }
+            }
+        } else if (part.second && pdqPartialInsertionSort(begin, pivotPos, comp) &&
+                   pdqPartialInsertionSort(pivotPos + 1, end, comp)) {
+            /* 划分时没有交换任何元素，两边又都几乎有序，整个区间已经排好 */
+            return;
+        }
+
+        pdqSortLoop(begin, pivotPos, comp, badAllowed, leftmost);
+        begin = pivotPos + 1;
+        leftmost = false;
+    }
+}
+
+} // namespace detail
+
+/**
+ * pdqsort：平均O(N log N)，对已经有序、逆序、大量重复的输入是线性或接近线性的，最坏O(N log N)；不稳定
+ */
+template <typename It, typename Compare>
+void pdqSort(It first, It last, Compare comp) {
+    if (last - first < 2)
+        return;
+    int badAllowed = 0;
+    for (auto n = last - first; n > 1; n >>= 1)
+        ++badAllowed;
+    detail::pdqSortLoop(first, last, comp, badAllowed, true);
+}
+
+template <typename It>
+void pdqSort(It first, It last) {
+    pdqSort(first, last, std::less<>());
+}
+
+/* ---------------- 间接排序 ---------------- */
+
+namespace detail {
+
+template <typename...>
+using VoidT = void;
+
+template <typename Compare, typename T, typename = void>
+struct HasKey : std::false_type {};
+
+template <typename Compare, typename T>
+struct HasKey<Compare, T, VoidT<decltype(std::declval<const Compare&>().key(std::declval<const T&>()))>>
+    : std::true_type {};
+
+template <typename Compare>
+struct KeyLessOf {
+    using type = void;
+};
+
+template <typename KeyFn, typename KeyLess>
+struct KeyLessOf<KeyCompare<KeyFn, KeyLess>> {
+    using type = KeyLess;
+};
+
+/* 整数键并且按<比较时才能用基数排序 */
+template <typename Key, typename Compare>
+struct UseRadix
+    : std::integral_constant<bool, std::is_integral<Key>::value && !std::is_same<Key, bool>::value &&
+                                       (std::is_same<typename KeyLessOf<Compare>::type, std::less<>>::value ||
+                                        std::is_same<typename KeyLessOf<Compare>::type, std::less<Key>>::value)> {};
+
+template <typename Key, typename Index>
+struct KeyIndex {
+    Key key;
+    Index index;
+};
+
+/* 有符号整数翻转符号位后，按无符号数比较的顺序与原来一致 */
+template <typename Key>
+std::make_unsigned_t<Key> radixKey(Key k) {
+    using U = std::make_unsigned_t<Key>;
+    return std::is_signed<Key>::value ? static_cast<U>(static_cast<U>(k) ^ (U(1) << (sizeof(U) * 8 - 1)))
+                                      : static_cast<U>(k);
+}
+
+/* LSD基数排序，每趟8位；稳定，因此相等的键保持原来的相对顺序 */
+template <typename U, typename Index>
+void radixSort(std::vector<KeyIndex<U, Index>>& items) {
+    constexpr std::size_t Digits = sizeof(U);
+    const std::size_t n = items.size();
+    std::vector<std::array<std::size_t, 256>> counts(Digits);
+    for (auto& c : counts)
+        c.fill(0);
+    /* 一遍扫描统计所有位的直方图 */
+    for (const auto& item : items)
+        for (std::size_t d = 0; d < Digits; ++d)
+            ++counts[d][(item.key >> (d * 8)) & 0xFF];
+
+    std::vector<KeyIndex<U, Index>> buffer(n);
+    for (std::size_t d = 0; d < Digits; ++d) {
+        auto& c = counts[d];
+        /* 所有键在这一位上都相同，这一趟不会改变顺序 */
+        if (c[(items[0].key >> (d * 8)) & 0xFF] == n)
+            continue;
+        std::size_t offset = 0;
+        for (auto& x : c) {
+            std::size_t t = x;
+            x = offset;
+            offset += t;
+        }
+        for (const auto& item : items)
+            buffer[c[(item.key >> (d * 8)) & 0xFF]++] = item;
+        items.swap(buffer);
+    }
+}
+
+/* 第i个位置应该放原来的第order[i]个元素；沿着置换的环移动，每个元素只移动一次 */
+template <typename It, typename Index>
+void applyOrder(It first, std::vector<Index>& order) {
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        if (order[i] == i)
+            continue;
+        auto tmp = std::move(first[i]);
+        std::size_t j = i;
+        for (;;) {
+            std::size_t src = order[j];
+            order[j] = static_cast<Index>(j);
+            if (src == i) {
+                first[j] = std::move(tmp);
+                break;
+            }
+            first[j] = std::move(first[src]);
+            j = src;
+        }
+    }
+}
+
+template <typename It, typename Compare, typename Index>
+void indirectSortRadix(It first, std::size_t n, const Compare& comp, Index) {
+    using Key = std::decay_t<decltype(comp.key(*first))>;
+    using U = std::make_unsigned_t<Key>;
+    std::vector<KeyIndex<U, Index>> items(n);
+    for (std::size_t i = 0; i < n; ++i)
+        items[i] = {radixKey(static_cast<Key>(comp.key(first[i]))), static_cast<Index>(i)};
+    radixSort(items);
+
+    std::vector<Index> order(n);
+    for (std::size_t i = 0; i < n; ++i)
+        order[i] = items[i].index;
+    items = {};
+    applyOrder(first, order);
+}
+
+template <typename It, typename Compare, typename Index>
+void indirectSortPdq(It first, std::size_t n, const Compare& comp, Index) {
+    using Key = std::decay_t<decltype(comp.key(*first))>;
+    std::vector<KeyIndex<Key, Index>> items;
+    items.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+        items.push_back({comp.key(first[i]), static_cast<Index>(i)});
+    const auto& keyLess = comp.keyComp();
+    pdqSort(items.begin(), items.end(), [&keyLess](const KeyIndex<Key, Index>& a, const KeyIndex<Key, Index>& b) {
+        return keyLess(a.key, b.key);
+    });
+
+    std::vector<Index> order(n);
+    for (std::size_t i = 0; i < n; ++i)
+        order[i] = items[i].index;
+    items = {};
+    applyOrder(first, order);
+}
+
+template <typename It, typename Compare, typename Index>
+void indirectSortImpl(It first, std::size_t n, const Compare& comp, Index index, std::true_type) {
+    indirectSortRadix(first, n, comp, index);
+}
+
+template <typename It, typename Compare, typename Index>
+void indirectSortImpl(It first, std::size_t n, const Compare& comp, Index index, std::false_type) {
+    indirectSortPdq(first, n, comp, index);
+}
+
+template <typename It, typename Compare, typename Index>
+void indirectSortWith(It first, std::size_t n, const Compare& comp, Index index) {
+    using Key = std::decay_t<decltype(comp.key(*first))>;
+    /* C++14没有if constexpr，用重载选择 */
+    indirectSortImpl(first, n, comp, index, UseRadix<Key, Compare>());
+}
+
+constexpr std::ptrdiff_t IndirectSortThreshold = 64;
+
+template <typename It, typename Compare>
+void indirectSort(It first, It last, const Compare& comp, std::true_type /* has key */) {
+    auto n = last - first;
+    if (n < IndirectSortThreshold) {
+        std::sort(first, last, comp);
+        return;
+    }
+    /* 元素个数不超过2^32时用32位下标，缓冲区更小 */
+    if (static_cast<std::uint64_t>(n) <= std::numeric_limits<std::uint32_t>::max())
+        indirectSortWith(first, static_cast<std::size_t>(n), comp, std::uint32_t());
+    else
+        indirectSortWith(first, static_cast<std::size_t>(n), comp, std::size_t());
+}
+
+template <typename It, typename Compare>
+void indirectSort(It first, It last, const Compare& comp, std::false_type /* has key */) {
+    std::sort(first, last, comp);
+}
+
+} // namespace detail
+
+/**
+ * 与std::sort(first, last, comp)的结果相同（相等元素之间的顺序可能不同），comp需要由byKey构造
+ */
+template <typename It, typename Compare>
+void indirectSort(It first, It last, Compare comp) {
+    using T = typename std::iterator_traits<It>::value_type;
+    detail::indirectSort(first, last, comp, detail::HasKey<Compare, T>());
+}
@@ -5,6 +5,15 @@
  */
 
 #include <vector>
+#include <list>
+#include <set>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <chrono>
+#include <cassert>
+#include <numeric>
+#include <random>
 
 #include <type_traits>
 #include <iostream>
@@ -16,6 +25,13 @@
 #include <string>
 #include <cstdlib>
 
+#include "SimdFind.h"
+#include "BatchInsert.h"
+#include "GapBuffer.h"
+#include "ConcurrentSkipList.h"
+#include "ParallelAlgorithm.h"
+#include "PerfScope.h"
+
 /**
  * 要点：
  * - 对正常的模板类型进行推导的时候，具有引用类型的形参会被当作非引用形参处理
@@ -64,14 +80,15 @@ type_name()
 
 /**
  * C++14的写法
+ *
+ * 查找由containerFind完成：对于连续存放的算术类型容器（例如std::vector<int>）会使用SimdFind.h中的向量化内核，
+ * 其余容器仍然是std::find(cbegin(container), cend(container), targetVal)
  */
 template <typename T, typename V>
 void findAndInsert(T& container,
                    const V& targetVal,
                    const V& insertVal) {
-    using std::cbegin;
-    using std::cend;
-    auto it = std::find(cbegin(container), cend(container), targetVal);
+    auto it = containerFind(container, targetVal);
     container.insert(it, insertVal);
 }
 
@@ -88,7 +105,341 @@ auto cbegin(const C& container) -> decltype(std::begin(container)) {
     return std::begin(container);
 }
 
-int main() {
+/*
+ * 在各种开头偏移和长度下比较向量化内核与std::find的结果，覆盖非对齐的开头和不足一个向量的结尾
+ */
+template <typename T>
+void checkSimdFind(SimdLevel level) {
+    std::vector<T> buf(300);
+    for (std::size_t i = 0; i < buf.size(); ++i)
+        buf[i] = static_cast<T>(i % 97 + 1);
+    for (std::size_t offset = 0; offset < 70; ++offset) {
+        for (std::size_t len = 0; offset + len <= 230; len += 3) {
+            const T* first = buf.data() + offset;
+            const T* last = first + len;
+            for (T needle : {T(1), T(50), T(97), T(0), buf[offset + len]}) {
+                assert(simdFindWith(level, first, last, needle) == std::find(first, last, needle));
+            }
+            /* 只在最后一个元素上命中 */
+            if (len > 0) {
+                std::vector<T> tmp(first, last);
+                tmp.back() = T(0);
+                assert(simdFindWith(level, tmp.data(), tmp.data() + len, T(0)) == tmp.data() + len - 1);
+            }
+        }
+    }
+}
+
+void benchmarkFind(std::size_t n) {
+    std::vector<int> v(n);
+    std::iota(v.begin(), v.end(), 1);
+    /* 目标放在最后，相当于一次完整的扫描 */
+    volatile int target = static_cast<int>(n);
+    const int reps = static_cast<int>(std::max<std::size_t>(1, (64u << 20) / n));
+
+    std::cout << "  n = " << n;
+    auto time = [&](const char* name, const char* scopeName, auto&& find) {
+        std::size_t sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        {
+            PerfScope scope(scopeName);
+            for (int r = 0; r < reps; ++r)
+                sink += find() - v.data();
+        }
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / reps;
+        std::cout << ", " << name << " " << ns / n << " ns/elem";
+        return sink;
+    };
+    time("std::find", "find: std::find", [&] { return &*std::find(v.cbegin(), v.cend(), target); });
+    for (SimdLevel level : {SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (level > detectSimdLevel())
+            break;
+        const char* scopeName = level == SimdLevel::SSE2 ? "find: simdFind SSE2"
+                              : level == SimdLevel::AVX2 ? "find: simdFind AVX2" : "find: simdFind AVX-512";
+        time(simdLevelName(level), scopeName,
+             [&] { return simdFindWith(level, v.data(), v.data() + n, target); });
+    }
+    std::cout << std::endl;
+}
+
+/*
+ * 随机生成的操作序列（包括命中之前插入的值、目标值等于插入值、找不到目标值），批量版本必须和逐个插入的结果相同
+ */
+void checkBatchInsert() {
+    std::mt19937 rng(42);
+    for (int round = 0; round < 200; ++round) {
+        std::vector<int> base(rng() % 50);
+        for (auto& x : base)
+            x = static_cast<int>(rng() % 20);
+        std::vector<std::pair<int, int>> ops(rng() % 200);
+        for (auto& op : ops) {
+            op.first = static_cast<int>(rng() % 25);
+            op.second = rng() % 4 == 0 ? op.first : static_cast<int>(rng() % 25);
+        }
+
+        std::vector<int> sequential = base;
+        for (const auto& op : ops)
+            findAndInsert(sequential, op.first, op.second);
+        std::vector<int> batched = base;
+        findAndInsertBatch(batched, ops);
+        assert(sequential == batched);
+    }
+}
+
+void benchmarkBatchInsert(std::size_t n, std::size_t m, bool runSequential) {
+    std::mt19937 rng(7);
+    std::vector<int> base(n);
+    for (auto& x : base)
+        x = static_cast<int>(rng() % n);
+    std::vector<std::pair<int, int>> ops(m);
+    for (auto& op : ops)
+        op = {static_cast<int>(rng() % n), static_cast<int>(rng() % n)};
+
+    std::cout << "  n = " << n << ", " << m << " inserts";
+    if (runSequential) {
+        std::vector<int> v = base;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& op : ops)
+            findAndInsert(v, op.first, op.second);
+        auto end = std::chrono::steady_clock::now();
+        std::cout << ", findAndInsert " << std::chrono::duration<double, std::milli>(end - start).count() << " ms";
+    }
+    std::vector<int> v = base;
+    auto start = std::chrono::steady_clock::now();
+    findAndInsertBatch(v, ops);
+    auto end = std::chrono::steady_clock::now();
+    std::cout << ", findAndInsertBatch " << std::chrono::duration<double, std::milli>(end - start).count() << " ms"
+              << std::endl;
+}
+
+/*
+ * findAndInsert的编辑负载：元素的值等于初始下标，查找目标值就定位到对应的位置。
+ * localized表示目标在一个缓慢移动的"光标"附近，scattered表示目标均匀随机
+ */
+template <typename Container>
+double editWorkload(std::size_t n, std::size_t edits, bool localized, std::vector<int>* out = nullptr) {
+    Container c;
+    for (std::size_t i = 0; i < n; ++i)
+        c.insert(c.cend(), static_cast<int>(i));
+    std::mt19937 rng(3);
+    int cursor = static_cast<int>(n / 2);
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t e = 0; e < edits; ++e) {
+        int target;
+        if (localized) {
+            cursor = std::min<int>(static_cast<int>(n) - 1, std::max(0, cursor + static_cast<int>(rng() % 9) - 4));
+            target = cursor;
+        } else {
+            target = static_cast<int>(rng() % n);
+        }
+        findAndInsert(c, target, -static_cast<int>(e) - 1);
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (out != nullptr)
+        out->assign(c.cbegin(), c.cend());
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void benchmarkEditing(std::size_t n, std::size_t edits) {
+    for (bool localized : {true, false}) {
+        std::vector<int> a, b;
+        double vec = editWorkload<std::vector<int>>(n, edits, localized, &a);
+        double gap = editWorkload<GapBuffer<int>>(n, edits, localized, &b);
+        assert(a == b);
+        std::cout << "  n = " << n << ", " << edits << (localized ? " localized" : " scattered")
+                  << " edits: std::vector " << vec << " ms, GapBuffer " << gap << " ms";
+        /* std::list的查找要逐个节点追指针，元素多的时候太慢，只测小规模 */
+        if (n <= 100000)
+            std::cout << ", std::list " << editWorkload<std::list<int>>(n, edits, localized) << " ms";
+        std::cout << std::endl;
+    }
+}
+
+/*
+ * 多个线程并发地插入、删除、查找，最后检查内容和顺序
+ */
+void checkSkipList() {
+    ConcurrentSkipListMap<int, int> map;
+    const int threads = 4, perThread = 20000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&map, t] {
+            for (int i = 0; i < perThread; ++i) {
+                int key = i * threads + t;
+                map.insert(key, -key);
+                /* 与其他线程竞争同一个key，只有一个能插入成功 */
+                map.findOrInsert(i, i);
+                if (key % 2 == 0)
+                    map.erase(key);
+            }
+        });
+    }
+    for (auto& w : workers)
+        w.join();
+
+    int prev = -1;
+    std::size_t n = 0;
+    map.forEach([&](int key, int value) {
+        assert(key > prev);
+        assert(key % 2 == 1 || key < perThread);
+        assert(value == -key || value == key);
+        prev = key;
+        ++n;
+        return true;
+    });
+    assert(n == map.size());
+}
+
+/*
+ * 查找后插入的负载：readPercent%的操作是查找，其余是findAndInsert式的"找到位置再插入"
+ */
+template <typename Op>
+double throughput(const char* name, int threads, int opsPerThread, Op op) {
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            /* 每个线程各自计数，按名字汇总所有线程 */
+            PerfScope scope(name);
+            std::mt19937 rng(t + 1);
+            for (int i = 0; i < opsPerThread; ++i)
+                op(rng);
+        });
+    }
+    for (auto& w : workers)
+        w.join();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return threads * opsPerThread / sec / 1e6;
+}
+
+void benchmarkConcurrentInsert(int readPercent) {
+    const int keyRange = 1 << 20;
+    const int ops = 200000;
+    std::cout << "  " << readPercent << "% reads (Mops/s)" << std::endl;
+    int maxThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        ConcurrentSkipListMap<int, int> skip;
+        double a = throughput("skip list", threads, ops, [&](std::mt19937& rng) {
+            int key = static_cast<int>(rng() % keyRange);
+            if (static_cast<int>(rng() % 100) < readPercent)
+                skip.contains(key);
+            else
+                skip.findOrInsert(key, key);
+        });
+
+        std::mutex setMutex;
+        std::set<int> set;
+        double b = throughput("mutex+std::set", threads, ops, [&](std::mt19937& rng) {
+            int key = static_cast<int>(rng() % keyRange);
+            bool read = static_cast<int>(rng() % 100) < readPercent;
+            std::lock_guard<std::mutex> lk(setMutex);
+            if (read)
+                set.count(key);
+            else
+                set.insert(key);
+        });
+
+        std::mutex vecMutex;
+        std::vector<int> vec;
+        double c = throughput("mutex+sorted std::vector", threads, ops, [&](std::mt19937& rng) {
+            int key = static_cast<int>(rng() % keyRange);
+            bool read = static_cast<int>(rng() % 100) < readPercent;
+            std::lock_guard<std::mutex> lk(vecMutex);
+            auto it = std::lower_bound(vec.cbegin(), vec.cend(), key);
+            if (!read && (it == vec.cend() || *it != key))
+                vec.insert(it, key);
+        });
+
+        std::cout << "    " << threads << " threads: skip list " << a << ", mutex+std::set " << b
+                  << ", mutex+sorted std::vector " << c << std::endl;
+    }
+    /* 所有线程数合在一起，锁竞争体现为上下文切换 */
+    PerfScope::report();
+    PerfScope::reset();
+}
+
+/*
+ * 并行版本与对应的标准库算法结果一致；取消后抛出OperationCancelled
+ */
+void checkParallel() {
+    std::vector<int> v(1000003);
+    std::mt19937 rng(7);
+    for (auto& x : v)
+        x = static_cast<int>(rng() % 1000);
+    ParallelOptions opts;
+    opts.grain = 1000;
+
+    for (int target : {v.front(), v[500000], v.back(), 1000})
+        assert(parallelFind(v.cbegin(), v.cend(), target, opts) == std::find(v.cbegin(), v.cend(), target));
+    auto isBig = [](int x) { return x > 900; };
+    assert(parallelCountIf(v.cbegin(), v.cend(), isBig, opts) == std::count_if(v.cbegin(), v.cend(), isBig));
+    assert(parallelReduce(v.cbegin(), v.cend(), 0LL, opts) == std::accumulate(v.cbegin(), v.cend(), 0LL));
+
+    std::vector<int> a(v.size()), b(v.size());
+    parallelTransform(v.cbegin(), v.cend(), a.begin(), [](int x) { return x * 3 + 1; }, opts);
+    std::transform(v.cbegin(), v.cend(), b.begin(), [](int x) { return x * 3 + 1; });
+    assert(a == b);
+
+    a = v;
+    parallelSort(a.begin(), a.end(), std::greater<>(), opts);
+    b = v;
+    std::sort(b.begin(), b.end(), std::greater<>());
+    assert(a == b);
+
+    /* 非随机访问迭代器退化为串行算法 */
+    std::list<int> l(v.begin(), v.begin() + 1000);
+    assert(parallelFind(l.cbegin(), l.cend(), v[10], opts) == std::find(l.cbegin(), l.cend(), v[10]));
+
+    CancellationToken token;
+    opts.cancel = &token;
+    bool cancelled = false;
+    try {
+        parallelCountIf(v.cbegin(), v.cend(), [&token](int x) { token.cancel(); return x > 0; }, opts);
+    } catch (const OperationCancelled&) {
+        cancelled = true;
+    }
+    assert(cancelled);
+}
+
+void benchmarkParallel(std::size_t n) {
+    std::vector<int> v(n);
+    std::mt19937 rng(11);
+    for (auto& x : v)
+        x = static_cast<int>(rng() % 1000000);
+    /* 目标放在3/4处，串行查找要扫描大部分元素 */
+    const int target = -1;
+    v[n / 4 * 3] = target;
+    std::vector<int> out(n);
+
+    auto ms = [](auto&& f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    std::cout << "  n = " << n << " (ms)" << std::endl;
+    std::size_t maxThreads = ThreadPool::shared().size() + 1;
+    for (std::size_t threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        ParallelOptions opts;
+        opts.threads = threads;
+        volatile long long sink = 0;
+        double find = ms([&] { sink += parallelFind(v.cbegin(), v.cend(), target, opts) - v.cbegin(); });
+        double transform = ms([&] {
+            parallelTransform(v.cbegin(), v.cend(), out.begin(), [](int x) { return x / 3 + 1; }, opts);
+        });
+        double reduce = ms([&] { sink += parallelReduce(v.cbegin(), v.cend(), 0LL, opts); });
+        double count = ms([&] { sink += parallelCountIf(v.cbegin(), v.cend(), [](int x) { return x % 7 == 0; }, opts); });
+        out = v;
+        double sort = ms([&] { parallelSort(out.begin(), out.end(), opts); });
+        std::cout << "    " << threads << " threads: find " << find << ", transform " << transform
+                  << ", reduce " << reduce << ", count_if " << count << ", sort " << sort << std::endl;
+        if (threads == maxThreads)
+            break;
+    }
+}
+
+int main(int argc, char* argv[]) {
     std::vector<int> vec;
     for(auto it = vec.cbegin(); it != vec.cend(); ++it) {
         // do something
@@ -96,4 +447,50 @@ int main() {
 
     int arr[] = {1, 2, 3};
     cbegin(arr);
+
+    std::vector<int> values{1, 2, 3, 4};
+    findAndInsert(values, 3, 10);
+    assert((values == std::vector<int>{1, 2, 10, 3, 4}));
+
+    std::cout << ">>>> simd find (detected " << simdLevelName(detectSimdLevel()) << ")" << std::endl;
+    for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (level > detectSimdLevel())
+            break;
+        checkSimdFind<std::int8_t>(level);
+        checkSimdFind<std::uint16_t>(level);
+        checkSimdFind<int>(level);
+        checkSimdFind<std::int64_t>(level);
+        checkSimdFind<float>(level);
+        checkSimdFind<double>(level);
+    }
+    for (std::size_t n : {64u, 1024u, 64u << 10, 1u << 20, 16u << 20})
+        benchmarkFind(n);
+    PerfScope::report();
+    PerfScope::reset();
+
+    std::cout << ">>>> batched findAndInsert" << std::endl;
+    checkBatchInsert();
+    benchmarkBatchInsert(10000, 10000, true);
+    benchmarkBatchInsert(1000000, 1000, true);
+    std::cout << ">>>> findAndInsert on GapBuffer" << std::endl;
+    GapBuffer<int> gap{1, 2, 3, 4};
+    findAndInsert(gap, 3, 10);
+    findAndInsert(gap, 1, 20);
+    findAndInsert(gap, 42, 30);
+    assert((std::vector<int>(gap.cbegin(), gap.cend()) == std::vector<int>{20, 1, 2, 10, 3, 4, 30}));
+    benchmarkEditing(10000, 10000);
+    benchmarkEditing(1000000, 2000);
+
+    std::cout << ">>>> concurrent skip list" << std::endl;
+    checkSkipList();
+    benchmarkConcurrentInsert(90);
+    benchmarkConcurrentInsert(50);
+
+    std::cout << ">>>> parallel algorithms" << std::endl;
+    checkParallel();
+    benchmarkParallel(10000000);
+
+    /* 1亿个元素需要约800MB内存，逐个插入的版本要跑几分钟，只在传入--large时运行批量版本 */
+    if (argc > 1 && std::string(argv[1]) == "--large")
+        benchmarkBatchInsert(100000000, 1000000, false);
 }
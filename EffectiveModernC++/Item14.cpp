@@ -4,7 +4,18 @@
  * @date 2020/9/21
  */
 
+#include <algorithm>
+#include <cassert>
+#include <chrono>
 #include <cstddef>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Expected.h"
+#include "Item14ErrorPaths.h"
 
 /*
  * 对函数声明noexcept会让编译器生成更好的目标代码
@@ -43,6 +54,116 @@ void swap(T (&a)[N], T(&b)[N]) noexcept(noexcept(swap(*a, *b)));
  * 编译器允许函数声明noexcept的同时调用可能会抛出异常的函数，有可能是因为调用的函数在文档中已经声明不会发射异常（但是没有声明noexcept），
  * 也有可能是来自C语言的库等等情况。
  */
+template <typename F>
+double timeMs(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/* 值、错误、链式调用以及在值和错误之间赋值 */
+void checkExpected() {
+    using Result = Expected<int, ParseErrc>;
+    static_assert(sizeof(Result) == 2 * sizeof(int), "Expected keeps the value and the error inline");
+    static_assert(std::is_nothrow_move_constructible<Result>::value, "");
+    /* 平凡可复制，按值返回时放在寄存器里 */
+    static_assert(std::is_trivially_copyable<Result>::value, "Expected<int, ParseErrc> should be trivially copyable");
+    static_assert(std::is_trivially_copyable<Expected<void, ParseErrc>>::value, "");
+    static_assert(!std::is_trivially_copyable<Expected<std::string, ParseErrc>>::value, "");
+
+    Result ok = 21;
+    Result bad = makeUnexpected(ParseErrc::Overflow);
+    auto half = [](int v) -> Result {
+        if (v % 2 != 0)
+            return makeUnexpected(ParseErrc::OutOfRange);
+        return v / 2;
+    };
+    assert(ok && *ok == 21 && !bad && bad.error() == ParseErrc::Overflow);
+    assert(ok.transform([](int v) { return v * 2; }).andThen(half).value() == 21);
+    assert(ok.andThen(half).error() == ParseErrc::OutOfRange);
+    assert(bad.andThen(half).error() == ParseErrc::Overflow);
+    assert(bad.orElse([](ParseErrc) { return Result(0); }).value() == 0);
+    assert(bad.transformError([](ParseErrc e) { return static_cast<int>(e); }).error() ==
+           static_cast<int>(ParseErrc::Overflow));
+    assert(bad.valueOr(-1) == -1 && ok.valueOr(-1) == 21);
+
+    /* f返回void时得到Expected<void, E> */
+    int seen = 0;
+    Expected<void, ParseErrc> done = ok.transform([&](int v) { seen = v; });
+    assert(done && seen == 21);
+    assert(!bad.transform([&](int v) { seen = v; }) && seen == 21);
+
+    /* 值是std::unique_ptr、错误是std::string：移动构造，值和错误之间来回赋值 */
+    Expected<std::unique_ptr<int>, std::string> p(std::unique_ptr<int>(new int(7)));
+    auto moved = std::move(p).transform([](std::unique_ptr<int> q) { return *q + 1; });
+    assert(moved && *moved == 8);
+    Expected<std::unique_ptr<int>, std::string> q = makeUnexpected(std::string("missing"));
+    q = std::unique_ptr<int>(new int(1));
+    assert(q && **q == 1);
+    q = makeUnexpected(std::string("gone"));
+    assert(!q && q.error() == "gone");
+}
+
+/*
+ * n个输入中按errorRate的比例混入非法输入（空串、非数字、溢出、超出范围），
+ * 分别用try/catch调用异常版本、检查返回值调用Expected版本，两者的结果和错误计数必须一致
+ */
+void benchmarkErrorPaths(std::size_t n, double errorRate) {
+    std::mt19937 rng(14);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    const char* invalid[] = {"", "12a4", "99999999999", "0", "2000000"};
+    std::vector<std::string> inputs;
+    inputs.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        if (coin(rng) < errorRate)
+            inputs.emplace_back(invalid[rng() % 5]);
+        else
+            inputs.push_back(std::to_string(1 + rng() % 1000000));
+    }
+
+    long long sumA = 0, sumB = 0;
+    std::size_t errorsA[4] = {0}, errorsB[4] = {0};
+    auto runExceptions = [&] {
+        sumA = 0;
+        std::fill(errorsA, errorsA + 4, 0);
+        for (const auto& s : inputs) {
+            try {
+                sumA += viaExceptions::score(s.c_str());
+            } catch (const ParseFailure& e) {
+                ++errorsA[static_cast<int>(e.code)];
+            }
+        }
+    };
+    auto runExpected = [&] {
+        sumB = 0;
+        std::fill(errorsB, errorsB + 4, 0);
+        for (const auto& s : inputs) {
+            auto r = viaExpected::score(s.c_str());
+            if (r)
+                sumB += *r;
+            else
+                ++errorsB[static_cast<int>(r.error())];
+        }
+    };
+    /* 先各跑一遍预热，再计时 */
+    runExceptions();
+    runExpected();
+    double a = timeMs(runExceptions);
+    double b = timeMs(runExpected);
+    assert(sumA == sumB);
+    for (int k = 0; k < 4; ++k)
+        assert(errorsA[k] == errorsB[k]);
+
+    std::cout << "  error rate " << errorRate * 100 << "%: exceptions " << a * 1e6 / static_cast<double>(n)
+              << " ns/op, Expected " << b * 1e6 / static_cast<double>(n) << " ns/op (" << a / b << "x)" << std::endl;
+}
+
 int main() {
+    checkExpected();
+
+    /* 目标代码大小见CMake目标item14_code_size */
+    std::cout << ">>>> exceptions vs Expected<int, ParseErrc>, parse + range check + scale" << std::endl;
+    for (double rate : {0.0, 0.001, 0.01, 0.1, 0.5})
+        benchmarkErrorPaths(1000000, rate);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,88 @@
+/**
+ * @file Item14ErrorPaths.cpp
+ * @brief 同一段解析逻辑的异常版本和Expected版本
+ * @date 2026/10/18
+ */
+
+#include "Item14ErrorPaths.h"
+
+/* 0：两个版本都编译；1：只编译异常版本；2：只编译Expected版本 */
+#ifndef ITEM14_ERROR_CHANNEL
+#   define ITEM14_ERROR_CHANNEL 0
+#endif
+
+namespace {
+
+constexpr int MaxValue = 1000000;
+
+inline int scale(int v) noexcept {
+    return MaxValue / v + v % 7;
+}
+
+} // namespace
+
+#if ITEM14_ERROR_CHANNEL != 2
+namespace viaExceptions {
+namespace {
+
+int parseInt(const char* s) {
+    if (*s == '\0')
+        throw ParseFailure(ParseErrc::Empty);
+    long long v = 0;
+    for (; *s != '\0'; ++s) {
+        if (*s < '0' || *s > '9')
+            throw ParseFailure(ParseErrc::InvalidDigit);
+        v = v * 10 + (*s - '0');
+        if (v > 0x7fffffff)
+            throw ParseFailure(ParseErrc::Overflow);
+    }
+    return static_cast<int>(v);
+}
+
+int checkRange(int v) {
+    if (v < 1 || v > MaxValue)
+        throw ParseFailure(ParseErrc::OutOfRange);
+    return v;
+}
+
+} // namespace
+
+int score(const char* s) {
+    return scale(checkRange(parseInt(s)));
+}
+
+} // namespace viaExceptions
+#endif
+
+#if ITEM14_ERROR_CHANNEL != 1
+namespace viaExpected {
+namespace {
+
+Expected<int, ParseErrc> parseInt(const char* s) noexcept {
+    if (*s == '\0')
+        return makeUnexpected(ParseErrc::Empty);
+    long long v = 0;
+    for (; *s != '\0'; ++s) {
+        if (*s < '0' || *s > '9')
+            return makeUnexpected(ParseErrc::InvalidDigit);
+        v = v * 10 + (*s - '0');
+        if (v > 0x7fffffff)
+            return makeUnexpected(ParseErrc::Overflow);
+    }
+    return static_cast<int>(v);
+}
+
+Expected<int, ParseErrc> checkRange(int v) noexcept {
+    if (v < 1 || v > MaxValue)
+        return makeUnexpected(ParseErrc::OutOfRange);
+    return v;
+}
+
+} // namespace
+
+Expected<int, ParseErrc> score(const char* s) noexcept {
+    return parseInt(s).andThen(checkRange).transform(scale);
+}
+
+} // namespace viaExpected
+#endif
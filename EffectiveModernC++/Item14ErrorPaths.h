@@ -0,0 +1,39 @@
+/**
+ * @file Item14ErrorPaths.h
+ * @brief Item14的对照实验：同一段解析逻辑分别用异常和Expected报告错误
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <exception>
+
+#include "Expected.h"
+
+enum class ParseErrc {
+    Empty,
+    InvalidDigit,
+    Overflow,
+    OutOfRange
+};
+
+struct ParseFailure : std::exception {
+    explicit ParseFailure(ParseErrc code) noexcept : code(code) {}
+    const char* what() const noexcept override { return "parse failure"; }
+
+    ParseErrc code;
+};
+
+/*
+ * score(s)：把s解析成十进制整数，检查范围[1, 1000000]，再换算成一个分数。
+ * 两个版本放在单独的翻译单元里，调用方无法内联，比较的是真实的调用和错误传递开销；
+ * 用ITEM14_ERROR_CHANNEL=1或2只编译其中一个版本，可以比较目标代码的大小（CMake目标item14_code_size）
+ */
+namespace viaExceptions {
+/* 出错时抛出ParseFailure */
+int score(const char* s);
+} // namespace viaExceptions
+
+namespace viaExpected {
+Expected<int, ParseErrc> score(const char* s) noexcept;
+} // namespace viaExpected
@@ -11,6 +11,20 @@
  */
 
 #include <array>
+#include <chrono>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "ConstexprMath.h"
+#include "Item15Tables.h"
+#include "StaticPow.h"
+#include "PointCloud.h"
+#include "StaticKdTree.h"
 
 constexpr auto arraySize = 10;
 std::array<int, arraySize> vec;
@@ -21,13 +35,33 @@ std::array<int, arraySize> vec;
  * 在C++11中，constexpr函数被限制为只能包含不多于一个的执行语句，而在C++14中就没有了这个限制
  */
 
+/* 逐次递归，需要exp层递归和exp次乘法，exp稍大就会超过编译器的constexpr递归深度，也不检查溢出 */
+constexpr
+int powLinear(int base, int exp) noexcept {
+    return (exp == 0 ? 1 : base * powLinear(base, exp - 1));
+}
+
+/* C++14中改用平方求幂（见ConstexprMath.h），溢出或exp为负时抛出异常，在编译期求值则是编译错误 */
 constexpr
-int pow(int base, int exp) noexcept {
-    return (exp == 0 ? 1 : base * pow(base, exp - 1));
+int pow(int base, int exp) {
+    return exp < 0 ? throw std::domain_error("negative exponent") : ipow(base, static_cast<unsigned>(exp));
 }
 
 std::array<int, pow(2, 3)> arr;
 
+static_assert(pow(3, 19) == 1162261467, "");
+static_assert(pow(-2, 31) == std::numeric_limits<int>::min(), "");
+static_assert(ipow(std::uint64_t(10), 19) == 10000000000000000000ull, "");
+/* 只需要30次乘法；powLinear(1, 1000000000)会超过递归深度 */
+static_assert(ipow(1, 1000000000u) == 1, "");
+/* 下面两行无法通过编译：2^31超出int的范围 */
+// static_assert(pow(2, 31) > 0, "");
+// constexpr auto bad = ipow(std::int64_t(3), 40);
+
+/* 指数是编译期常量时，pow<Exp>在编译期选好乘法链：x^15 = (x^3)^5只要5次乘法，二进制法需要6次 */
+static_assert(pow<15>(2) == 32768 && pow<0>(7) == 1 && pow<-2>(2.0) == 0.25, "");
+static_assert(powMultiplications<15>() == 5 && powMultiplications<16>() == 4 && powMultiplications<33>() == 6, "");
+
 /*
  * constexpr函数仅限于传入和返回字面型别，也就是在编译期可以决定的值（void不属于这种类型，其余所有内建类型都属于）
  * 但是用户的自定义类也可以属于字面型别
@@ -47,6 +81,423 @@ private:
     double x, y;
 };
 
-int main() {
+template <typename F>
+double timeMs(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/* 运行期的正确性检查：与逐次相乘、按位计算的结果对比 */
+void checkTables() {
+    for (int b = -5; b <= 5; ++b)
+        for (int e = 0; e <= 12; ++e)
+            assert(pow(b, e) == powLinear(b, e));
+
+    bool overflow = false;
+    try {
+        volatile int e = 40;
+        pow(3, e);
+    } catch (const std::overflow_error&) {
+        overflow = true;
+    }
+    assert(overflow);
+
+    /* "123456789"的CRC-32是标准的校验值 */
+    assert(crc32("123456789", 9) == 0xCBF43926u);
+
+    const auto& sinTable = SinTable::value;
+    for (std::size_t i = 0; i < sinTable.size(); ++i)
+        assert(std::abs(sinTable[i] - std::lround(std::sin(2 * detail::Pi * i / 4096) * 65536)) <= 1);
+}
+
+std::uint32_t crc32Bitwise(const unsigned char* p, std::size_t len) {
+    std::uint32_t crc = ~0u;
+    for (std::size_t i = 0; i < len; ++i) {
+        crc ^= p[i];
+        for (int k = 0; k < 8; ++k)
+            crc = (crc & 1u) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+    }
+    return ~crc;
+}
+
+void benchmarkTables() {
+    const std::size_t n = 1 << 24;
+    std::mt19937 rng(15);
+    std::vector<int> exps(n);
+    for (auto& e : exps)
+        e = static_cast<int>(rng() % 20);
+    std::vector<unsigned char> bytes(n);
+    for (auto& b : bytes)
+        b = static_cast<unsigned char>(rng());
+
+    volatile std::int64_t sink = 0;
+    std::cout << "  " << n << " x 3^e (e < 20):";
+    std::cout << " powLinear " << timeMs([&] {
+        std::int64_t s = 0;
+        for (int e : exps)
+            s += powLinear(3, e);
+        sink = s;
+    }) << " ms";
+    std::cout << ", pow " << timeMs([&] {
+        std::int64_t s = 0;
+        for (int e : exps)
+            s += pow(3, e);
+        sink = s;
+    }) << " ms";
+    constexpr auto pow3 = makeTable<20>(PowerOf<int, 3>());
+    std::cout << ", table " << timeMs([&] {
+        std::int64_t s = 0;
+        for (int e : exps)
+            s += pow3[e];
+        sink = s;
+    }) << " ms" << std::endl;
+
+    std::cout << "  crc32 of " << (n >> 20) << " MB: bitwise " << timeMs([&] {
+        sink = crc32Bitwise(bytes.data(), n);
+    }) << " ms, table " << timeMs([&] { sink = crc32(bytes.data(), n); }) << " ms" << std::endl;
+
+    std::cout << "  " << n << " x 10-bit reversal: loop " << timeMs([&] {
+        std::int64_t s = 0;
+        for (std::size_t i = 0; i < n; ++i)
+            s += BitReverse<10>()(bytes[i] * 4 + (i & 3));
+        sink = s;
+    }) << " ms";
+    const auto& rev = StaticTable<BitReverse<10>, 1024>::value;
+    std::cout << ", table " << timeMs([&] {
+        std::int64_t s = 0;
+        for (std::size_t i = 0; i < n; ++i)
+            s += rev[bytes[i] * 4 + (i & 3)];
+        sink = s;
+    }) << " ms" << std::endl;
+
+    const auto& sinTable = SinTable::value;
+    std::cout << "  " << n << " x sin: std::sin " << timeMs([&] {
+        double s = 0;
+        for (std::size_t i = 0; i < n; ++i)
+            s += std::sin(2 * detail::Pi * ((i * 7) & 4095) / 4096);
+        sink = static_cast<std::int64_t>(s);
+    }) << " ms, Q16 table " << timeMs([&] {
+        std::int64_t s = 0;
+        for (std::size_t i = 0; i < n; ++i)
+            s += sinTable[(i * 7) & 4095];
+        sink = s;
+    }) << " ms" << std::endl;
+}
+
+void checkStaticPow() {
+    for (int e = 0; e <= 40; ++e) {
+        for (double x : {0.5, 1.0, 1.0001, 3.0, -2.5}) {
+            double expect = std::pow(x, e);
+            assert(std::abs(powDispatch(x, e) - expect) <= 1e-12 * std::abs(expect));
+        }
+        if (e <= 19)
+            assert(powDispatch(3, e) == powLinear(3, e));
+    }
+    std::vector<float> in{1.5f, -2.0f, 0.25f}, out(3);
+    powDispatch(in.data(), out.data(), in.size(), 3);
+    assert(out[0] == 1.5f * 1.5f * 1.5f && out[1] == -8.0f && out[2] == 0.015625f);
+
+    /* 整数没有负指数，即使底数是0或±1也不能返回结果 */
+    assert(powDispatch(0.5, -2) == 4.0);
+    for (int x : {0, 1, -1, 2}) {
+        for (int e : {-1, -3}) {
+            bool thrown = false;
+            try {
+                powDispatch(x, e);
+            } catch (const std::domain_error&) {
+                thrown = true;
+            }
+            assert(thrown);
+        }
+    }
+    std::vector<int> ints{1, 2}, intsOut(2);
+    bool thrown = false;
+    try {
+        powDispatch(ints.data(), intsOut.data(), ints.size(), -1);
+    } catch (const std::domain_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+/*
+ * 指数在运行期才知道、但只是几个小整数之一：
+ * - 逐元素分派：每个元素通过跳转表做一次间接调用
+ * - 整个数组一次分派：循环体是展开的乘法链，可以向量化
+ */
+void benchmarkStaticPow() {
+    const std::size_t n = 1 << 24;
+    std::mt19937 rng(34);
+    std::vector<double> x(n), y(n);
+    std::vector<int> xi(n), yi(n), exps(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        x[i] = 0.5 + (rng() % 1000) / 1000.0;
+        xi[i] = static_cast<int>(rng() % 4);
+        exps[i] = static_cast<int>(rng() % 16);
+    }
+
+    std::cout << "  " << n << " doubles, random exponent < 16: std::pow " << timeMs([&] {
+        for (std::size_t i = 0; i < n; ++i)
+            y[i] = std::pow(x[i], exps[i]);
+    }) << " ms, powDispatch " << timeMs([&] {
+        for (std::size_t i = 0; i < n; ++i)
+            y[i] = powDispatch(x[i], exps[i]);
+    }) << " ms" << std::endl;
 
+    for (int e : {2, 3, 7, 15}) {
+        volatile int ve = e;
+        std::cout << "  " << n << " doubles, x^" << e << ": std::pow " << timeMs([&] {
+            int exp = ve;
+            for (std::size_t i = 0; i < n; ++i)
+                y[i] = std::pow(x[i], exp);
+        }) << " ms, powDispatch per element " << timeMs([&] {
+            int exp = ve;
+            for (std::size_t i = 0; i < n; ++i)
+                y[i] = powDispatch(x[i], exp);
+        }) << " ms, powDispatch per array " << timeMs([&] {
+            powDispatch(x.data(), y.data(), n, ve);
+        }) << " ms" << std::endl;
+    }
+
+    std::cout << "  " << n << " ints, random exponent < 16: powLinear " << timeMs([&] {
+        for (std::size_t i = 0; i < n; ++i)
+            yi[i] = powLinear(xi[i], exps[i]);
+    }) << " ms, pow " << timeMs([&] {
+        for (std::size_t i = 0; i < n; ++i)
+            yi[i] = pow(xi[i], exps[i]);
+    }) << " ms, powDispatch " << timeMs([&] {
+        for (std::size_t i = 0; i < n; ++i)
+            yi[i] = powDispatch(xi[i], exps[i]);
+    }) << " ms" << std::endl;
+}
+
+/* 编译期生成的参考点集：用splitmix64把下标散列成[0, 1000)内的坐标 */
+struct ReferencePoint {
+    static constexpr std::uint64_t mix(std::uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    constexpr Point operator()(std::size_t i) const {
+        std::uint64_t h = mix(i * 0x9E3779B97F4A7C15ull + 1);
+        return Point((h & 0xFFFFF) % 100000 / 100.0, ((h >> 20) & 0xFFFFF) % 100000 / 100.0);
+    }
+};
+
+constexpr std::size_t ReferenceCount = 2048;
+constexpr auto referencePoints = makeTable<ReferenceCount>(ReferencePoint());
+/* 整棵树在编译期建好，放在只读数据区，程序启动时不需要任何构建 */
+constexpr auto referenceTree = makeStaticKdTree(referencePoints);
+
+constexpr std::size_t bruteNearest(const Point& q) {
+    std::size_t best = 0;
+    double bestD = std::numeric_limits<double>::infinity();
+    for (std::size_t i = 0; i < ReferenceCount; ++i) {
+        double dx = referencePoints[i].xValue() - q.xValue(), dy = referencePoints[i].yValue() - q.yValue();
+        if (dx * dx + dy * dy < bestD) {
+            bestD = dx * dx + dy * dy;
+            best = i;
+        }
+    }
+    return best;
+}
+
+/* 查询同样可以在编译期求值 */
+static_assert(referenceTree.nearest(Point(500, 500)) == bruteNearest(Point(500, 500)), "");
+static_assert(referenceTree.countInRange(Point(0, 0), Point(1000, 1000)) == ReferenceCount, "");
+
+void checkKdTree() {
+    std::mt19937 rng(36);
+    for (int k = 0; k < 2000; ++k) {
+        Point q(rng() % 120000 / 100.0 - 100, rng() % 120000 / 100.0 - 100);
+        assert(referenceTree.nearest(q) == bruteNearest(q));
+
+        Point lo(rng() % 1000, rng() % 1000);
+        Point hi(lo.xValue() + rng() % 200, lo.yValue() + rng() % 200);
+        std::size_t expect = 0;
+        for (const auto& p : referencePoints)
+            expect += p.xValue() >= lo.xValue() && p.xValue() <= hi.xValue() && p.yValue() >= lo.yValue() &&
+                      p.yValue() <= hi.yValue();
+        std::size_t found = 0;
+        referenceTree.forEachInRange(lo, hi, [&](std::size_t i, const Point& p) {
+            assert(referencePoints[i].xValue() == p.xValue() && referencePoints[i].yValue() == p.yValue());
+            ++found;
+        });
+        assert(found == expect && referenceTree.countInRange(lo, hi) == expect);
+    }
+}
+
+void benchmarkKdTree() {
+    using Tree = StaticKdTree<Point, ReferenceCount>;
+    std::unique_ptr<Tree> runtimeTree;
+    double build = timeMs([&] { runtimeTree.reset(new Tree(referencePoints)); });
+    std::cout << "  startup: compile-time tree 0 ms (" << sizeof(Tree) << " bytes of read-only data), runtime build "
+              << build << " ms" << std::endl;
+
+    const std::size_t queries = 1 << 20;
+    std::mt19937 rng(37);
+    std::vector<Point> qs;
+    for (std::size_t i = 0; i < queries; ++i)
+        qs.emplace_back(rng() % 100000 / 100.0, rng() % 100000 / 100.0);
+
+    volatile std::size_t sink = 0;
+    auto nearestRate = [&](const Tree& tree) {
+        return queries / timeMs([&] {
+            std::size_t s = 0;
+            for (const auto& q : qs)
+                s += tree.nearest(q);
+            sink = s;
+        }) / 1000;
+    };
+    auto rangeRate = [&](const Tree& tree) {
+        return queries / timeMs([&] {
+            std::size_t s = 0;
+            for (const auto& q : qs)
+                s += tree.countInRange(q, Point(q.xValue() + 20, q.yValue() + 20));
+            sink = s;
+        }) / 1000;
+    };
+    std::cout << "  " << ReferenceCount << " points, Mqueries/s: nearest compile-time " << nearestRate(referenceTree)
+              << ", runtime-built " << nearestRate(*runtimeTree) << "; 20x20 range compile-time "
+              << rangeRate(referenceTree) << ", runtime-built " << rangeRate(*runtimeTree) << "; brute-force nearest "
+              << queries / 16 / timeMs([&] {
+                     std::size_t s = 0;
+                     for (std::size_t i = 0; i < queries / 16; ++i)
+                         s += bruteNearest(qs[i]);
+                     sink = s;
+                 }) / 1000
+              << std::endl;
+}
+
+/* PointCloud的代理与Point用法相同 */
+void checkPointCloud() {
+    PointCloud<Point> cloud;
+    std::vector<Point> points;
+    std::mt19937 rng(35);
+    for (int i = 0; i < 1003; ++i) {
+        Point p(rng() % 2000 / 10.0 - 100, rng() % 2000 / 10.0 - 100);
+        cloud.push_back(p);
+        points.push_back(p);
+    }
+    cloud[5].setX(250);
+    points[5].setX(250);
+    assert(cloud[5].xValue() == 250 && static_cast<Point>(cloud[5]).yValue() == points[5].yValue());
+
+    cloud.translate(1, -2);
+    cloud.scale(2, 0.5);
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        assert(cloud[i].xValue() == (points[i].xValue() + 1) * 2);
+        assert(cloud[i].yValue() == (points[i].yValue() - 2) * 0.5);
+    }
+
+    auto box = cloud.boundingBox();
+    assert(box.second.xValue() == 502);
+    Point q(3, 4);
+    auto dist = [&](std::size_t j) {
+        double dx = cloud[j].xValue() - q.xValue(), dy = cloud[j].yValue() - q.yValue();
+        return dx * dx + dy * dy;
+    };
+    std::size_t best = 0;
+    for (std::size_t i = 1; i < cloud.size(); ++i)
+        if (dist(i) < dist(best))
+            best = i;
+    assert(cloud.nearest(q) == best);
+
+    cloud.rotate(detail::Pi / 2);
+    assert(std::abs(cloud[5].yValue() - 502) < 1e-9);
+    assert(PointCloud<Point>().nearest(q) == PointCloud<Point>::npos);
+
+    /* 代理之间赋值、交换的是坐标 */
+    PointCloud<Point> pair;
+    pair.push_back(Point(1, 2));
+    pair.push_back(Point(3, 4));
+    pair[0] = pair[1];
+    assert(pair[0].xValue() == 3 && pair[0].yValue() == 4);
+    pair[1] = Point(5, 6);
+    using std::swap;
+    swap(pair[0], pair[1]);
+    assert(pair[0].xValue() == 5 && pair[0].yValue() == 6 && pair[1].xValue() == 3 && pair[1].yValue() == 4);
+}
+
+/* 同样的操作分别作用在std::vector<Point>（AoS）和PointCloud（SoA）上 */
+void benchmarkPointCloud(std::size_t n) {
+    std::mt19937 rng(36);
+    std::vector<Point> aos;
+    PointCloud<Point> soa;
+    aos.reserve(n);
+    soa.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        Point p(rng() % 100000 / 100.0, rng() % 100000 / 100.0);
+        aos.push_back(p);
+        soa.push_back(p);
+    }
+    const double c = std::cos(0.1), s = std::sin(0.1);
+    volatile double sink = 0;
+
+    std::cout << "  n = " << n << " (ms, AoS / SoA)" << std::endl;
+    std::cout << "    translate " << timeMs([&] {
+        for (auto& p : aos) {
+            p.setX(p.xValue() + 1.5);
+            p.setY(p.yValue() - 0.5);
+        }
+    }) << " / " << timeMs([&] { soa.translate(1.5, -0.5); }) << std::endl;
+    std::cout << "    scale " << timeMs([&] {
+        for (auto& p : aos) {
+            p.setX(p.xValue() * 1.01);
+            p.setY(p.yValue() * 0.99);
+        }
+    }) << " / " << timeMs([&] { soa.scale(1.01, 0.99); }) << std::endl;
+    std::cout << "    rotate " << timeMs([&] {
+        for (auto& p : aos) {
+            double x = p.xValue(), y = p.yValue();
+            p.setX(x * c - y * s);
+            p.setY(x * s + y * c);
+        }
+    }) << " / " << timeMs([&] { soa.rotate(0.1); }) << std::endl;
+    std::cout << "    bounding box " << timeMs([&] {
+        double minX = aos[0].xValue(), minY = aos[0].yValue(), maxX = minX, maxY = minY;
+        for (const auto& p : aos) {
+            minX = std::min(minX, p.xValue());
+            minY = std::min(minY, p.yValue());
+            maxX = std::max(maxX, p.xValue());
+            maxY = std::max(maxY, p.yValue());
+        }
+        sink = minX + minY + maxX + maxY;
+    }) << " / " << timeMs([&] {
+        auto box = soa.boundingBox();
+        sink = box.first.xValue() + box.second.yValue();
+    }) << std::endl;
+    Point q(500, 500);
+    std::cout << "    nearest " << timeMs([&] {
+        std::size_t best = 0;
+        double bestD = std::numeric_limits<double>::infinity();
+        for (std::size_t i = 0; i < aos.size(); ++i) {
+            double dx = aos[i].xValue() - q.xValue(), dy = aos[i].yValue() - q.yValue();
+            double d = dx * dx + dy * dy;
+            if (d < bestD) {
+                bestD = d;
+                best = i;
+            }
+        }
+        sink = static_cast<double>(best);
+    }) << " / " << timeMs([&] { sink = static_cast<double>(soa.nearest(q)); }) << std::endl;
+}
+
+int main() {
+    checkTables();
+    checkStaticPow();
+    checkPointCloud();
+    checkKdTree();
+    std::cout << ">>>> lookup tables vs runtime computation" << std::endl;
+    benchmarkTables();
+    std::cout << ">>>> pow<Exp> and runtime dispatch" << std::endl;
+    benchmarkStaticPow();
+    std::cout << ">>>> PointCloud (SoA) vs std::vector<Point> (AoS), " << simdLevelName(detectSimdLevel())
+              << std::endl;
+    benchmarkPointCloud(1 << 16);
+    benchmarkPointCloud(1 << 22);
+    std::cout << ">>>> compile-time k-d tree" << std::endl;
+    benchmarkKdTree();
 }
@@ -0,0 +1,11 @@
+/**
+ * @file Item15Tables.cpp
+ * @brief 只用于测量编译时间：ITEM15_TABLES为0时只包含ConstexprMath.h，为1时再生成Item15的查找表
+ * @date 2026/10/18
+ */
+
+#include "ConstexprMath.h"
+
+#if ITEM15_TABLES
+#include "Item15Tables.h"
+#endif
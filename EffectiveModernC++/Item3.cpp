@@ -7,12 +7,26 @@
 #include <type_traits>
 #include <iostream>
 #include <vector>
+#include <deque>
+#include <memory>
+#include <cstdlib>
+#include <typeinfo>
+#include <new>
+#include <atomic>
+#include <chrono>
+#include <cassert>
+#include <random>
+#include <stdexcept>
 
 #ifndef _MSC_VER
 #   include <cxxabi.h>
 #endif
 #include <string>
 
+#include "AllocCounter.h"
+#include "Drain.h"
+#include "GatherAccess.h"
+
 /* Reference from https://stackoverflow.com/questions/81870/is-it-possible-to-print-a-variables-type-in-standard-c */
 template <class T>
 std::string
@@ -89,6 +103,289 @@ auto authAndAccessRV11(Container&& c, Index i) -> decltype(std::forward<Containe
     return std::forward<Container>(c)[i];
 }
 
+template <typename F>
+void measure(const char* name, F&& f) {
+    std::size_t a0 = allocCount.load(), f0 = freeCount.load();
+    auto start = std::chrono::steady_clock::now();
+    f();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "    " << name << ": " << ms << " ms, " << allocCount.load() - a0 << " allocations, "
+              << freeCount.load() - f0 << " frees" << std::endl;
+}
+
+/* 超过短字符串优化的长度，拷贝一次就要分配一次 */
+template <typename Container>
+Container makeStrings(std::size_t n) {
+    Container c;
+    for (std::size_t i = 0; i < n; ++i)
+        c.push_back(std::string(40, 'a' + static_cast<char>(i % 26)));
+    return c;
+}
+
+/*
+ * 从临时容器中取出多个元素：反复调用authAndAccessRV14（每次得到左值引用，只能拷贝）vs drain
+ */
+template <typename Container>
+void benchmarkDrain(const char* name, std::size_t n) {
+    std::vector<std::size_t> every4;
+    for (std::size_t i = 0; i < n; i += 4)
+        every4.push_back(i);
+
+    std::cout << "  " << name << ", n = " << n << ", taking every 4th element" << std::endl;
+    {
+        auto c = makeStrings<Container>(n);
+        std::vector<std::string> out;
+        measure("authAndAccessRV14 loop", [&] {
+            out.reserve(every4.size());
+            for (std::size_t i : every4)
+                out.push_back(authAndAccessRV14(std::move(c), i));
+            Container().swap(c);
+        });
+    }
+    {
+        auto c = makeStrings<Container>(n);
+        std::vector<std::string> out;
+        measure("drain", [&] { out = drain(std::move(c), every4); });
+    }
+
+    std::cout << "  " << name << ", n = " << n << ", taking all elements" << std::endl;
+    {
+        auto c = makeStrings<Container>(n);
+        std::vector<std::string> out;
+        measure("authAndAccessRV14 loop", [&] {
+            out.reserve(n);
+            for (std::size_t i = 0; i < n; ++i)
+                out.push_back(authAndAccessRV14(std::move(c), i));
+            Container().swap(c);
+        });
+    }
+    {
+        auto c = makeStrings<Container>(n);
+        std::vector<std::string> out;
+        measure("drainAll", [&] {
+            out.reserve(n);
+            drainAll(std::move(c), std::back_inserter(out));
+        });
+    }
+}
+
+void checkDrain() {
+    std::vector<std::string> v{"alpha", "beta", "gamma", "delta"};
+    auto picked = drain(std::move(v), std::vector<std::size_t>{2, 0});
+    assert((picked == std::vector<std::string>{"gamma", "alpha"}));
+
+    std::deque<std::unique_ptr<int>> d;
+    for (int i = 0; i < 3; ++i)
+        d.emplace_back(new int(i));
+    std::vector<std::unique_ptr<int>> taken;
+    drainAll(std::move(d), std::back_inserter(taken));
+    assert(taken.size() == 3 && *taken[2] == 2);
+
+    std::string s = "hello";
+    std::string chars;
+    drain(std::move(s), std::vector<std::size_t>{4, 1}, std::back_inserter(chars));
+    assert(chars == "oe");
+
+    bool thrown = false;
+    std::vector<std::string> w{"x"};
+    try {
+        drain(std::move(w), std::vector<std::size_t>{0, 1});
+    } catch (const std::out_of_range&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    int sum = 0;
+    for (auto&& p : consume(std::move(taken)))
+        sum += *p;
+    assert(sum == 3);
+}
+
+/* 模拟authAndAccess中的用户认证，计数器保证调用不会被优化掉 */
+static volatile std::size_t authCount = 0;
+
+void authenticateUser() {
+    authCount = authCount + 1;
+}
+
+/*
+ * 单个元素的版本：每次调用都认证并检查下标
+ */
+template <typename Container, typename Index>
+decltype(auto) authAndAccessChecked(Container& c, Index i) {
+    authenticateUser();
+    if (static_cast<std::size_t>(i) >= c.size())
+        throw std::out_of_range("authAndAccessChecked: index out of range");
+    return c[i];
+}
+
+/* 能否用这样的下标实参调用authAndAccessBatch（Args为空或者认证函数）：右值下标对应的重载被删除 */
+template <typename Indices, typename... Args>
+auto canBatch(int) -> decltype(authAndAccessBatch(std::declval<std::vector<int>&>(), std::declval<Indices>(),
+                                                  std::declval<Args>()...),
+                               std::true_type());
+
+template <typename Indices, typename... Args>
+std::false_type canBatch(...);
+
+using AuthFn = void (*)();
+static_assert(decltype(canBatch<std::vector<int>&>(0))::value, "lvalue indices are accepted");
+static_assert(decltype(canBatch<std::vector<int>&, AuthFn>(0))::value, "lvalue indices are accepted");
+static_assert(!decltype(canBatch<std::vector<int>>(0))::value, "temporary indices would dangle in BatchAccess");
+static_assert(!decltype(canBatch<std::vector<int>, AuthFn>(0))::value, "temporary indices would dangle in BatchAccess");
+
+void checkGather() {
+    std::mt19937 rng(3);
+    for (std::size_t n : {0u, 1u, 15u, 16u, 17u, 100u, 1001u}) {
+        std::vector<std::uint32_t> idx32(n);
+        std::vector<std::int64_t> idx64(n);
+        for (std::size_t k = 0; k < n; ++k)
+            idx64[k] = idx32[k] = rng() % 5000;
+        for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512}) {
+            if (level > detectSimdLevel())
+                continue;
+            std::uint32_t m = 0;
+            for (std::uint32_t i : idx32)
+                m = std::max(m, i);
+            assert(maxIndexWith(level, idx32.data(), n) == m);
+            assert(maxIndexWith(level, idx64.data(), n) == m);
+        }
+    }
+    /* 负下标按无符号比较是一个很大的数 */
+    std::vector<int> negative{1, 2, -1, 3};
+    assert(maxIndex(negative.data(), negative.size()) == static_cast<unsigned>(-1));
+
+    std::vector<int> ints(5000);
+    std::vector<double> doubles(5000);
+    for (int i = 0; i < 5000; ++i) {
+        ints[i] = i * 7 - 100;
+        doubles[i] = i * 0.25;
+    }
+    for (std::size_t n : {0u, 3u, 16u, 37u, 1000u}) {
+        std::vector<std::uint32_t> idx32(n);
+        std::vector<std::uint64_t> idx64(n);
+        for (std::size_t k = 0; k < n; ++k)
+            idx64[k] = idx32[k] = rng() % 5000;
+        for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512}) {
+            if (level > detectSimdLevel())
+                continue;
+            for (bool prefetch : {false, true}) {
+                std::vector<int> oi(n), oi64(n);
+                std::vector<double> od(n), od64(n);
+                simdGatherWith(level, ints.data(), ints.size(), idx32.data(), n, oi.data(), prefetch);
+                simdGatherWith(level, ints.data(), ints.size(), idx64.data(), n, oi64.data(), prefetch);
+                simdGatherWith(level, doubles.data(), doubles.size(), idx32.data(), n, od.data(), prefetch);
+                simdGatherWith(level, doubles.data(), doubles.size(), idx64.data(), n, od64.data(), prefetch);
+                for (std::size_t k = 0; k < n; ++k) {
+                    assert(oi[k] == ints[idx32[k]] && oi64[k] == ints[idx32[k]]);
+                    assert(od[k] == doubles[idx32[k]] && od64[k] == doubles[idx32[k]]);
+                }
+            }
+        }
+    }
+
+    /* 认证只调用一次，单个元素的引用语义保持不变 */
+    std::vector<std::size_t> idx{4, 0, 4};
+    std::size_t before = authCount;
+    auto batch = authAndAccessBatch(ints, idx, authenticateUser);
+    assert(authCount == before + 1);
+    static_assert(std::is_same<decltype(batch[0]), int&>::value, "batch[k] should be int&");
+    batch[1] = 42;
+    assert(ints[0] == 42 && batch.gather() == (std::vector<int>{ints[4], 42, ints[4]}));
+
+    /* 非连续容器和非平凡元素逐个访问 */
+    std::deque<std::string> names{"a", "b", "c"};
+    std::vector<int> nameIdx{2, 1};
+    std::vector<std::string> picked;
+    authAndAccessBatch(names, nameIdx).gather(std::back_inserter(picked));
+    assert((picked == std::vector<std::string>{"c", "b"}));
+
+    bool thrown = false;
+    try {
+        authAndAccessBatch(names, negative);
+    } catch (const std::out_of_range&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    /* 2字节和1字节的负下标在表大于65535或255项时也要拒绝 */
+    std::vector<int> large(70000);
+    for (auto shortIdx : {std::vector<short>{-1}, std::vector<short>{3, -2, 300}}) {
+        thrown = false;
+        try {
+            authAndAccessBatch(large, shortIdx);
+        } catch (const std::out_of_range&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+    std::vector<signed char> charIdx{1, -1};
+    thrown = false;
+    try {
+        authAndAccessBatch(large, charIdx);
+    } catch (const std::out_of_range&) {
+        thrown = true;
+    }
+    assert(thrown);
+    std::vector<short> shortIdx{0, 32767};
+    assert(authAndAccessBatch(large, shortIdx).gather() == (std::vector<int>{0, 0}));
+}
+
+/*
+ * 按一批随机下标取元素：逐个调用authAndAccess（不检查/每次认证并检查）vs authAndAccessBatch
+ */
+template <typename T>
+void benchmarkGather(std::size_t tableSize, std::size_t batchSize) {
+    std::mt19937 rng(7);
+    std::vector<T> table(tableSize);
+    for (std::size_t i = 0; i < tableSize; ++i)
+        table[i] = static_cast<T>(i);
+    std::vector<std::uint32_t> idx(batchSize);
+    for (auto& i : idx)
+        i = static_cast<std::uint32_t>(rng() % tableSize);
+    std::vector<T> out(batchSize);
+    /* 和不超过2^53，用double累加是精确的 */
+    double expect = 0;
+    for (auto i : idx)
+        expect += table[i];
+    auto verify = [&] {
+        double sum = 0;
+        for (T x : out)
+            sum += x;
+        assert(sum == expect);
+        std::fill(out.begin(), out.end(), T());
+    };
+
+    std::cout << "  " << sizeof(T) << "-byte elements, table " << tableSize * sizeof(T) / 1024 << " KB, batch "
+              << batchSize << std::endl;
+    measure("authAndAccess loop (unchecked)", [&] {
+        for (std::size_t k = 0; k < batchSize; ++k)
+            out[k] = authAndAccess(table, idx[k]);
+    });
+    verify();
+    measure("authAndAccessChecked loop", [&] {
+        for (std::size_t k = 0; k < batchSize; ++k)
+            out[k] = authAndAccessChecked(table, idx[k]);
+    });
+    verify();
+    measure("authAndAccessBatch", [&] { authAndAccessBatch(table, idx, authenticateUser).gather(out.data()); });
+    verify();
+    for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (level > detectSimdLevel())
+            continue;
+        for (bool prefetch : {false, true}) {
+            std::string name = std::string("  check + gather ") + simdLevelName(level) +
+                               (prefetch ? " + prefetch" : "");
+            measure(name.c_str(), [&] {
+                if (maxIndexWith(level, idx.data(), idx.size()) >= table.size())
+                    throw std::out_of_range("index out of range");
+                simdGatherWith(level, table.data(), table.size(), idx.data(), idx.size(), out.data(), prefetch);
+            });
+            verify();
+        }
+    }
+}
+
 /**
  * - 可以使用decltype得到变量的直接类型
  * - 可以在c++11的"返回值型别尾序语法"中使用形参来指定函数返回值的类型，但是在c++14中，直接使用auto（即值传递）会导致出现一些错误（右值引用）
@@ -116,4 +413,24 @@ int main() {
     std::cout << type_name<decltype((x))>() << std::endl;
     std::cout << type_name<decltype(((x)))>() << std::endl;
 
+    /*
+     * 对右值容器调用authAndAccessRV14，返回的仍然是T&（vector的operator[]没有右值重载），取出的元素只能拷贝。
+     * 需要从临时容器中取出多个元素时，使用Drain.h中的drain/drainAll/consume，元素被移动出来
+     */
+    std::cout << type_name<decltype(authAndAccessRV14(std::vector<std::string>(), 0))>() << std::endl;
+    checkDrain();
+    std::cout << ">>>> draining rvalue containers" << std::endl;
+    benchmarkDrain<std::vector<std::string>>("std::vector<std::string>", 1000000);
+    benchmarkDrain<std::deque<std::string>>("std::deque<std::string>", 1000000);
+
+    /*
+     * 按一批下标访问时，authAndAccessBatch只认证和检查一次，BatchAccess[k]与authAndAccess(c, indices[k])一样返回引用，
+     * gather把整批元素取出来，连续存放的4/8字节元素用硬件gather
+     */
+    checkGather();
+    std::cout << ">>>> batch access with " << simdLevelName(detectSimdLevel()) << std::endl;
+    benchmarkGather<std::int32_t>(std::size_t(1) << 14, std::size_t(1) << 22);
+    benchmarkGather<std::int32_t>(std::size_t(1) << 24, std::size_t(1) << 22);
+    benchmarkGather<double>(std::size_t(1) << 13, std::size_t(1) << 22);
+    benchmarkGather<double>(std::size_t(1) << 23, std::size_t(1) << 22);
 }
\ No newline at end of file
@@ -9,6 +9,10 @@
 #include <thread>
 #include <iostream>
 #include <future>
+#include <atomic>
+#include <chrono>
+
+#include "PerfScope.h"
 
 
 class Notify {
@@ -134,11 +138,71 @@ public:
 
 };
 
+/**
+ * 用PerfScope量化上面几种方式在反应线程一侧的开销：检测线程先睡眠waitMs毫秒再通知，
+ * 反应线程等待期间的周期数、指令数和上下文切换次数按方式汇总。
+ * 轮询标志位的线程在整个等待期间都在执行指令；条件变量和期值让线程休眠，代价是上下文切换。
+ * 反应任务不占用线程的协程版本见Item39Coroutine.cpp（需要C++20）
+ */
+void measureWaits(int rounds, int waitMs) {
+    /* 每一轮先调用reset准备好一次性的通知，再启动两个线程 */
+    auto run = [&](auto&& reset, auto&& wait, auto&& notify) {
+        for (int r = 0; r < rounds; ++r) {
+            reset();
+            std::thread react([&] { wait(); });
+            std::thread check([&] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(waitMs));
+                notify();
+            });
+            check.join();
+            react.join();
+        }
+    };
+
+    std::mutex m;
+    std::condition_variable cv;
+    bool flag = false;
+    run([&] { flag = false; }, [&] {
+        PerfScope scope("wait: condition variable + flag");
+        std::unique_lock<std::mutex> lk(m);
+        cv.wait(lk, [&] { return flag; });
+    }, [&] {
+        {
+            std::lock_guard<std::mutex> g(m);
+            flag = true;
+        }
+        cv.notify_one();
+    });
+
+    std::atomic<bool> atomicFlag{false};
+    run([&] { atomicFlag = false; }, [&] {
+        PerfScope scope("wait: polling std::atomic<bool>");
+        while (!atomicFlag)
+            ;
+    }, [&] { atomicFlag = true; });
+
+    /* std::promise只能使用一次，每轮重新创建，共享状态每次都要在堆上分配 */
+    std::promise<void> p;
+    std::future<void> f;
+    run([&] {
+        p = std::promise<void>();
+        f = p.get_future();
+    }, [&] {
+        PerfScope scope("wait: std::future<void>");
+        f.wait();
+    }, [&] { p.set_value(); });
+
+    PerfScope::report();
+}
+
 int main() {
     Notify c;
     c.useCV();
     c.useBool();
     c.useBoolAndMutex();
     c.usePromise();
+
+    std::cout << ">>>> waiting cost of the reacting thread, hardware counters" << std::endl;
+    measureWaits(20, 10);
 }
 
@@ -0,0 +1,283 @@
+/**
+ * @file Item39Coroutine.cpp
+ * @brief Item39的一次性事件通知改用C++20协程：反应任务挂起时不占用线程，对比每个等待者的内存和唤醒延迟
+ * @date 2026/10/18
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AllocCounter.h"
+#include "Coroutine.h"
+
+/*
+ * 只在C++20模式下构建：cmake -DCPPNOTE_COROUTINES=ON
+ * 协程帧和std::promise的共享状态都从全局operator new分配，AllocCounter.h中的allocBytes统计它们的字节数
+ */
+
+/* 反应任务：等待事件，之后在scheduler上继续 */
+Task<> reactOnce(OneShotEvent& event, Scheduler& scheduler) {
+    co_await event.wait(scheduler);
+    std::cout << "react!" << std::endl;
+}
+
+Task<> reactInline(OneShotEvent& event) {
+    co_await event;
+    std::cout << "react!" << std::endl;
+}
+
+/**
+ * 与Notify::usePromise相同的检测/反应流程，反应任务是一个协程。
+ * 即使检测任务先触发事件，反应任务之后co_await也会直接继续，不会像条件变量那样丢失通知
+ */
+void useEvent() {
+    std::cout << ">>>> Use OneShotEvent to notify the coroutine" << std::endl;
+    OneShotEvent event;
+    SingleThreadScheduler scheduler;
+    scheduler.spawn(reactOnce(event, scheduler));
+    /* 反应任务运行到co_await处挂起，run返回，没有线程被阻塞 */
+    scheduler.run();
+
+    std::thread check([&] {
+        std::cout << "check!" << std::endl;
+        event.set();
+    });
+    check.join();
+    scheduler.run();
+
+    std::cout << ">>>> Set the event before the coroutine waits" << std::endl;
+    OneShotEvent early;
+    early.set();
+    scheduler.spawn(reactInline(early));
+    scheduler.run();
+}
+
+/* Task<T>的结果和异常都通过co_await传回 */
+Task<int> answer(OneShotEvent& ready) {
+    co_await ready;
+    co_return 42;
+}
+
+Task<int> twice(OneShotEvent& ready) {
+    int v = co_await answer(ready);
+    co_return v * 2;
+}
+
+Task<> fails() {
+    throw std::runtime_error("reacting task failed");
+    co_return;
+}
+
+void checkTask() {
+    OneShotEvent ready;
+    ready.set();
+    int v = syncWait(twice(ready));
+    bool caught = false;
+    try {
+        syncWait(fails());
+    } catch (const std::runtime_error&) {
+        caught = true;
+    }
+    if (v != 84 || !caught) {
+        std::cerr << "Task check failed" << std::endl;
+        std::exit(1);
+    }
+}
+
+/* 读/proc/self/status中的一项，单位KB；不是Linux时返回0 */
+std::size_t statusKb(const char* key) {
+    std::ifstream in("/proc/self/status");
+    std::string line;
+    std::size_t keyLen = std::char_traits<char>::length(key);
+    while (std::getline(in, line))
+        if (line.compare(0, keyLen, key) == 0)
+            return static_cast<std::size_t>(std::strtoull(line.c_str() + keyLen, nullptr, 10));
+    return 0;
+}
+
+struct Footprint {
+    std::size_t heapBytes;
+    std::size_t rssKb;
+    std::size_t vmKb;
+
+    static Footprint now() { return {allocBytes.load(), statusKb("VmRSS:"), statusKb("VmSize:")}; }
+};
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * 打印一行：每个等待者的堆内存、常驻内存、虚拟地址空间，以及从通知到各个等待者开始运行的延迟
+ */
+void report(const char* name, std::size_t n, const Footprint& before, const Footprint& waiting,
+            std::vector<double>& wakeUs) {
+    std::sort(wakeUs.begin(), wakeUs.end());
+    auto perWaiter = [n](std::size_t a, std::size_t b) {
+        return b > a ? static_cast<double>(b - a) / static_cast<double>(n) : 0.0;
+    };
+    std::printf("  %-40s %8zu %12.0f %12.2f %12.2f %10.1f %10.1f %10.2f\n", name, n,
+                perWaiter(before.heapBytes, waiting.heapBytes), perWaiter(before.rssKb, waiting.rssKb),
+                perWaiter(before.vmKb, waiting.vmKb), wakeUs[wakeUs.size() / 2], wakeUs[wakeUs.size() * 99 / 100],
+                wakeUs.back() / 1000.0);
+}
+
+/* 等待者全部进入等待状态：计数到齐后再给最后几个一点时间真正阻塞或挂起 */
+void waitUntil(const std::atomic<std::size_t>& waiting, std::size_t n) {
+    while (waiting.load() < n)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+}
+
+double elapsedUs(Clock::time_point t0) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+}
+
+/* Notify::useBoolAndMutex，每个反应任务一个线程 */
+void threadsWithCv(std::size_t n) {
+    std::vector<double> wakeUs(n);
+    std::vector<std::thread> reactors;
+    reactors.reserve(n);
+    std::mutex m;
+    std::condition_variable cv;
+    bool flag = false;
+    std::atomic<std::size_t> waiting{0};
+    Clock::time_point t0;
+
+    Footprint before = Footprint::now();
+    for (std::size_t i = 0; i < n; ++i) {
+        reactors.emplace_back([&, i] {
+            std::unique_lock<std::mutex> lk(m);
+            ++waiting;
+            cv.wait(lk, [&] { return flag; });
+            wakeUs[i] = elapsedUs(t0);
+        });
+    }
+    waitUntil(waiting, n);
+    Footprint blocked = Footprint::now();
+    {
+        std::lock_guard<std::mutex> g(m);
+        t0 = Clock::now();
+        flag = true;
+    }
+    cv.notify_all();
+    for (auto& t : reactors)
+        t.join();
+    report("thread per reactor: cv + flag", n, before, blocked, wakeUs);
+}
+
+/* Notify::usePromise，多个反应任务共享一个std::shared_future<void> */
+void threadsWithFuture(std::size_t n) {
+    std::vector<double> wakeUs(n);
+    std::vector<std::thread> reactors;
+    reactors.reserve(n);
+    std::atomic<std::size_t> waiting{0};
+    Clock::time_point t0;
+
+    Footprint before = Footprint::now();
+    std::promise<void> p;
+    std::shared_future<void> sf = p.get_future().share();
+    for (std::size_t i = 0; i < n; ++i) {
+        reactors.emplace_back([&, i] {
+            ++waiting;
+            sf.wait();
+            wakeUs[i] = elapsedUs(t0);
+        });
+    }
+    waitUntil(waiting, n);
+    Footprint blocked = Footprint::now();
+    t0 = Clock::now();
+    p.set_value();
+    for (auto& t : reactors)
+        t.join();
+    report("thread per reactor: std::shared_future", n, before, blocked, wakeUs);
+}
+
+Task<> react(OneShotEvent& event, Scheduler* scheduler, std::atomic<std::size_t>& waiting,
+             const Clock::time_point& t0, double& wakeUs) {
+    ++waiting;
+    if (scheduler != nullptr)
+        co_await event.wait(*scheduler);
+    else
+        co_await event;
+    wakeUs = elapsedUs(t0);
+}
+
+/* 所有协程都在一个线程上运行；inlineResume为true时在set()里直接恢复，不经过调度队列 */
+void coroutinesSingleThread(std::size_t n, bool inlineResume) {
+    std::vector<double> wakeUs(n);
+    std::atomic<std::size_t> waiting{0};
+    Clock::time_point t0;
+    OneShotEvent event;
+    SingleThreadScheduler scheduler;
+
+    Footprint before = Footprint::now();
+    for (std::size_t i = 0; i < n; ++i)
+        scheduler.spawn(react(event, inlineResume ? nullptr : &scheduler, waiting, t0, wakeUs[i]));
+    scheduler.run();
+    Footprint suspended = Footprint::now();
+    t0 = Clock::now();
+    event.set();
+    scheduler.run();
+    report(inlineResume ? "coroutines: resumed inside set()" : "coroutines: SingleThreadScheduler", n, before,
+           suspended, wakeUs);
+}
+
+void coroutinesThreadPool(std::size_t n) {
+    std::vector<double> wakeUs(n);
+    std::atomic<std::size_t> waiting{0};
+    Clock::time_point t0;
+    OneShotEvent event;
+    ThreadPoolScheduler scheduler;
+
+    Footprint before = Footprint::now();
+    for (std::size_t i = 0; i < n; ++i)
+        scheduler.spawn(react(event, &scheduler, waiting, t0, wakeUs[i]));
+    waitUntil(waiting, n);
+    Footprint suspended = Footprint::now();
+    t0 = Clock::now();
+    event.set();
+    scheduler.waitIdle();
+    char name[64];
+    std::snprintf(name, sizeof(name), "coroutines: ThreadPoolScheduler(%zu)", scheduler.threadCount());
+    report(name, n, before, suspended, wakeUs);
+}
+
+/**
+ * 每个反应任务等待同一个事件，检测任务触发一次。
+ * - 内存：等待期间相对开始之前增加的堆内存、常驻内存（RSS）、虚拟地址空间，除以等待者个数。
+ *   线程的栈按需提交，RSS只有用到的几页，但每个线程都预留了整个栈的地址空间
+ * - 延迟：从通知到每个等待者开始运行的时间，all是最后一个等待者开始运行的时间
+ */
+void measureWaiters(std::size_t threads, std::size_t coroutines) {
+    std::printf("  %-40s %8s %12s %12s %12s %10s %10s %10s\n", "pattern", "waiters", "heap B/w", "RSS KB/w",
+                "VM KB/w", "p50 us", "p99 us", "all ms");
+    threadsWithCv(threads);
+    threadsWithFuture(threads);
+    for (std::size_t n : {threads, coroutines}) {
+        coroutinesSingleThread(n, false);
+        coroutinesSingleThread(n, true);
+        coroutinesThreadPool(n);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    useEvent();
+    checkTask();
+
+    /* 默认规模下线程版本只开256个线程；--large时开4096个线程、100万个协程 */
+    bool large = argc > 1 && std::string(argv[1]) == "--large";
+    std::cout << ">>>> memory per waiter and wake latency, thread per reactor vs coroutines" << std::endl;
+    measureWaiters(large ? 4096 : 256, large ? 1000000 : 100000);
+}
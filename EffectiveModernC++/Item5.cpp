@@ -8,6 +8,309 @@
 #include <functional>
 #include <string>
 #include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "ConcurrentHashMap.h"
+#include "IndirectSort.h"
+#include "PerfScope.h"
+
+template <typename F>
+double timeMs(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/* n个unique_ptr<int>，分配顺序打乱，使它们指向的对象在堆上的位置与值无关 */
+std::vector<std::unique_ptr<int>> makePointers(std::size_t n, int maxValue, std::mt19937& rng) {
+    std::vector<std::unique_ptr<int>> v;
+    v.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+        v.emplace_back(new int(static_cast<int>(rng() % static_cast<unsigned>(maxValue)) - maxValue / 2));
+    std::shuffle(v.begin(), v.end(), rng);
+    return v;
+}
+
+/*
+ * std::sort配合解引用比较器 vs indirectSort（整数键走基数排序），以及键不是整数时走pdqsort的情况
+ */
+void benchmarkIndirectSort(std::size_t n) {
+    auto derefUPLess = [](const std::unique_ptr<int>& p1, const std::unique_ptr<int>& p2) {
+        return *p1 < *p2;
+    };
+    std::mt19937 rng(5);
+    auto a = makePointers(n, 1 << 30, rng);
+    std::vector<std::unique_ptr<int>> b;
+    b.reserve(n);
+    for (const auto& p : a)
+        b.emplace_back(new int(*p));
+
+    double stdSort = timeMs([&] { std::sort(a.begin(), a.end(), derefUPLess); });
+    double indirect = timeMs([&] { indirectSort(b.begin(), b.end(), DerefLess()); });
+    for (std::size_t i = 0; i < n; ++i)
+        assert(*a[i] == *b[i]);
+
+    /* 把值映射成double，键不再是整数 */
+    auto derefUPLessD = byKey([](const std::unique_ptr<int>& p) { return *p * 0.5; });
+    std::shuffle(a.begin(), a.end(), rng);
+    std::shuffle(b.begin(), b.end(), rng);
+    double stdSortD = timeMs([&] { std::sort(a.begin(), a.end(), derefUPLessD); });
+    double pdq = timeMs([&] { indirectSort(b.begin(), b.end(), derefUPLessD); });
+    assert(std::is_sorted(b.begin(), b.end(), derefUPLessD));
+
+    std::cout << "  n = " << n << ": int key std::sort " << stdSort << " ms, indirectSort (radix) " << indirect
+              << " ms; double key std::sort " << stdSortD << " ms, indirectSort (pdqsort) " << pdq << " ms"
+              << std::endl;
+}
+
+void checkIndirectSort() {
+    std::mt19937 rng(55);
+    for (std::size_t n : {0u, 1u, 63u, 64u, 1000u, 100000u}) {
+        for (int maxValue : {4, 1 << 30}) {
+            auto v = makePointers(n, maxValue, rng);
+            std::vector<int> expect;
+            for (const auto& p : v)
+                expect.push_back(*p);
+            std::sort(expect.begin(), expect.end());
+            indirectSort(v.begin(), v.end(), DerefLess());
+            for (std::size_t i = 0; i < n; ++i)
+                assert(*v[i] == expect[i]);
+
+            /* 比较器也可以直接交给std::sort */
+            std::shuffle(v.begin(), v.end(), rng);
+            std::sort(v.begin(), v.end(), DerefLess());
+            for (std::size_t i = 0; i < n; ++i)
+                assert(*v[i] == expect[i]);
+        }
+    }
+}
+
+/*
+ * 用硬件计数器量化main中的两个说法：
+ * - 显式写成std::pair<std::string, int>遍历unordered_map时，每个元素都要拷贝出一个临时pair
+ * - std::function包装的比较器每次调用都要经过一次间接调用，auto保存的闭包可以被内联
+ */
+void measureAutoClaims(std::size_t n) {
+    std::unordered_map<std::string, int> m;
+    for (std::size_t i = 0; i < n; ++i)
+        m.emplace(std::string(32, 'k') + std::to_string(i), static_cast<int>(i));
+    std::size_t sum1 = 0, sum2 = 0;
+    {
+        PerfScope scope("for (const std::pair<std::string, int>&)");
+        for (const std::pair<std::string, int>& p : m)
+            sum1 += p.first.size() + static_cast<std::size_t>(p.second);
+    }
+    {
+        PerfScope scope("for (const auto&)");
+        for (const auto& p : m)
+            sum2 += p.first.size() + static_cast<std::size_t>(p.second);
+    }
+    assert(sum1 == sum2);
+
+    auto derefUPLess = [](const std::unique_ptr<int>& p1, const std::unique_ptr<int>& p2) { return *p1 < *p2; };
+    std::function<bool(const std::unique_ptr<int>&, const std::unique_ptr<int>&)> derefUPLessF = derefUPLess;
+    std::mt19937 rng(9);
+    auto a = makePointers(n, 1 << 30, rng);
+    auto b = makePointers(n, 1 << 30, rng);
+    {
+        PerfScope scope("std::sort with std::function");
+        std::sort(a.begin(), a.end(), derefUPLessF);
+    }
+    {
+        PerfScope scope("std::sort with auto closure");
+        std::sort(b.begin(), b.end(), derefUPLess);
+    }
+    PerfScope::report();
+}
+
+/* 对照组：一把全局互斥锁保护的unordered_map，与Item8中lockAndCall的用法相同 */
+class LockedCounterMap {
+public:
+    bool find(const std::string& key, int& out) const {
+        std::lock_guard<std::mutex> g(m);
+        auto it = map.find(key);
+        if (it == map.end())
+            return false;
+        out = it->second;
+        return true;
+    }
+
+    int fetchAdd(const std::string& key, int delta) {
+        std::lock_guard<std::mutex> g(m);
+        int& v = map[key];
+        int old = v;
+        v += delta;
+        return old;
+    }
+
+    long long total() const {
+        std::lock_guard<std::mutex> g(m);
+        long long sum = 0;
+        for (const auto& p : map)
+            sum += p.second;
+        return sum;
+    }
+
+private:
+    mutable std::mutex m;
+    std::unordered_map<std::string, int> map;
+};
+
+std::vector<std::string> makeCounterKeys(std::size_t n) {
+    std::vector<std::string> keys;
+    keys.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+        keys.push_back("counter/" + std::to_string(i * 2654435761u % 1000003u));
+    return keys;
+}
+
+/*
+ * threads个线程共做totalOps次操作，每次随机选一个键，readPercent%的操作是find，其余是fetchAdd(key, 1)。
+ * 返回每秒百万次操作，以及fetchAdd的次数用于校验总和
+ */
+template <typename Map>
+double counterThroughput(Map& map, const std::vector<std::string>& keys, std::size_t threads, std::size_t totalOps,
+                         unsigned readPercent, long long& adds) {
+    std::atomic<bool> go{false};
+    std::atomic<long long> addCount{0};
+    std::vector<std::thread> workers;
+    std::size_t perThread = totalOps / threads;
+    for (std::size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            std::uint32_t x = static_cast<std::uint32_t>(t * 2654435761u + 1);
+            long long localAdds = 0;
+            int sink = 0;
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            for (std::size_t i = 0; i < perThread; ++i) {
+                x ^= x << 13;
+                x ^= x >> 17;
+                x ^= x << 5;
+                const std::string& key = keys[x % keys.size()];
+                if ((x >> 8) % 100 < readPercent) {
+                    int v;
+                    if (map.find(key, v))
+                        sink += v;
+                } else {
+                    map.fetchAdd(key, 1);
+                    ++localAdds;
+                }
+            }
+            addCount.fetch_add(localAdds);
+            volatile int keep = sink;
+            (void)keep;
+        });
+    }
+    double ms = timeMs([&] {
+        go.store(true, std::memory_order_release);
+        for (auto& w : workers)
+            w.join();
+    });
+    adds = addCount.load();
+    return static_cast<double>(perThread * threads) / ms / 1000.0;
+}
+
+void benchmarkCounters(std::size_t totalOps) {
+    auto keys = makeCounterKeys(10000);
+    for (unsigned readPercent : {95u, 10u}) {
+        std::cout << "  " << readPercent << "% find / " << 100 - readPercent << "% fetchAdd, " << keys.size()
+                  << " keys, Mops/s:" << std::endl;
+        for (std::size_t threads : {1u, 2u, 4u, 8u, 16u, 32u, 64u}) {
+            LockedCounterMap locked;
+            ConcurrentHashMap<std::string, int> sharded;
+            /* 先插入所有键，比较的是稳定状态下的读写 */
+            for (const auto& k : keys) {
+                locked.fetchAdd(k, 0);
+                sharded.fetchAdd(k, 0);
+            }
+            long long lockedAdds = 0, shardedAdds = 0;
+            double a = counterThroughput(locked, keys, threads, totalOps, readPercent, lockedAdds);
+            double b = counterThroughput(sharded, keys, threads, totalOps, readPercent, shardedAdds);
+            long long shardedTotal = 0;
+            sharded.forEach([&](const std::string&, int v) { shardedTotal += v; });
+            assert(locked.total() == lockedAdds && shardedTotal == shardedAdds);
+            std::cout << "    " << threads << " threads: unordered_map + mutex " << a << ", ConcurrentHashMap " << b
+                      << " (" << b / a << "x)" << std::endl;
+        }
+    }
+}
+
+void checkConcurrentHashMap() {
+    ConcurrentHashMap<std::string, int> m;
+    assert(m.findOrInsert("a", 1) == std::make_pair(1, true));
+    assert(m.findOrInsert("a", 2) == std::make_pair(1, false));
+    assert(!m.upsert("a", 3) && m.upsert("b", 4));
+    assert(m.fetchAdd("a", 10) == 3 && m.fetchAdd("c", 5) == 0);
+    int v = 0;
+    assert(m.find("a", v) && v == 13 && m.find("c", v) && v == 5);
+    assert(m.erase("b") && !m.erase("b") && !m.contains("b") && m.size() == 2);
+    assert(m.upsert("b", 7) && m.find("b", v) && v == 7);
+
+    /* 多个线程同时加同一批计数器，同时有线程反复删除、插入另一批键 */
+    const std::size_t threads = 8, rounds = 20000;
+    auto keys = makeCounterKeys(64);
+    ConcurrentHashMap<std::string, int> counters(4);
+    std::atomic<bool> stop{false};
+    std::thread churn([&] {
+        for (int i = 0; !stop.load(); ++i) {
+            std::string k = "churn/" + std::to_string(i % 500);
+            counters.upsert(k, i);
+            counters.erase(k);
+        }
+    });
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (std::size_t i = 0; i < rounds; ++i) {
+                counters.fetchAdd(keys[(i + t) % keys.size()], 1);
+                int x;
+                counters.find(keys[i % keys.size()], x);
+            }
+        });
+    }
+    for (auto& w : workers)
+        w.join();
+    stop = true;
+    churn.join();
+    long long sum = 0;
+    for (const auto& k : keys) {
+        int x = 0;
+        assert(counters.find(k, x));
+        sum += x;
+    }
+    assert(sum == static_cast<long long>(threads * rounds));
+
+    /*
+     * 分片快照是某一时刻的状态：写入线程按顺序轮流给k0..k7加一，任一时刻都有v0 >= v1 >= ... >= v7 >= v0 - 1，
+     * 只有一个分片时，每一份快照都必须满足这个关系
+     */
+    ConcurrentHashMap<int, long> ordered(1);
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        for (int i = 0; i < 200000; ++i)
+            ordered.fetchAdd(i % 8, 1);
+        done = true;
+    });
+    int snapshots = 0;
+    while (!done.load()) {
+        long values[8] = {0};
+        for (const auto& kv : ordered.snapshot())
+            values[kv.first] = kv.second;
+        for (int k = 1; k < 8; ++k)
+            assert(values[k - 1] >= values[k] && values[k] >= values[0] - 1);
+        ++snapshots;
+    }
+    writer.join();
+    (void)snapshots;
+}
 
 /*
  * 使用auto的好处
@@ -15,7 +318,7 @@
  * - 避免兼容性和效率问题的类型不匹配现象
  * - 提高编码效率
  */
-int main() {
+int main(int argc, char* argv[]) {
     // auto x; // 报错，会检测没有初始化的变量
     // auto可以指定只有编译器知道的类型
     auto derefUPLess = [](const std::unique_ptr<int>& p1, const std::unique_ptr<int>& p2) {
@@ -36,4 +339,31 @@ int main() {
     for (const std::pair<std::string, int>& p: m) {
     }
 
+    // derefUPLess每次比较都要解引用两个指针；byKey构造的比较器给出了键，indirectSort只解引用每个元素一次，
+    // 调用方式和std::sort(v.begin(), v.end(), derefUPLess)一样
+    auto derefUPKeyLess = byKey([](const std::unique_ptr<int>& p) { return *p; });
+    std::vector<std::unique_ptr<int>> v;
+    for (int x : {3, 1, 2})
+        v.emplace_back(new int(x));
+    indirectSort(v.begin(), v.end(), derefUPKeyLess);
+    assert(*v[0] == 1 && *v[1] == 2 && *v[2] == 3);
+    // 普通的lambda比较器没有键，退回std::sort
+    indirectSort(v.begin(), v.end(), [](const auto& p1, const auto& p2) { return *p1 > *p2; });
+    assert(*v[0] == 3);
+
+    std::cout << ">>>> auto vs explicit types, hardware counters" << std::endl;
+    measureAutoClaims(1000000);
+    PerfScope::reset();
+
+    checkConcurrentHashMap();
+    std::cout << ">>>> std::unordered_map + std::mutex vs ConcurrentHashMap, counter updates" << std::endl;
+    benchmarkCounters(2000000);
+
+    checkIndirectSort();
+    std::cout << ">>>> indirect sort of std::vector<std::unique_ptr<int>>" << std::endl;
+    for (std::size_t n : {1000u, 10000u, 100000u, 1000000u, 10000000u})
+        benchmarkIndirectSort(n);
+    /* 两份1亿个unique_ptr连同指向的int需要约8GB内存，只在传入--large时运行 */
+    if (argc > 1 && std::string(argv[1]) == "--large")
+        benchmarkIndirectSort(100000000);
 }
\ No newline at end of file
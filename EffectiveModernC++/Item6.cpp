@@ -7,6 +7,7 @@
 #include <vector>
 #include <type_traits>
 #include <iostream>
+#include <random>
 
 #ifndef _MSC_VER
 #   include <cxxabi.h>
@@ -15,6 +16,8 @@
 #include <string>
 #include <cstdlib>
 
+#include "PerfScope.h"
+
 /**
  * 要点：
  * - 对正常的模板类型进行推导的时候，具有引用类型的形参会被当作非引用形参处理
@@ -64,6 +67,43 @@ std::vector<bool> features() {
 
 void process(bool priority) {}
 
+/*
+ * 代理类型也有性能上的影响：std::vector<bool>每次访问都要经过reference对象做移位和掩码，
+ * 换来的是只占std::vector<char>八分之一的内存。用硬件计数器看指令数和缓存缺失
+ */
+void measureProxy(std::size_t n) {
+    std::mt19937 rng(6);
+    std::vector<bool> bits(n);
+    std::vector<char> bytes(n);
+    for (std::size_t i = 0; i < n; ++i)
+        bytes[i] = bits[i] = (rng() & 1) != 0;
+
+    std::size_t c1 = 0, c2 = 0, c3 = 0;
+    {
+        PerfScope scope("std::vector<bool>, auto (proxy)");
+        for (std::size_t i = 0; i < n; ++i) {
+            auto b = bits[i];
+            c1 += b;
+        }
+    }
+    {
+        PerfScope scope("std::vector<bool>, static_cast<bool>");
+        for (std::size_t i = 0; i < n; ++i) {
+            auto b = static_cast<bool>(bits[i]);
+            c2 += b;
+        }
+    }
+    {
+        PerfScope scope("std::vector<char>");
+        for (std::size_t i = 0; i < n; ++i)
+            c3 += bytes[i] != 0;
+    }
+    std::cout << "  " << n << " elements, " << c1 << " set" << std::endl;
+    if (c1 != c2 || c2 != c3)
+        std::cout << "  mismatch!" << std::endl;
+    PerfScope::report();
+}
+
 /*
  * 不能使用auto来推断"隐形"代理类型的变量型别，可以使用static_cast显示转换为对应的真正类型
  * 如果发现不了隐藏的代理对象，可以在头文件的函数返回值处寻找
@@ -80,5 +120,8 @@ int main() {
    std::cout << type_name<decltype(autoHighPriority)>() << std::endl;
    std::cout << type_name<decltype(castAutoHighPriority)>() << std::endl;
 
+   std::cout << ">>>> proxy access cost, hardware counters" << std::endl;
+   measureProxy(std::size_t(1) << 26);
+
    return 0;
 }
\ No newline at end of file
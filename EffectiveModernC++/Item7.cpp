@@ -5,15 +5,207 @@
  */
 
 #include <vector>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#include "AllocCounter.h"
+#include "SmallVector.h"
 
 class Widget {
     // int c(2); // 小括号不能用来初始非静态成员
 public:
-    Widget();
-    Widget(long i, double j);
-    Widget(std::initializer_list<long double> t);
+    Widget() {}
+    Widget(long i, double j) : values{static_cast<long double>(i), j} {}
+    /* 列表中的元素拷贝到内联存储，不超过16个时不分配内存 */
+    Widget(std::initializer_list<long double> t) : values(t) {}
+
+    std::size_t size() const { return values.size(); }
+
+private:
+    SmallVector<long double, 16> values;
 };
 
+template <typename F>
+void measure(const char* name, F&& f) {
+    std::size_t a0 = allocCount.load();
+    auto start = std::chrono::steady_clock::now();
+    f();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "    " << name << ": " << ms << " ms, " << allocCount.load() - a0 << " allocations" << std::endl;
+}
+
+static volatile long sink = 0;
+
+/*
+ * 反复构造{1, 2, 3}、遍历求和、析构：std::vector vs SmallVector
+ */
+template <typename Vec>
+void braceInitLoop(std::size_t rounds) {
+    long sum = 0;
+    for (std::size_t r = 0; r < rounds; ++r) {
+        Vec v{1, 2, static_cast<int>(r)};
+        for (int x : v)
+            sum += x;
+    }
+    sink = sum;
+}
+
+/* 用push_back构造len个元素的序列，遍历后析构 */
+template <typename Vec>
+void pushBackLoop(std::size_t rounds, int len) {
+    long sum = 0;
+    for (std::size_t r = 0; r < rounds; ++r) {
+        Vec v;
+        for (int i = 0; i < len; ++i)
+            v.push_back(i);
+        for (int x : v)
+            sum += x;
+    }
+    sink = sum;
+}
+
+/* 大量短序列同时存活：外层vector中放count个长度为len的序列 */
+template <typename Vec>
+void manySequences(std::size_t count, int len) {
+    std::vector<Vec> all;
+    all.reserve(count);
+    for (std::size_t k = 0; k < count; ++k) {
+        all.emplace_back();
+        for (int i = 0; i < len; ++i)
+            all.back().push_back(i + static_cast<int>(k));
+    }
+    long sum = 0;
+    for (const auto& v : all)
+        for (int x : v)
+            sum += x;
+    sink = sum;
+}
+
+void benchmarkSmallVector() {
+    const std::size_t rounds = 1000000;
+    std::cout << "  " << rounds << " x {1, 2, 3}" << std::endl;
+    measure("std::vector<int>", [&] { braceInitLoop<std::vector<int>>(rounds); });
+    measure("SmallVector<int, 16>", [&] { braceInitLoop<SmallVector<int, 16>>(rounds); });
+
+    for (int len : {4, 16, 17, 64}) {
+        std::cout << "  " << rounds << " x push_back " << len << " elements" << std::endl;
+        measure("std::vector<int>", [&] { pushBackLoop<std::vector<int>>(rounds, len); });
+        measure("SmallVector<int, 16>", [&] { pushBackLoop<SmallVector<int, 16>>(rounds, len); });
+    }
+
+    std::cout << "  1000000 live sequences of 6 elements" << std::endl;
+    measure("std::vector<std::vector<int>>", [&] { manySequences<std::vector<int>>(1000000, 6); });
+    measure("std::vector<SmallVector<int, 8>>", [&] { manySequences<SmallVector<int, 8>>(1000000, 6); });
+
+    std::cout << "  " << rounds << " x Widget{1.0, 2.0, 3.0}" << std::endl;
+    measure("Widget", [&] {
+        std::size_t n = 0;
+        for (std::size_t r = 0; r < rounds; ++r) {
+            Widget w{1.0, 2.0, static_cast<long double>(r)};
+            n += w.size();
+        }
+        sink = static_cast<long>(n);
+    });
+}
+
+/* 记录存活的对象个数，第failAt次拷贝时抛出异常；移动构造可能抛异常，扩容时应当改用拷贝 */
+struct Fragile {
+    static int live, copies, moves, failAt;
+
+    explicit Fragile(int v) : v(v) { ++live; }
+    Fragile(const Fragile& other) : v(other.v) {
+        if (copies++ == failAt)
+            throw std::runtime_error("copy failed");
+        ++live;
+    }
+    Fragile(Fragile&& other) noexcept(false) : v(other.v) {
+        ++moves;
+        ++live;
+    }
+    ~Fragile() { --live; }
+
+    int v;
+};
+
+int Fragile::live = 0, Fragile::copies = 0, Fragile::moves = 0, Fragile::failAt = -1;
+
+/* 搬到堆上的途中抛出异常时，原来的元素不受影响，新缓冲区和其中已构造的元素都被释放 */
+void checkSmallVectorGrowthFailure() {
+    {
+        SmallVector<Fragile, 2> f;
+        f.emplace_back(0);
+        f.emplace_back(1);
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            Fragile::failAt = Fragile::copies + 1;
+            bool thrown = false;
+            try {
+                if (attempt == 0)
+                    f.emplace_back(2);
+                else
+                    f.reserve(8);
+            } catch (const std::runtime_error&) {
+                thrown = true;
+            }
+            assert(thrown && f.isInline() && f.size() == 2 && f[0].v == 0 && f[1].v == 1 && Fragile::live == 2);
+        }
+        Fragile::failAt = -1;
+        f.emplace_back(2);
+        assert(!f.isInline() && f.size() == 3 && f[2].v == 2 && Fragile::live == 3 && Fragile::moves == 0);
+    }
+    assert(Fragile::live == 0);
+}
+
+void checkSmallVector() {
+    SmallVector<int, 4> v{1, 2, 3};
+    assert(v.size() == 3 && v.isInline() && v[2] == 3);
+    v.push_back(4);
+    assert(v.isInline());
+    v.push_back(5);
+    assert(!v.isInline() && v.size() == 5 && v.back() == 5);
+    v.insert(v.begin(), 0);
+    v.erase(v.begin() + 1, v.begin() + 3);
+    assert((v == SmallVector<int, 4>{0, 3, 4, 5}));
+    /* 参数引用自身元素，扩容时仍然正确 */
+    SmallVector<std::string, 2> s{"a", "b"};
+    s.push_back(s[0]);
+    s.emplace(s.begin() + 1, s[2]);
+    assert((s == SmallVector<std::string, 2>{"a", "a", "b", "a"}));
+
+    /* 只能移动的元素原地构造 */
+    SmallVector<std::unique_ptr<int>, 2> p;
+    for (int i = 0; i < 5; ++i)
+        p.emplace_back(new int(i));
+    SmallVector<std::unique_ptr<int>, 2> q(std::move(p));
+    assert(p.empty() && q.size() == 5 && *q[4] == 4);
+    SmallVector<std::unique_ptr<int>, 2> r;
+    r.emplace_back(new int(7));
+    q.swap(r);
+    assert(q.size() == 1 && *q[0] == 7 && q.isInline() && r.size() == 5);
+    r.erase(r.begin());
+    assert(*r.front() == 1);
+
+    SmallVector<std::string, 3> a(5, "x"), b;
+    b = a;
+    a.resize(2);
+    b.resize(7, b[0]);
+    assert(a.size() == 2 && b.size() == 7 && b[6] == "x");
+    a = std::move(b);
+    assert(a.size() == 7 && b.empty());
+
+    std::size_t before = allocCount.load();
+    Widget w{1.0, 2.0, 3.0};
+    assert(w.size() == 3 && allocCount.load() == before);
+
+    checkSmallVectorGrowthFailure();
+}
+
 /*
  * - 小括号不能初始化类中的非静态成员
  * - 大括号可以阻止隐式的窄化类型检查，也免疫解析语法
@@ -24,6 +216,8 @@ int main() {
      * C++11 引入了统一初始化的概念，使用大括号就可以进行统一初始化
      */
     std::vector<int> v{1, 2, 3}; // 使用{}初始化vector的内容
+    /* 即使只有3个元素，vector也要在堆上分配一次；元素较少时可以使用SmallVector，元素放在对象内部 */
+    SmallVector<int, 16> sv{1, 2, 3};
     /* 大括号可以用于初始化非静态成员，但是不能使用小括号 */
     int c{2};
     /* 大括号会执行窄化型别类型检查，如果进行窄化会编译不通过 */
@@ -54,6 +248,10 @@ int main() {
     /*
      * 作为类的设计者，一般要将构造函数设计成使用大括号还是小括号都不会影响调用的函数。
      */
+
+    checkSmallVector();
+    std::cout << ">>>> SmallVector vs std::vector" << std::endl;
+    benchmarkSmallVector();
     return 0;
 }
 
@@ -6,6 +6,10 @@
 
 #include <mutex>
 #include <iostream>
+#include <memory>
+#include <type_traits>
+
+#include "Expected.h"
 
 void f(int a) { std::cout << "f(int) called" << std::endl; }
 void f(void* a) { std::cout << "f(void*) called" << std::endl; }
@@ -18,7 +22,21 @@ struct Widget {
 
 int f1(std::shared_ptr<Widget> spw);
 double f2(std::shared_ptr<Widget> spw);
-bool f3(Widget* pw);
+bool f3(Widget* pw) { return pw != nullptr; }
+
+/* 会失败但不抛异常的版本：错误通过返回值传回，函数可以声明为noexcept（见Item14和Expected.h） */
+enum class WidgetErrc {
+    NullWidget,
+    Negative
+};
+
+Expected<int, WidgetErrc> f4(Widget* pw) noexcept {
+    if (pw == nullptr)
+        return makeUnexpected(WidgetErrc::NullWidget);
+    if (pw->a < 0)
+        return makeUnexpected(WidgetErrc::Negative);
+    return pw->a;
+}
 
 template <typename FuncType, typename MuxType, typename PtrType>
 auto lockAndCall(FuncType func, MuxType& mutex, PtrType ptr) -> decltype(func(ptr)) {
@@ -43,5 +61,16 @@ int main() {
     // auto result1 = lockAndCall(f1, f1m, 0); // 报错，无法找到将0转换为指针的方法
     // auto result2 = lockAndCall(f2, f2m, NULL); // 同样的报错
     auto result3 = lockAndCall(f3, f3m, nullptr);
+
+    /* lockAndCall的返回型别是decltype(func(ptr))，Expected原样传出，错误不会在加锁的路径上变成异常 */
+    std::mutex f4m;
+    Widget w{-1};
+    auto result4 = lockAndCall(f4, f4m, nullptr);
+    static_assert(std::is_same<decltype(result4), Expected<int, WidgetErrc>>::value, "");
+    auto result5 = lockAndCall(f4, f4m, &w).orElse([](WidgetErrc e) -> Expected<int, WidgetErrc> {
+        return e == WidgetErrc::Negative ? 0 : -1;
+    });
+    std::cout << "f4(nullptr): " << (result4 ? "value" : "error") << ", f4(&w) recovered to " << *result5
+              << std::endl;
 }
 
@@ -9,15 +9,29 @@
  */
 
 #include <vector>
+#include <list>
 #include <type_traits>
+#include <chrono>
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <sys/wait.h>
+#include <unistd.h>
 
-template <typename T>
+#include "Allocator.h"
+#include "MmapAllocator.h"
+
+/*
+ * MyAllocList默认使用PolyAllocator，型别不随背后的内存资源变化，
+ * 想换成arena或者内存池只需要替换默认资源（见Allocator.h中的ScopedDefaultResource）
+ */
+template <typename T, typename Alloc = PolyAllocator<T>>
 struct MyAllocList {
-    typedef std::vector<T> type;
+    typedef std::vector<T, Alloc> type;
 };
 
-template <typename T>
-using MyAllocListU = std::vector<T>;
+template <typename T, typename Alloc = PolyAllocator<T>>
+using MyAllocListU = std::vector<T, Alloc>;
 
 /*
  * 更糟的情况是如果想在模板内创建一个链表，容纳的类型由模板形参指定，则前面必须加typename，
@@ -28,6 +42,10 @@ using MyAllocListU = std::vector<T>;
  */
 template <typename T>
 class Widget {
+public:
+    void add(const T& v) { list.push_back(v); }
+    std::size_t size() const { return list.size(); }
+
 private:
     typename MyAllocList<T>::type list;
 };
@@ -45,8 +63,160 @@ void func(T&& x) {
     TRR y;
 }
 
+/* 当前进程的常驻内存（RSS），单位KB */
+long residentKB() {
+    std::ifstream statm("/proc/self/statm");
+    long pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/* 负载结束前（容器还活着的时候）采样的RSS */
+long workloadRssKB = 0;
+
+/*
+ * 分配密集型的负载：大量生命周期很短、大小不一的MyAllocList，以及一个节点容器
+ */
+template <typename Alloc>
+std::size_t vectorWorkload(const Alloc& alloc, int rounds) {
+    std::size_t total = 0;
+    std::vector<std::vector<int, Alloc>> lists;
+    lists.reserve(1024);
+    for (int r = 0; r < rounds; ++r) {
+        lists.clear();
+        for (int i = 0; i < 1024; ++i) {
+            lists.emplace_back(alloc);
+            for (int j = 0; j < (i * 7 + r) % 97; ++j)
+                lists.back().push_back(j);
+        }
+        for (auto& l : lists)
+            total += l.size();
+    }
+    workloadRssKB = residentKB();
+    return total;
+}
+
+template <typename Alloc>
+std::size_t listWorkload(const Alloc& alloc, int n) {
+    std::list<int, Alloc> l(alloc);
+    for (int i = 0; i < n; ++i)
+        l.push_back(i);
+    /* 删掉一半的节点再插回来，制造空洞 */
+    for (auto it = l.begin(); it != l.end();) {
+        it = l.erase(it);
+        if (it != l.end())
+            ++it;
+    }
+    for (int i = 0; i < n / 2; ++i)
+        l.push_front(i);
+    workloadRssKB = residentKB();
+    return l.size();
+}
+
+/*
+ * 几百MB的大缓冲区：逐个push_back的扩容速度以及随机访问的速度
+ */
+template <typename Vec>
+void largeBufferWorkload(const char* name, Vec&& vec, std::size_t n) {
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < n; ++i)
+        vec.push_back(static_cast<int>(i));
+    auto grown = std::chrono::steady_clock::now();
+
+    std::uint64_t sum = 0;
+    std::uint64_t idx = 88172645463325252ull;
+    for (std::size_t i = 0; i < n / 4; ++i) {
+        /* xorshift生成随机下标 */
+        idx ^= idx << 13;
+        idx ^= idx >> 7;
+        idx ^= idx << 17;
+        sum += vec[idx % n];
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "  " << name << ": grow "
+              << std::chrono::duration<double, std::milli>(grown - start).count() << " ms, random access "
+              << std::chrono::duration<double, std::milli>(end - grown).count() << " ms (checksum " << sum
+              << ")" << std::endl;
+}
+
+/*
+ * 每个负载在fork出的子进程中运行：glibc不把释放的内存还给系统，FixedPool的全局slab也不释放，
+ * 在同一个进程里依次运行时，先运行的负载承担RSS的增长，后面的负载只会显示+0 KB
+ */
+template <typename F>
+void measure(const char* name, F&& f) {
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid > 0) {
+        waitpid(pid, nullptr, 0);
+        return;
+    }
+    long rssBefore = residentKB();
+    auto start = std::chrono::steady_clock::now();
+    std::size_t result = f();
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "  " << name << ": "
+              << std::chrono::duration<double, std::milli>(end - start).count() << " ms, RSS +"
+              << (workloadRssKB - rssBefore) << " KB (checksum " << result << ")" << std::endl;
+    /* fork失败时就在当前进程里运行，结果仍受先后顺序影响 */
+    if (pid == 0)
+        std::_Exit(0);
+}
+
 int main() {
+    /* Widget的型别不变，但是在作用域内所有的分配都落在arena上 */
+    MonotonicArena arena;
+    {
+        ScopedDefaultResource scope(&arena);
+        Widget<int> w;
+        for (int i = 0; i < 1000; ++i)
+            w.add(i);
+        std::cout << "Widget<int> size " << w.size() << ", arena used " << arena.bytesUsed()
+                  << " B, reserved " << arena.bytesReserved() << " B" << std::endl;
+    }
+    arena.release();
+
+    const int rounds = 200;
+    const int nodes = 1000000;
+
+    std::cout << ">>>> vector workload" << std::endl;
+    measure("std::allocator", [&] { return vectorWorkload(std::allocator<int>(), rounds); });
+    measure("PoolAllocator", [&] { return vectorWorkload(PoolAllocator<int>(), rounds); });
+    measure("ArenaAllocator", [&] {
+        MonotonicArena a;
+        std::size_t res = vectorWorkload(ArenaAllocator<int>(a), rounds);
+        /* vector扩容时旧的缓冲区不会被回收，这部分就是单调arena的"碎片" */
+        std::cout << "    arena used " << a.bytesUsed() / 1024 << " KB, reserved "
+                  << a.bytesReserved() / 1024 << " KB" << std::endl;
+        return res;
+    });
+    measure("PolyAllocator(PoolResource)", [&] {
+        PoolResource pool;
+        return vectorWorkload(PolyAllocator<int>(&pool), rounds);
+    });
 
+    std::cout << ">>>> list workload" << std::endl;
+    measure("std::allocator", [&] { return listWorkload(std::allocator<int>(), nodes); });
+    measure("PoolAllocator", [&] { return listWorkload(PoolAllocator<int>(), nodes); });
+    measure("ArenaAllocator", [&] {
+        MonotonicArena a;
+        std::size_t res = listWorkload(ArenaAllocator<int>(a), nodes);
+        std::cout << "    arena used " << a.bytesUsed() / 1024 << " KB, reserved "
+                  << a.bytesReserved() / 1024 << " KB" << std::endl;
+        return res;
+    });
 
+    /* 64M个int，256MB */
+    const std::size_t large = 64u << 20;
+    std::cout << ">>>> large buffer workload" << std::endl;
+    largeBufferWorkload("std::vector", std::vector<int>(), large);
+    largeBufferWorkload("MyAllocList<int, MmapAllocator>", MyAllocListU<int, MmapAllocator<int>>(), large);
+    {
+        MmapOptions opts;
+        opts.populate = true;
+        largeBufferWorkload("MyAllocList<int, MmapAllocator(populate)>",
+                            MyAllocListU<int, MmapAllocator<int>>(MmapAllocator<int>(opts)), large);
+    }
+    largeBufferWorkload("MmapVector<int> (mremap)", MmapVector<int>(), large);
 }
 
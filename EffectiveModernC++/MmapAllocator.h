@@ -0,0 +1,312 @@
+/**
+ * @file MmapAllocator.h
+ * @brief 用mmap和大页支撑的分配器，以及用mremap扩容的MmapVector
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#ifdef __linux__
+#   include <sys/mman.h>
+#endif
+
+#include "Allocator.h"
+
+/*
+ * 几百MB的vector主要有两个开销：
+ * - 4KB的页导致TLB覆盖范围太小，随机访问时TLB miss很多
+ * - 扩容时每一页都要缺页一次，并且旧缓冲区要整体复制到新缓冲区
+ *
+ * 对策：
+ * - 先尝试MAP_HUGETLB（需要系统预留大页），失败则退回普通映射并用madvise(MADV_HUGEPAGE)请求透明大页
+ * - 可选MAP_POPULATE在映射时就把页面全部填好，避免之后逐页缺页
+ * - std::vector扩容总是"分配新的+复制+释放旧的"，分配器接口无法表达原地扩容，
+ *   因此另外提供MmapVector，对平凡可复制的元素直接用mremap扩容，内核只需要搬移页表
+ */
+
+struct MmapOptions {
+    bool hugeTlb = true;                    // 先尝试MAP_HUGETLB
+    bool transparentHuge = true;            // 退回时使用madvise(MADV_HUGEPAGE)
+    bool populate = false;                  // MAP_POPULATE预先缺页
+    std::size_t threshold = 1 << 20;        // 小于该字节数的请求仍然走operator new
+};
+
+namespace detail {
+
+constexpr std::size_t HugePageSize = 2 * 1024 * 1024;
+
+inline bool useMmap(std::size_t bytes, const MmapOptions& opts) noexcept {
+#ifdef __linux__
+    return bytes >= opts.threshold;
+#else
+    (void)bytes; (void)opts;
+    return false;
+#endif
+}
+
+/* 映射长度统一按大页对齐，这样释放时不需要记住当初走的是哪条路径 */
+inline std::size_t mappingLength(std::size_t bytes) noexcept {
+    return alignUp(bytes, HugePageSize);
+}
+
+#ifdef __linux__
+/*
+ * 普通映射无法指定对齐，多映射一个大页再把首尾裁掉，保证起始地址按2MB对齐，透明大页才能生效
+ */
+inline void* mapAligned(std::size_t len, int extraFlags) noexcept {
+    void* raw = ::mmap(nullptr, len + HugePageSize, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | extraFlags, -1, 0);
+    if (raw == MAP_FAILED)
+        return nullptr;
+    auto begin = reinterpret_cast<std::uintptr_t>(raw);
+    auto aligned = alignUp(begin, HugePageSize);
+    if (aligned > begin)
+        ::munmap(raw, aligned - begin);
+    std::size_t tail = begin + len + HugePageSize - (aligned + len);
+    if (tail > 0)
+        ::munmap(reinterpret_cast<void*>(aligned + len), tail);
+    return reinterpret_cast<void*>(aligned);
+}
+#endif
+
+inline void* mmapAllocate(std::size_t bytes, const MmapOptions& opts) {
+    if (!useMmap(bytes, opts))
+        return ::operator new(bytes);
+#ifdef __linux__
+    std::size_t len = mappingLength(bytes);
+    int populate = opts.populate ? MAP_POPULATE : 0;
+    if (opts.hugeTlb) {
+        void* p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | populate, -1, 0);
+        if (p != MAP_FAILED)
+            return p;
+    }
+    /* 退回路径不能直接带MAP_POPULATE，否则在madvise之前就已经按4KB的页填充好了 */
+    void* p = mapAligned(len, 0);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    if (opts.transparentHuge)
+        ::madvise(p, len, MADV_HUGEPAGE);
+    if (opts.populate) {
+        /* 逐页写一次，相当于madvise之后的MAP_POPULATE */
+        auto c = static_cast<volatile char*>(p);
+        for (std::size_t off = 0; off < len; off += 4096)
+            c[off] = 0;
+    }
+    return p;
+#else
+    return ::operator new(bytes);
+#endif
+}
+
+inline void mmapDeallocate(void* p, std::size_t bytes, const MmapOptions& opts) noexcept {
+    if (!useMmap(bytes, opts)) {
+        ::operator delete(p);
+        return;
+    }
+#ifdef __linux__
+    ::munmap(p, mappingLength(bytes));
+#endif
+}
+
+} // namespace detail
+
+/**
+ * 满足Allocator要求的mmap分配器，可以直接用作MyAllocList<T, MmapAllocator<T>>
+ */
+template <typename T>
+class MmapAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    MmapAllocator() noexcept = default;
+    explicit MmapAllocator(const MmapOptions& opts) noexcept : opts(opts) {}
+
+    template <typename U>
+    MmapAllocator(const MmapAllocator<U>& other) noexcept : opts(other.options()) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(detail::mmapAllocate(n * sizeof(T), opts));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        detail::mmapDeallocate(p, n * sizeof(T), opts);
+    }
+
+    const MmapOptions& options() const noexcept { return opts; }
+
+private:
+    MmapOptions opts;
+};
+
+/* 只有阈值决定了一块内存是mmap出来的还是new出来的，阈值相同就可以互相释放 */
+template <typename T, typename U>
+bool operator==(const MmapAllocator<T>& a, const MmapAllocator<U>& b) noexcept {
+    return a.options().threshold == b.options().threshold;
+}
+
+template <typename T, typename U>
+bool operator!=(const MmapAllocator<T>& a, const MmapAllocator<U>& b) noexcept {
+    return !(a == b);
+}
+
+/**
+ * MemoryResource版本，配合默认的MyAllocList<T>（PolyAllocator）使用
+ */
+class MmapResource : public MemoryResource {
+public:
+    MmapResource() noexcept = default;
+    explicit MmapResource(const MmapOptions& opts) noexcept : opts(opts) {}
+
+private:
+    void* doAllocate(std::size_t bytes, std::size_t align) override {
+        if (detail::useMmap(bytes, opts))
+            return detail::mmapAllocate(bytes, opts);
+        return detail::alignedNew(bytes, align);
+    }
+
+    void doDeallocate(void* p, std::size_t bytes, std::size_t align) override {
+        if (detail::useMmap(bytes, opts))
+            detail::mmapDeallocate(p, bytes, opts);
+        else
+            detail::alignedDelete(p, align);
+    }
+
+    MmapOptions opts;
+};
+
+/**
+ * 直接建立在匿名映射上的动态数组，只接受平凡可复制的元素。
+ * 扩容时使用mremap(MREMAP_MAYMOVE)，内核只重新映射页表，不需要复制数据；
+ * 由于mremap对MAP_HUGETLB映射的支持依赖内核版本，这里只使用透明大页
+ */
+template <typename T>
+class MmapVector {
+    static_assert(std::is_trivially_copyable<T>::value, "MmapVector requires trivially copyable elements");
+
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    MmapVector() noexcept = default;
+
+    explicit MmapVector(bool populate) noexcept : populate(populate) {}
+
+    ~MmapVector() { release(); }
+
+    MmapVector(const MmapVector&) = delete;
+    MmapVector& operator=(const MmapVector&) = delete;
+
+    MmapVector(MmapVector&& other) noexcept
+    : buf(other.buf), len(other.len), cap(other.cap), populate(other.populate) {
+        other.buf = nullptr;
+        other.len = other.cap = 0;
+    }
+
+    MmapVector& operator=(MmapVector&& other) noexcept {
+        if (this != &other) {
+            release();
+            buf = other.buf;
+            len = other.len;
+            cap = other.cap;
+            populate = other.populate;
+            other.buf = nullptr;
+            other.len = other.cap = 0;
+        }
+        return *this;
+    }
+
+    void reserve(std::size_t n) {
+        if (n > cap)
+            regrow(n);
+    }
+
+    void resize(std::size_t n) {
+        reserve(n);
+        if (n > len)
+            std::memset(buf + len, 0, (n - len) * sizeof(T));
+        len = n;
+    }
+
+    void push_back(const T& v) {
+        if (len == cap)
+            regrow(cap == 0 ? detail::HugePageSize / sizeof(T) : cap * 2);
+        buf[len++] = v;
+    }
+
+    void clear() noexcept { len = 0; }
+
+    T& operator[](std::size_t i) noexcept { return buf[i]; }
+    const T& operator[](std::size_t i) const noexcept { return buf[i]; }
+
+    T* data() noexcept { return buf; }
+    const T* data() const noexcept { return buf; }
+    std::size_t size() const noexcept { return len; }
+    std::size_t capacity() const noexcept { return cap; }
+    bool empty() const noexcept { return len == 0; }
+
+    iterator begin() noexcept { return buf; }
+    iterator end() noexcept { return buf + len; }
+    const_iterator begin() const noexcept { return buf; }
+    const_iterator end() const noexcept { return buf + len; }
+    const_iterator cbegin() const noexcept { return buf; }
+    const_iterator cend() const noexcept { return buf + len; }
+
+private:
+    void regrow(std::size_t n) {
+        std::size_t newBytes = detail::mappingLength(n * sizeof(T));
+#ifdef __linux__
+        void* p;
+        if (buf == nullptr) {
+            p = detail::mapAligned(newBytes, 0);
+            if (p == nullptr)
+                throw std::bad_alloc();
+        } else {
+            p = ::mremap(buf, detail::mappingLength(cap * sizeof(T)), newBytes, MREMAP_MAYMOVE);
+            if (p == MAP_FAILED)
+                throw std::bad_alloc();
+        }
+        ::madvise(p, newBytes, MADV_HUGEPAGE);
+        if (populate) {
+            auto c = static_cast<volatile char*>(p);
+            for (std::size_t off = len * sizeof(T); off < newBytes; off += 4096)
+                c[off] = 0;
+        }
+#else
+        void* p = ::operator new(newBytes);
+        if (buf != nullptr) {
+            std::memcpy(p, buf, len * sizeof(T));
+            ::operator delete(buf);
+        }
+#endif
+        buf = static_cast<T*>(p);
+        cap = newBytes / sizeof(T);
+    }
+
+    void release() noexcept {
+        if (buf == nullptr)
+            return;
+#ifdef __linux__
+        ::munmap(buf, detail::mappingLength(cap * sizeof(T)));
+#else
+        ::operator delete(buf);
+#endif
+        buf = nullptr;
+        len = cap = 0;
+    }
+
+    T* buf = nullptr;
+    std::size_t len = 0;
+    std::size_t cap = 0;
+    bool populate = false;
+};
@@ -0,0 +1,389 @@
+/**
+ * @file ParallelAlgorithm.h
+ * @brief C++14下的并行find/transform/reduce/sort/count_if：分块后交给共享线程池执行，支持取消
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ * C++17才有执行策略（std::execution::par），这里用一个进程内共享的线程池实现同样的几个算法。
+ *
+ * - 区间被切成若干块，参与者（线程池中的线程和调用线程本身）从一个原子计数器上领取块，
+ *   调用线程也干活，因此线程池被占满或者在池中线程里嵌套调用时也不会死锁
+ * - 只支持随机访问迭代器，其他迭代器退化为对应的标准库串行算法
+ * - find找到匹配后，位于匹配之后的块不再需要检查，会尽快停下；
+ *   外部也可以通过CancellationToken取消，此时算法抛出OperationCancelled
+ * - 任何一块抛出的异常会取消其余的块，并在调用线程中重新抛出
+ */
+
+class CancellationToken {
+public:
+    void cancel() noexcept { flag.store(true, std::memory_order_relaxed); }
+    bool cancelled() const noexcept { return flag.load(std::memory_order_relaxed); }
+    void reset() noexcept { flag.store(false, std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> flag{false};
+};
+
+class OperationCancelled : public std::runtime_error {
+public:
+    OperationCancelled() : std::runtime_error("parallel operation cancelled") {}
+};
+
+struct ParallelOptions {
+    /* 最多使用的线程数（包括调用线程），0表示线程池线程数 + 1 */
+    std::size_t threads = 0;
+    /* 每块至少包含的元素个数，太小的块调度开销会超过收益 */
+    std::size_t grain = 1 << 15;
+    CancellationToken* cancel = nullptr;
+};
+
+/**
+ * 固定大小的线程池，进程内共享一个实例
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i)
+            workers.emplace_back([this] { run(); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto& w : workers)
+            w.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    static ThreadPool& shared() {
+        static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+        return pool;
+    }
+
+    std::size_t size() const noexcept { return workers.size(); }
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            tasks.push_back(std::move(task));
+        }
+        cv.notify_one();
+    }
+
+private:
+    void run() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lk(mutex);
+                cv.wait(lk, [this] { return stopping || !tasks.empty(); });
+                if (tasks.empty())
+                    return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+};
+
+namespace detail {
+
+/* 一次并行调用的共享状态，池中的任务可能在调用返回之后才开始运行，因此用shared_ptr持有 */
+struct ChunkJob {
+    std::size_t chunks = 0;
+    std::atomic<std::size_t> next{0};
+    std::atomic<bool> stop{false};
+    std::size_t finished = 0;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable done;
+    std::function<void(std::size_t)> body;
+    CancellationToken* cancel = nullptr;
+
+    bool stopped() const noexcept {
+        return stop.load(std::memory_order_relaxed) || (cancel != nullptr && cancel->cancelled());
+    }
+
+    /* 不断领取块直到领完；每个领到的块无论是否执行都要计入finished */
+    void work() {
+        for (;;) {
+            std::size_t c = next.fetch_add(1, std::memory_order_relaxed);
+            if (c >= chunks)
+                return;
+            if (!stopped()) {
+                try {
+                    body(c);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lk(mutex);
+                    if (!error)
+                        error = std::current_exception();
+                    stop.store(true, std::memory_order_relaxed);
+                }
+            }
+            std::lock_guard<std::mutex> lk(mutex);
+            if (++finished == chunks)
+                done.notify_all();
+        }
+    }
+};
+
+inline std::size_t participants(const ParallelOptions& opts) {
+    std::size_t limit = ThreadPool::shared().size() + 1;
+    return opts.threads == 0 ? limit : std::min(opts.threads, limit);
+}
+
+/* 把n个元素分成若干块，块数是参与者数的几倍，便于负载均衡 */
+inline std::size_t chunkCount(std::size_t n, const ParallelOptions& opts) {
+    std::size_t grain = std::max<std::size_t>(opts.grain, 1);
+    std::size_t byGrain = (n + grain - 1) / grain;
+    return std::max<std::size_t>(1, std::min(byGrain, participants(opts) * 4));
+}
+
+inline std::pair<std::size_t, std::size_t> chunkRange(std::size_t n, std::size_t chunks, std::size_t c) {
+    return {n * c / chunks, n * (c + 1) / chunks};
+}
+
+/**
+ * 并行执行body(0) ... body(chunks - 1)，返回时所有块都已结束
+ */
+template <typename Body>
+void parallelChunks(std::size_t chunks, const ParallelOptions& opts, Body&& body) {
+    if (opts.cancel != nullptr && opts.cancel->cancelled())
+        throw OperationCancelled();
+
+    auto job = std::make_shared<ChunkJob>();
+    job->chunks = chunks;
+    job->body = std::forward<Body>(body);
+    job->cancel = opts.cancel;
+
+    std::size_t helpers = std::min(participants(opts), chunks) - 1;
+    for (std::size_t i = 0; i < helpers; ++i)
+        ThreadPool::shared().submit([job] { job->work(); });
+    job->work();
+
+    std::unique_lock<std::mutex> lk(job->mutex);
+    job->done.wait(lk, [&] { return job->finished == job->chunks; });
+    if (job->error)
+        std::rethrow_exception(job->error);
+    if (opts.cancel != nullptr && opts.cancel->cancelled())
+        throw OperationCancelled();
+}
+
+template <typename It>
+using IsRandomAccess = std::is_base_of<std::random_access_iterator_tag,
+                                       typename std::iterator_traits<It>::iterator_category>;
+
+template <typename It, typename Pred>
+It parallelFindIf(It first, It last, Pred pred, const ParallelOptions&, std::false_type) {
+    return std::find_if(first, last, pred);
+}
+
+template <typename It, typename Pred>
+It parallelFindIf(It first, It last, Pred pred, const ParallelOptions& opts, std::true_type) {
+    std::size_t n = static_cast<std::size_t>(last - first);
+    std::size_t chunks = chunkCount(n, opts);
+    /* 目前找到的最靠前的匹配，起点在它之后的块和子块都可以跳过 */
+    std::atomic<std::size_t> best{n};
+    const std::size_t step = 4096;
+
+    parallelChunks(chunks, opts, [&](std::size_t c) {
+        auto range = chunkRange(n, chunks, c);
+        for (std::size_t b = range.first; b < range.second; b += step) {
+            if (b >= best.load(std::memory_order_relaxed) || (opts.cancel != nullptr && opts.cancel->cancelled()))
+                return;
+            std::size_t e = std::min(b + step, range.second);
+            It hit = std::find_if(first + b, first + e, pred);
+            if (hit != first + e) {
+                std::size_t i = static_cast<std::size_t>(hit - first);
+                std::size_t cur = best.load(std::memory_order_relaxed);
+                while (i < cur && !best.compare_exchange_weak(cur, i, std::memory_order_relaxed)) {
+                }
+                return;
+            }
+        }
+    });
+    return first + best.load();
+}
+
+template <typename It, typename OutIt, typename Op>
+OutIt parallelTransform(It first, It last, OutIt d_first, Op op, const ParallelOptions&, std::false_type) {
+    return std::transform(first, last, d_first, op);
+}
+
+template <typename It, typename OutIt, typename Op>
+OutIt parallelTransform(It first, It last, OutIt d_first, Op op, const ParallelOptions& opts, std::true_type) {
+    std::size_t n = static_cast<std::size_t>(last - first);
+    std::size_t chunks = chunkCount(n, opts);
+    parallelChunks(chunks, opts, [&](std::size_t c) {
+        auto range = chunkRange(n, chunks, c);
+        std::transform(first + range.first, first + range.second, d_first + range.first, op);
+    });
+    return d_first + n;
+}
+
+template <typename It, typename T, typename Op>
+T parallelReduce(It first, It last, T init, Op op, const ParallelOptions&, std::false_type) {
+    return std::accumulate(first, last, std::move(init), op);
+}
+
+template <typename It, typename T, typename Op>
+T parallelReduce(It first, It last, T init, Op op, const ParallelOptions& opts, std::true_type) {
+    std::size_t n = static_cast<std::size_t>(last - first);
+    if (n == 0)
+        return init;
+    std::size_t chunks = chunkCount(n, opts);
+    std::vector<T> partial(chunks);
+    parallelChunks(chunks, opts, [&](std::size_t c) {
+        auto range = chunkRange(n, chunks, c);
+        /* 用块内第一个元素作为初值，op不需要单位元 */
+        partial[c] = std::accumulate(first + range.first + 1, first + range.second,
+                                     static_cast<T>(first[range.first]), op);
+    });
+    for (auto& p : partial)
+        init = op(std::move(init), std::move(p));
+    return init;
+}
+
+template <typename It, typename Pred>
+typename std::iterator_traits<It>::difference_type
+parallelCountIf(It first, It last, Pred pred, const ParallelOptions&, std::false_type) {
+    return std::count_if(first, last, pred);
+}
+
+template <typename It, typename Pred>
+typename std::iterator_traits<It>::difference_type
+parallelCountIf(It first, It last, Pred pred, const ParallelOptions& opts, std::true_type) {
+    using Diff = typename std::iterator_traits<It>::difference_type;
+    std::size_t n = static_cast<std::size_t>(last - first);
+    std::size_t chunks = chunkCount(n, opts);
+    std::vector<Diff> partial(chunks);
+    parallelChunks(chunks, opts, [&](std::size_t c) {
+        auto range = chunkRange(n, chunks, c);
+        partial[c] = std::count_if(first + range.first, first + range.second, pred);
+    });
+    return std::accumulate(partial.begin(), partial.end(), Diff(0));
+}
+
+template <typename It, typename Compare>
+void parallelSort(It first, It last, Compare comp, const ParallelOptions&, std::false_type) {
+    std::sort(first, last, comp);
+}
+
+template <typename It, typename Compare>
+void parallelSort(It first, It last, Compare comp, const ParallelOptions& opts, std::true_type) {
+    std::size_t n = static_cast<std::size_t>(last - first);
+    std::size_t chunks = chunkCount(n, opts);
+    if (chunks == 1) {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    parallelChunks(chunks, opts, [&](std::size_t c) {
+        auto range = chunkRange(n, chunks, c);
+        std::sort(first + range.first, first + range.second, comp);
+    });
+
+    /* 每一轮把相邻的两组width个块归并成一组 */
+    for (std::size_t width = 1; width < chunks; width *= 2) {
+        std::size_t pairs = (chunks + 2 * width - 1) / (2 * width);
+        parallelChunks(pairs, opts, [&](std::size_t p) {
+            std::size_t lo = p * 2 * width;
+            std::size_t mid = std::min(lo + width, chunks);
+            std::size_t hi = std::min(lo + 2 * width, chunks);
+            if (mid == hi)
+                return;
+            std::inplace_merge(first + chunkRange(n, chunks, lo).first,
+                               first + chunkRange(n, chunks, mid).first,
+                               first + chunkRange(n, chunks, hi - 1).second, comp);
+        });
+    }
+}
+
+} // namespace detail
+
+/**
+ * 返回第一个满足pred的元素，与std::find_if的结果相同
+ */
+template <typename It, typename Pred>
+It parallelFindIf(It first, It last, Pred pred, const ParallelOptions& opts = ParallelOptions()) {
+    return detail::parallelFindIf(first, last, pred, opts, detail::IsRandomAccess<It>());
+}
+
+template <typename It, typename T>
+It parallelFind(It first, It last, const T& value, const ParallelOptions& opts = ParallelOptions()) {
+    return parallelFindIf(first, last, [&value](const auto& x) { return x == value; }, opts);
+}
+
+/**
+ * 对每个元素调用op，结果依次写入d_first开始的区间，返回写入区间的末尾
+ */
+template <typename It, typename OutIt, typename Op>
+OutIt parallelTransform(It first, It last, OutIt d_first, Op op, const ParallelOptions& opts = ParallelOptions()) {
+    using RandomAccess = std::integral_constant<bool, detail::IsRandomAccess<It>::value &&
+                                                          detail::IsRandomAccess<OutIt>::value>;
+    return detail::parallelTransform(first, last, d_first, op, opts, RandomAccess());
+}
+
+/**
+ * 用op归约区间，op必须满足结合律；各块的部分结果按顺序与init合并，因此op不需要满足交换律
+ */
+template <typename It, typename T, typename Op>
+T parallelReduce(It first, It last, T init, Op op, const ParallelOptions& opts = ParallelOptions()) {
+    return detail::parallelReduce(first, last, std::move(init), op, opts, detail::IsRandomAccess<It>());
+}
+
+template <typename It, typename T>
+T parallelReduce(It first, It last, T init, const ParallelOptions& opts = ParallelOptions()) {
+    return parallelReduce(first, last, std::move(init), std::plus<>(), opts);
+}
+
+template <typename It, typename Pred>
+typename std::iterator_traits<It>::difference_type
+parallelCountIf(It first, It last, Pred pred, const ParallelOptions& opts = ParallelOptions()) {
+    return detail::parallelCountIf(first, last, pred, opts, detail::IsRandomAccess<It>());
+}
+
+/**
+ * 先并行地对各块排序，再逐轮两两归并，每一轮内的归并也是并行的。与std::sort一样不保证稳定
+ */
+template <typename It, typename Compare>
+void parallelSort(It first, It last, Compare comp, const ParallelOptions& opts = ParallelOptions()) {
+    detail::parallelSort(first, last, comp, opts, detail::IsRandomAccess<It>());
+}
+
+template <typename It>
+void parallelSort(It first, It last, const ParallelOptions& opts = ParallelOptions()) {
+    parallelSort(first, last, std::less<>(), opts);
+}
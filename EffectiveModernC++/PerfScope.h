@@ -0,0 +1,291 @@
+/**
+ * @file PerfScope.h
+ * @brief 按作用域读取硬件性能计数器（周期、指令、缓存缺失、分支预测失败、上下文切换），按名字跨线程汇总
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#   include <linux/perf_event.h>
+#   include <sys/resource.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#   define CPPNOTE_PERF_EVENT 1
+#else
+#   define CPPNOTE_PERF_EVENT 0
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#   include <x86intrin.h>
+#   define CPPNOTE_RDTSC 1
+#else
+#   define CPPNOTE_RDTSC 0
+#endif
+
+/*
+ * 用法：
+ *
+ *   {
+ *       PerfScope scope("std::find");
+ *       ...                       // 被测量的代码
+ *   }
+ *   PerfScope::report();          // 打印每个名字的调用次数和各项计数之和
+ *
+ * - 每个线程第一次使用时用perf_event_open打开一组计数器（cycles为组长，instructions、cache-misses、
+ *   branch-misses为组员），只统计用户态、只统计本线程；进入和离开作用域时各读一次整组，差值累加到同名的汇总里。
+ *   多个线程使用同一个名字时，结果是这些线程的总和
+ * - 内核不允许（perf_event_paranoid过高、容器里被seccomp拦截）或者虚拟机没有PMU时，退回到rdtsc计时：
+ *   此时cycles是TSC的参考周期数，指令和缺失次数不可用，报告中显示为"-"
+ * - 上下文切换次数（主动+被动）和线程的CPU时间总是来自getrusage(RUSAGE_THREAD)，
+ *   CPU时间与经过时间对比可以区分忙等和阻塞
+ * - 计数器被复用（同时打开的事件多于硬件计数器）时，按time_enabled/time_running做比例换算
+ * - 设置环境变量CPPNOTE_NO_PERF可以强制使用退回方案
+ *
+ * 读一次计数器是一次系统调用（约1微秒），作用域应当包住足够多的工作
+ */
+
+struct PerfSample {
+    std::uint64_t cycles = 0;
+    std::uint64_t instructions = 0;
+    std::uint64_t cacheMisses = 0;
+    std::uint64_t branchMisses = 0;
+    std::uint64_t contextSwitches = 0;
+    std::uint64_t nanoseconds = 0;
+    /* 线程实际占用的CPU时间（用户态+内核态），阻塞等待时不增长 */
+    std::uint64_t cpuNanoseconds = 0;
+};
+
+enum class PerfSource {
+    Hardware,
+    Fallback
+};
+
+namespace detail {
+
+/* 每个线程一组计数器，线程结束时关闭 */
+class PerfThreadCounters {
+public:
+    PerfThreadCounters() {
+#if CPPNOTE_PERF_EVENT
+        if (std::getenv("CPPNOTE_NO_PERF") != nullptr)
+            return;
+        const std::uint64_t events[] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        for (std::size_t i = 0; i < EventCount; ++i) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = events[i];
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : fds[0], 0));
+            if (fd < 0) {
+                closeAll();
+                return;
+            }
+            fds[i] = fd;
+        }
+        hardware = true;
+#endif
+    }
+
+    PerfThreadCounters(const PerfThreadCounters&) = delete;
+    PerfThreadCounters& operator=(const PerfThreadCounters&) = delete;
+
+    ~PerfThreadCounters() { closeAll(); }
+
+    PerfSource source() const noexcept { return hardware ? PerfSource::Hardware : PerfSource::Fallback; }
+
+    /* 当前的累计值，两次读数相减得到区间内的计数 */
+    PerfSample read() const {
+        PerfSample s;
+        s.nanoseconds = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+#if CPPNOTE_PERF_EVENT
+        rusage usage;
+        if (getrusage(RUSAGE_THREAD, &usage) == 0) {
+            s.contextSwitches = static_cast<std::uint64_t>(usage.ru_nvcsw + usage.ru_nivcsw);
+            s.cpuNanoseconds = static_cast<std::uint64_t>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000u +
+                               static_cast<std::uint64_t>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000u;
+        }
+        if (hardware) {
+            /* {nr, time_enabled, time_running, values[nr]} */
+            std::uint64_t buf[3 + EventCount];
+            if (::read(fds[0], buf, sizeof(buf)) == static_cast<ssize_t>(sizeof(buf))) {
+                double scale = buf[2] == 0 ? 0.0 : static_cast<double>(buf[1]) / static_cast<double>(buf[2]);
+                s.cycles = static_cast<std::uint64_t>(static_cast<double>(buf[3]) * scale);
+                s.instructions = static_cast<std::uint64_t>(static_cast<double>(buf[4]) * scale);
+                s.cacheMisses = static_cast<std::uint64_t>(static_cast<double>(buf[5]) * scale);
+                s.branchMisses = static_cast<std::uint64_t>(static_cast<double>(buf[6]) * scale);
+            }
+            return s;
+        }
+#endif
+#if CPPNOTE_RDTSC
+        s.cycles = __rdtsc();
+#endif
+        return s;
+    }
+
+    static PerfThreadCounters& current() {
+        static thread_local PerfThreadCounters counters;
+        return counters;
+    }
+
+private:
+    static constexpr std::size_t EventCount = 4;
+
+    void closeAll() noexcept {
+#if CPPNOTE_PERF_EVENT
+        for (int& fd : fds) {
+            if (fd >= 0)
+                close(fd);
+            fd = -1;
+        }
+#endif
+        hardware = false;
+    }
+
+    int fds[EventCount] = {-1, -1, -1, -1};
+    bool hardware = false;
+};
+
+struct PerfTotals {
+    std::uint64_t calls = 0;
+    PerfSample sum;
+    /* 有任何一次来自退回方案，指令和缺失次数就不完整 */
+    bool allHardware = true;
+};
+
+class PerfRegistry {
+public:
+    static PerfRegistry& instance() {
+        static PerfRegistry registry;
+        return registry;
+    }
+
+    void add(const char* name, const PerfSample& d, PerfSource source) {
+        std::lock_guard<std::mutex> lock(m);
+        PerfTotals& t = find(name);
+        ++t.calls;
+        t.sum.cycles += d.cycles;
+        t.sum.instructions += d.instructions;
+        t.sum.cacheMisses += d.cacheMisses;
+        t.sum.branchMisses += d.branchMisses;
+        t.sum.contextSwitches += d.contextSwitches;
+        t.sum.nanoseconds += d.nanoseconds;
+        t.sum.cpuNanoseconds += d.cpuNanoseconds;
+        t.allHardware = t.allHardware && source == PerfSource::Hardware;
+    }
+
+    std::vector<std::pair<std::string, PerfTotals>> snapshot() {
+        std::lock_guard<std::mutex> lock(m);
+        return totals;
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(m);
+        totals.clear();
+    }
+
+private:
+    /* 名字不多，按第一次出现的顺序保存，报告也按这个顺序 */
+    PerfTotals& find(const char* name) {
+        for (auto& t : totals)
+            if (t.first == name)
+                return t.second;
+        totals.emplace_back(name, PerfTotals());
+        return totals.back().second;
+    }
+
+    std::mutex m;
+    std::vector<std::pair<std::string, PerfTotals>> totals;
+};
+
+} // namespace detail
+
+class PerfScope {
+public:
+    /* name在析构时才用来查找汇总项，必须比作用域活得久，通常是字符串字面量 */
+    explicit PerfScope(const char* name)
+    : name(name), counters(detail::PerfThreadCounters::current()), start(counters.read()) {}
+
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+
+    ~PerfScope() {
+        PerfSample end = counters.read();
+        PerfSample d;
+        d.cycles = end.cycles - start.cycles;
+        d.instructions = end.instructions - start.instructions;
+        d.cacheMisses = end.cacheMisses - start.cacheMisses;
+        d.branchMisses = end.branchMisses - start.branchMisses;
+        d.contextSwitches = end.contextSwitches - start.contextSwitches;
+        d.nanoseconds = end.nanoseconds - start.nanoseconds;
+        d.cpuNanoseconds = end.cpuNanoseconds - start.cpuNanoseconds;
+        detail::PerfRegistry::instance().add(name, d, counters.source());
+    }
+
+    /* 当前线程使用的是硬件计数器还是退回方案 */
+    static PerfSource source() { return detail::PerfThreadCounters::current().source(); }
+
+    /**
+     * 打印到目前为止每个名字的汇总，cycles/instructions等都是所有调用、所有线程之和
+     */
+    static void report(std::ostream& os = std::cout) {
+        auto totals = detail::PerfRegistry::instance().snapshot();
+        char line[320];
+        std::snprintf(line, sizeof(line), "  %-42s %8s %10s %10s %14s %14s %6s %12s %12s %8s", "scope", "calls",
+                      "ms", "cpu ms", "cycles", "instructions", "IPC", "cache-miss", "branch-miss", "ctx-sw");
+        os << line << '\n';
+        for (const auto& t : totals) {
+            const PerfSample& s = t.second.sum;
+            double ms = static_cast<double>(s.nanoseconds) / 1e6;
+            double cpuMs = static_cast<double>(s.cpuNanoseconds) / 1e6;
+            if (t.second.allHardware) {
+                double ipc = s.cycles == 0 ? 0.0 : static_cast<double>(s.instructions) / static_cast<double>(s.cycles);
+                std::snprintf(line, sizeof(line), "  %-42s %8llu %10.3f %10.3f %14llu %14llu %6.2f %12llu %12llu %8llu",
+                              t.first.c_str(), static_cast<unsigned long long>(t.second.calls), ms, cpuMs,
+                              static_cast<unsigned long long>(s.cycles), static_cast<unsigned long long>(s.instructions),
+                              ipc, static_cast<unsigned long long>(s.cacheMisses),
+                              static_cast<unsigned long long>(s.branchMisses),
+                              static_cast<unsigned long long>(s.contextSwitches));
+            } else {
+                /* 退回方案的cycles是TSC周期，其余硬件事件不可用 */
+                std::snprintf(line, sizeof(line), "  %-42s %8llu %10.3f %10.3f %13lluT %14s %6s %12s %12s %8llu",
+                              t.first.c_str(), static_cast<unsigned long long>(t.second.calls), ms, cpuMs,
+                              static_cast<unsigned long long>(s.cycles), "-", "-", "-", "-",
+                              static_cast<unsigned long long>(s.contextSwitches));
+            }
+            os << line << '\n';
+        }
+        bool fallback = false;
+        for (const auto& t : totals)
+            fallback = fallback || !t.second.allHardware;
+        if (fallback)
+            os << "  (perf_event_open unavailable: cycles marked T are TSC reference cycles)\n";
+        os.flush();
+    }
+
+    static void reset() { detail::PerfRegistry::instance().reset(); }
+
+private:
+    const char* name;
+    detail::PerfThreadCounters& counters;
+    PerfSample start;
+};
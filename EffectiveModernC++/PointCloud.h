@@ -0,0 +1,442 @@
+/**
+ * @file PointCloud.h
+ * @brief 按结构数组（SoA）存放的二维点集，x、y分别存放在对齐并补齐的数组中，批量变换和查询使用SIMD
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include "Allocator.h"
+#include "SimdFind.h"
+
+/*
+ * std::vector<Point>中x和y交错存放（AoS），对所有点的x做同一个运算时，一次向量加载只有一半是有用的，
+ * 还需要额外的重排。PointCloud把所有x放在一个数组、所有y放在另一个数组（SoA）：
+ * - 两个数组按64字节对齐，容量补齐到8个double（一个AVX-512向量）的整数倍，
+ *   平移、缩放、旋转直接按整向量处理到补齐后的末尾，不需要标量收尾；补齐部分的值没有意义
+ * - 包围盒和最近点这样的归约只处理前size()个元素，不足一个向量的结尾用标量处理
+ * - 内核用GCC的向量扩展写成与宽度无关的模板，再用__attribute__((target(...)))分别编译出
+ *   SSE2/AVX2/AVX-512版本，第一次使用时按detectSimdLevel()选择
+ * - operator[]返回代理对象，xValue()/yValue()/setX()/setY()的用法与Point相同
+ *
+ * Point需要提供Point(double, double)构造函数以及xValue()/yValue()
+ */
+
+namespace detail {
+
+/* 一次批量操作需要的内核，按指令集各有一组 */
+struct PointKernels {
+    void (*translate)(double* x, double* y, std::size_t padded, double dx, double dy);
+    void (*scale)(double* x, double* y, std::size_t padded, double sx, double sy);
+    void (*rotate)(double* x, double* y, std::size_t padded, double c, double s);
+    /* out = {minX, minY, maxX, maxY} */
+    void (*bounds)(const double* x, const double* y, std::size_t n, double* out);
+    std::size_t (*nearest)(const double* x, const double* y, std::size_t n, double qx, double qy);
+};
+
+constexpr std::size_t PointLanes = 8;
+constexpr std::size_t PointAlign = 64;
+
+template <int W>
+struct PointVec {
+    typedef double D __attribute__((vector_size(W * sizeof(double))));
+    typedef std::int64_t I __attribute__((vector_size(W * sizeof(std::int64_t))));
+};
+
+#define CPPNOTE_POINT_KERNEL inline __attribute__((always_inline))
+
+template <int W>
+CPPNOTE_POINT_KERNEL void translateKernel(double* x, double* y, std::size_t padded, double dx, double dy) {
+    using D = typename PointVec<W>::D;
+    for (std::size_t i = 0; i < padded; i += W) {
+        *reinterpret_cast<D*>(x + i) += dx;
+        *reinterpret_cast<D*>(y + i) += dy;
+    }
+}
+
+template <int W>
+CPPNOTE_POINT_KERNEL void scaleKernel(double* x, double* y, std::size_t padded, double sx, double sy) {
+    using D = typename PointVec<W>::D;
+    for (std::size_t i = 0; i < padded; i += W) {
+        *reinterpret_cast<D*>(x + i) *= sx;
+        *reinterpret_cast<D*>(y + i) *= sy;
+    }
+}
+
+template <int W>
+CPPNOTE_POINT_KERNEL void rotateKernel(double* x, double* y, std::size_t padded, double c, double s) {
+    using D = typename PointVec<W>::D;
+    for (std::size_t i = 0; i < padded; i += W) {
+        D vx = *reinterpret_cast<D*>(x + i);
+        D vy = *reinterpret_cast<D*>(y + i);
+        *reinterpret_cast<D*>(x + i) = vx * c - vy * s;
+        *reinterpret_cast<D*>(y + i) = vx * s + vy * c;
+    }
+}
+
+template <int W>
+CPPNOTE_POINT_KERNEL void boundsKernel(const double* x, const double* y, std::size_t n, double* out) {
+    using D = typename PointVec<W>::D;
+    const double inf = std::numeric_limits<double>::infinity();
+    D minX = D{} + inf, minY = D{} + inf, maxX = D{} - inf, maxY = D{} - inf;
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+        D vx = *reinterpret_cast<const D*>(x + i);
+        D vy = *reinterpret_cast<const D*>(y + i);
+        minX = vx < minX ? vx : minX;
+        minY = vy < minY ? vy : minY;
+        maxX = vx > maxX ? vx : maxX;
+        maxY = vy > maxY ? vy : maxY;
+    }
+    out[0] = out[1] = inf;
+    out[2] = out[3] = -inf;
+    for (int k = 0; k < W; ++k) {
+        out[0] = std::min(out[0], minX[k]);
+        out[1] = std::min(out[1], minY[k]);
+        out[2] = std::max(out[2], maxX[k]);
+        out[3] = std::max(out[3], maxY[k]);
+    }
+    for (; i < n; ++i) {
+        out[0] = std::min(out[0], x[i]);
+        out[1] = std::min(out[1], y[i]);
+        out[2] = std::max(out[2], x[i]);
+        out[3] = std::max(out[3], y[i]);
+    }
+}
+
+/* 每个通道各自记录最近的距离和下标，最后合并；距离相同时取下标较小的，与逐个比较的结果一致 */
+template <int W>
+CPPNOTE_POINT_KERNEL std::size_t nearestKernel(const double* x, const double* y, std::size_t n, double qx, double qy) {
+    using D = typename PointVec<W>::D;
+    using I = typename PointVec<W>::I;
+    const double inf = std::numeric_limits<double>::infinity();
+    D best = D{} + inf;
+    I bestIndex = I{} - 1;
+    I index = I{};
+    for (int k = 0; k < W; ++k)
+        index[k] = k;
+
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+        D dx = *reinterpret_cast<const D*>(x + i) - qx;
+        D dy = *reinterpret_cast<const D*>(y + i) - qy;
+        D d = dx * dx + dy * dy;
+        I closer = d < best;
+        best = closer ? d : best;
+        bestIndex = closer ? index : bestIndex;
+        index += W;
+    }
+
+    double bestD = inf;
+    std::size_t result = n;
+    for (int k = 0; k < W; ++k) {
+        auto j = static_cast<std::size_t>(bestIndex[k]);
+        if (bestIndex[k] >= 0 && (best[k] < bestD || (best[k] == bestD && j < result))) {
+            bestD = best[k];
+            result = j;
+        }
+    }
+    for (; i < n; ++i) {
+        double dx = x[i] - qx, dy = y[i] - qy;
+        double d = dx * dx + dy * dy;
+        if (d < bestD) {
+            bestD = d;
+            result = i;
+        }
+    }
+    /* 所有距离都是NaN时退回第一个点 */
+    return result == n && n > 0 ? 0 : result;
+}
+
+#undef CPPNOTE_POINT_KERNEL
+
+template <int W>
+const PointKernels& genericPointKernels() {
+    static const PointKernels kernels{
+        [](double* x, double* y, std::size_t n, double a, double b) { translateKernel<W>(x, y, n, a, b); },
+        [](double* x, double* y, std::size_t n, double a, double b) { scaleKernel<W>(x, y, n, a, b); },
+        [](double* x, double* y, std::size_t n, double a, double b) { rotateKernel<W>(x, y, n, a, b); },
+        [](const double* x, const double* y, std::size_t n, double* out) { boundsKernel<W>(x, y, n, out); },
+        [](const double* x, const double* y, std::size_t n, double qx, double qy) {
+            return nearestKernel<W>(x, y, n, qx, qy);
+        },
+    };
+    return kernels;
+}
+
+#if CPPNOTE_SIMD_X86
+
+/* lambda不能带target属性，按指令集各写一组普通函数 */
+#define CPPNOTE_POINT_TARGET_KERNELS(Name, Target, W)                                                        \
+    __attribute__((target(Target))) inline void translate##Name(double* x, double* y, std::size_t n,         \
+                                                                double a, double b) {                        \
+        translateKernel<W>(x, y, n, a, b);                                                                   \
+    }                                                                                                        \
+    __attribute__((target(Target))) inline void scale##Name(double* x, double* y, std::size_t n, double a,   \
+                                                            double b) {                                      \
+        scaleKernel<W>(x, y, n, a, b);                                                                       \
+    }                                                                                                        \
+    __attribute__((target(Target))) inline void rotate##Name(double* x, double* y, std::size_t n, double a,  \
+                                                             double b) {                                     \
+        rotateKernel<W>(x, y, n, a, b);                                                                      \
+    }                                                                                                        \
+    __attribute__((target(Target))) inline void bounds##Name(const double* x, const double* y, std::size_t n, \
+                                                             double* out) {                                  \
+        boundsKernel<W>(x, y, n, out);                                                                       \
+    }                                                                                                        \
+    __attribute__((target(Target))) inline std::size_t nearest##Name(const double* x, const double* y,       \
+                                                                     std::size_t n, double qx, double qy) {  \
+        return nearestKernel<W>(x, y, n, qx, qy);                                                            \
+    }
+
+CPPNOTE_POINT_TARGET_KERNELS(Sse2, "sse2", 2)
+CPPNOTE_POINT_TARGET_KERNELS(Avx2, "avx2", 4)
+CPPNOTE_POINT_TARGET_KERNELS(Avx512, "avx512f", 8)
+
+#undef CPPNOTE_POINT_TARGET_KERNELS
+
+#endif // CPPNOTE_SIMD_X86
+
+inline const PointKernels& pointKernels(SimdLevel level) {
+#if CPPNOTE_SIMD_X86
+    static const PointKernels sse2{&translateSse2, &scaleSse2, &rotateSse2, &boundsSse2, &nearestSse2};
+    static const PointKernels avx2{&translateAvx2, &scaleAvx2, &rotateAvx2, &boundsAvx2, &nearestAvx2};
+    static const PointKernels avx512{&translateAvx512, &scaleAvx512, &rotateAvx512, &boundsAvx512,
+                                     &nearestAvx512};
+    switch (level) {
+        case SimdLevel::AVX512: return avx512;
+        case SimdLevel::AVX2:   return avx2;
+        case SimdLevel::SSE2:   return sse2;
+        default:                break;
+    }
+#else
+    (void)level;
+#endif
+    return genericPointKernels<1>();
+}
+
+inline const PointKernels& pointKernels() {
+    static const PointKernels& kernels = pointKernels(detectSimdLevel());
+    return kernels;
+}
+
+} // namespace detail
+
+template <typename Point>
+class PointCloud {
+public:
+    using size_type = std::size_t;
+    static constexpr size_type npos = static_cast<size_type>(-1);
+
+    /**
+     * 指向第i个点的代理，接口与Point一致，可以隐式转换为Point
+     */
+    class Reference {
+    public:
+        double xValue() const noexcept { return *px; }
+        double yValue() const noexcept { return *py; }
+        void setX(double newX) noexcept { *px = newX; }
+        void setY(double newY) noexcept { *py = newY; }
+
+        operator Point() const { return Point(*px, *py); }
+
+        Reference(const Reference&) noexcept = default;
+
+        /* 赋值的是指向的坐标而不是代理本身，cloud[i] = cloud[j]复制第j个点 */
+        Reference& operator=(const Reference& other) noexcept {
+            *px = *other.px;
+            *py = *other.py;
+            return *this;
+        }
+
+        Reference& operator=(const Point& p) {
+            *px = p.xValue();
+            *py = p.yValue();
+            return *this;
+        }
+
+        /* 代理是右值，std::swap无法绑定；通过ADL找到这个重载：using std::swap; swap(cloud[i], cloud[j]) */
+        friend void swap(Reference a, Reference b) noexcept {
+            std::swap(*a.px, *b.px);
+            std::swap(*a.py, *b.py);
+        }
+
+    private:
+        friend class PointCloud;
+        Reference(double* px, double* py) noexcept : px(px), py(py) {}
+
+        double* px;
+        double* py;
+    };
+
+    PointCloud() noexcept = default;
+
+    explicit PointCloud(size_type n) {
+        resize(n);
+    }
+
+    PointCloud(const PointCloud& other) {
+        reserve(other.n);
+        copyFrom(other);
+    }
+
+    PointCloud(PointCloud&& other) noexcept : xs(other.xs), ys(other.ys), n(other.n), cap(other.cap) {
+        other.xs = other.ys = nullptr;
+        other.n = other.cap = 0;
+    }
+
+    PointCloud& operator=(PointCloud other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ~PointCloud() {
+        freeArray(xs);
+        freeArray(ys);
+    }
+
+    void swap(PointCloud& other) noexcept {
+        std::swap(xs, other.xs);
+        std::swap(ys, other.ys);
+        std::swap(n, other.n);
+        std::swap(cap, other.cap);
+    }
+
+    size_type size() const noexcept { return n; }
+    size_type capacity() const noexcept { return cap; }
+    bool empty() const noexcept { return n == 0; }
+
+    /* 两个数组各自连续，可以直接交给其他向量化代码 */
+    double* xData() noexcept { return xs; }
+    double* yData() noexcept { return ys; }
+    const double* xData() const noexcept { return xs; }
+    const double* yData() const noexcept { return ys; }
+
+    Reference operator[](size_type i) noexcept { return Reference(xs + i, ys + i); }
+    Point operator[](size_type i) const { return Point(xs[i], ys[i]); }
+
+    void reserve(size_type count) {
+        if (count > cap)
+            regrow(padded(count));
+    }
+
+    void resize(size_type count) {
+        reserve(count);
+        if (count > n) {
+            std::fill(xs + n, xs + count, 0.0);
+            std::fill(ys + n, ys + count, 0.0);
+        }
+        n = count;
+    }
+
+    void clear() noexcept { n = 0; }
+
+    void push_back(const Point& p) { emplace_back(p.xValue(), p.yValue()); }
+
+    void emplace_back(double x, double y) {
+        if (n == cap)
+            regrow(cap == 0 ? detail::PointLanes * 8 : cap * 2);
+        xs[n] = x;
+        ys[n] = y;
+        ++n;
+    }
+
+    /* ---------------- 批量操作 ---------------- */
+
+    void translate(double dx, double dy) noexcept {
+        detail::pointKernels().translate(xs, ys, padded(n), dx, dy);
+    }
+
+    /* 以原点为中心缩放 */
+    void scale(double sx, double sy) noexcept {
+        detail::pointKernels().scale(xs, ys, padded(n), sx, sy);
+    }
+
+    /* 绕原点逆时针旋转radians弧度 */
+    void rotate(double radians) noexcept {
+        detail::pointKernels().rotate(xs, ys, padded(n), std::cos(radians), std::sin(radians));
+    }
+
+    /**
+     * 包围盒{左下角, 右上角}，点集为空时两个角分别是(+inf, +inf)和(-inf, -inf)
+     */
+    std::pair<Point, Point> boundingBox() const {
+        double b[4];
+        detail::pointKernels().bounds(xs, ys, n, b);
+        return {Point(b[0], b[1]), Point(b[2], b[3])};
+    }
+
+    /**
+     * 离q最近的点的下标，距离相同时取下标较小的；点集为空时返回npos
+     */
+    size_type nearest(const Point& q) const noexcept {
+        if (n == 0)
+            return npos;
+        return detail::pointKernels().nearest(xs, ys, n, q.xValue(), q.yValue());
+    }
+
+private:
+    static size_type padded(size_type count) noexcept {
+        return (count + detail::PointLanes - 1) / detail::PointLanes * detail::PointLanes;
+    }
+
+    static double* allocateArray(size_type count) {
+        auto p = static_cast<double*>(detail::alignedNew(count * sizeof(double), detail::PointAlign));
+        std::memset(p, 0, count * sizeof(double));
+        return p;
+    }
+
+    static void freeArray(double* p) noexcept {
+        if (p != nullptr)
+            detail::alignedDelete(p, detail::PointAlign);
+    }
+
+    void regrow(size_type newCap) {
+        double* nx = allocateArray(newCap);
+        double* ny;
+        try {
+            ny = allocateArray(newCap);
+        } catch (...) {
+            freeArray(nx);
+            throw;
+        }
+        if (n > 0) {
+            std::memcpy(nx, xs, n * sizeof(double));
+            std::memcpy(ny, ys, n * sizeof(double));
+        }
+        freeArray(xs);
+        freeArray(ys);
+        xs = nx;
+        ys = ny;
+        cap = newCap;
+    }
+
+    void copyFrom(const PointCloud& other) {
+        if (other.n > 0) {
+            std::memcpy(xs, other.xs, other.n * sizeof(double));
+            std::memcpy(ys, other.ys, other.n * sizeof(double));
+        }
+        n = other.n;
+    }
+
+    double* xs = nullptr;
+    double* ys = nullptr;
+    size_type n = 0;
+    size_type cap = 0;
+};
+
+template <typename Point>
+constexpr typename PointCloud<Point>::size_type PointCloud<Point>::npos;
+
+template <typename Point>
+void swap(PointCloud<Point>& a, PointCloud<Point>& b) noexcept {
+    a.swap(b);
+}
@@ -0,0 +1,389 @@
+/**
+ * @file SimdFind.h
+ * @brief 算术类型的向量化find内核，运行时根据CPU选择SSE2/AVX2/AVX-512
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#   define CPPNOTE_SIMD_X86 1
+#   include <immintrin.h>
+#else
+#   define CPPNOTE_SIMD_X86 0
+#endif
+
+/*
+ * std::find对算术类型也是一次比较一个元素。这里按元素宽度一次比较16/32/64字节：
+ * - 先用一次非对齐加载检查开头，然后把指针对齐到向量宽度，主循环只做对齐加载
+ * - 结尾不足一个向量的部分，用一次与前面重叠的非对齐加载处理
+ * - 浮点数使用有序相等比较（_CMP_EQ_OQ），因此NaN永远不相等，+0.0与-0.0相等，和operator==一致
+ *
+ * 内核用__attribute__((target(...)))单独编译，整个工程不需要打开-mavx2，
+ * 第一次调用时根据__builtin_cpu_supports选择可用的最高指令集
+ */
+
+enum class SimdLevel {
+    Scalar,
+    SSE2,
+    AVX2,
+    AVX512
+};
+
+inline const char* simdLevelName(SimdLevel level) noexcept {
+    switch (level) {
+        case SimdLevel::SSE2:   return "SSE2";
+        case SimdLevel::AVX2:   return "AVX2";
+        case SimdLevel::AVX512: return "AVX-512";
+        default:                return "scalar";
+    }
+}
+
+inline SimdLevel detectSimdLevel() noexcept {
+#if CPPNOTE_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+        return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return SimdLevel::SSE2;
+#endif
+    return SimdLevel::Scalar;
+}
+
+/* long double和bool不参与向量化，前者宽度不统一，后者的对象表示不一定只有0/1 */
+template <typename T>
+struct IsSimdFindable
+    : std::integral_constant<bool, std::is_arithmetic<T>::value && !std::is_same<T, bool>::value &&
+                                   sizeof(T) <= 8> {};
+
+namespace detail {
+
+template <typename T>
+const T* scalarFind(const T* first, const T* last, T value) {
+    for (; first != last; ++first)
+        if (*first == value)
+            return first;
+    return last;
+}
+
+#if CPPNOTE_SIMD_X86
+
+/* 1/2/4/8表示对应宽度的整数，-4/-8表示float/double */
+template <int K>
+using LaneKind = std::integral_constant<int, K>;
+
+template <typename T>
+using LaneKindOf = LaneKind<std::is_floating_point<T>::value ? -static_cast<int>(sizeof(T))
+                                                             : static_cast<int>(sizeof(T))>;
+
+inline int ctz32(std::uint32_t m) noexcept { return __builtin_ctz(m); }
+inline int ctz64(std::uint64_t m) noexcept { return __builtin_ctzll(m); }
+
+/* ---------------- SSE2：16字节，movemask_epi8得到按字节的掩码 ---------------- */
+
+__attribute__((target("sse2"))) inline __m128i eq128(__m128i a, __m128i b, LaneKind<1>) { return _mm_cmpeq_epi8(a, b); }
+__attribute__((target("sse2"))) inline __m128i eq128(__m128i a, __m128i b, LaneKind<2>) { return _mm_cmpeq_epi16(a, b); }
+__attribute__((target("sse2"))) inline __m128i eq128(__m128i a, __m128i b, LaneKind<4>) { return _mm_cmpeq_epi32(a, b); }
+__attribute__((target("sse2"))) inline __m128i eq128(__m128i a, __m128i b, LaneKind<8>) {
+    /* SSE2没有64位比较，两个32位的半边都相等才算相等 */
+    __m128i e = _mm_cmpeq_epi32(a, b);
+    return _mm_and_si128(e, _mm_shuffle_epi32(e, 0xB1));
+}
+__attribute__((target("sse2"))) inline __m128i eq128(__m128i a, __m128i b, LaneKind<-4>) {
+    return _mm_castps_si128(_mm_cmpeq_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b)));
+}
+__attribute__((target("sse2"))) inline __m128i eq128(__m128i a, __m128i b, LaneKind<-8>) {
+    return _mm_castpd_si128(_mm_cmpeq_pd(_mm_castsi128_pd(a), _mm_castsi128_pd(b)));
+}
+
+template <typename T>
+__attribute__((target("sse2"))) std::uint32_t mask128(const T* p, __m128i needle, bool aligned) {
+    __m128i v = aligned ? _mm_load_si128(reinterpret_cast<const __m128i*>(p))
+                        : _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(eq128(v, needle, LaneKindOf<T>())));
+}
+
+template <typename T>
+__attribute__((target("sse2"))) const T* findSse2(const T* first, const T* last, T value) {
+    constexpr std::ptrdiff_t Lanes = 16 / sizeof(T);
+    if (last - first < Lanes)
+        return scalarFind(first, last, value);
+
+    T lanes[Lanes];
+    std::fill(lanes, lanes + Lanes, value);
+    __m128i needle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lanes));
+
+    std::uint32_t m = mask128(first, needle, false);
+    if (m != 0)
+        return first + ctz32(m) / sizeof(T);
+
+    /* 对齐到16字节，与开头检查过的部分重叠没有关系 */
+    const T* p = reinterpret_cast<const T*>((reinterpret_cast<std::uintptr_t>(first) + 16) & ~std::uintptr_t(15));
+    for (; last - p >= 4 * Lanes; p += 4 * Lanes) {
+        std::uint32_t m0 = mask128(p, needle, true);
+        std::uint32_t m1 = mask128(p + Lanes, needle, true);
+        std::uint32_t m2 = mask128(p + 2 * Lanes, needle, true);
+        std::uint32_t m3 = mask128(p + 3 * Lanes, needle, true);
+        if ((m0 | m1 | m2 | m3) != 0) {
+            std::uint64_t lo = m0 | (static_cast<std::uint64_t>(m1) << 16);
+            std::uint64_t hi = m2 | (static_cast<std::uint64_t>(m3) << 16);
+            if (lo != 0)
+                return p + ctz64(lo) / sizeof(T);
+            return p + 2 * Lanes + ctz64(hi) / sizeof(T);
+        }
+    }
+    for (; last - p >= Lanes; p += Lanes) {
+        m = mask128(p, needle, true);
+        if (m != 0)
+            return p + ctz32(m) / sizeof(T);
+    }
+    if (p != last) {
+        const T* tail = last - Lanes;
+        m = mask128(tail, needle, false);
+        if (m != 0)
+            return tail + ctz32(m) / sizeof(T);
+    }
+    return last;
+}
+
+/* ---------------- AVX2：32字节 ---------------- */
+
+__attribute__((target("avx2"))) inline __m256i eq256(__m256i a, __m256i b, LaneKind<1>) { return _mm256_cmpeq_epi8(a, b); }
+__attribute__((target("avx2"))) inline __m256i eq256(__m256i a, __m256i b, LaneKind<2>) { return _mm256_cmpeq_epi16(a, b); }
+__attribute__((target("avx2"))) inline __m256i eq256(__m256i a, __m256i b, LaneKind<4>) { return _mm256_cmpeq_epi32(a, b); }
+__attribute__((target("avx2"))) inline __m256i eq256(__m256i a, __m256i b, LaneKind<8>) { return _mm256_cmpeq_epi64(a, b); }
+__attribute__((target("avx2"))) inline __m256i eq256(__m256i a, __m256i b, LaneKind<-4>) {
+    return _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b), _CMP_EQ_OQ));
+}
+__attribute__((target("avx2"))) inline __m256i eq256(__m256i a, __m256i b, LaneKind<-8>) {
+    return _mm256_castpd_si256(_mm256_cmp_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b), _CMP_EQ_OQ));
+}
+
+template <typename T>
+__attribute__((target("avx2"))) std::uint32_t mask256(const T* p, __m256i needle, bool aligned) {
+    __m256i v = aligned ? _mm256_load_si256(reinterpret_cast<const __m256i*>(p))
+                        : _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    return static_cast<std::uint32_t>(_mm256_movemask_epi8(eq256(v, needle, LaneKindOf<T>())));
+}
+
+template <typename T>
+__attribute__((target("avx2"))) const T* findAvx2(const T* first, const T* last, T value) {
+    constexpr std::ptrdiff_t Lanes = 32 / sizeof(T);
+    if (last - first < Lanes)
+        return findSse2(first, last, value);
+
+    T lanes[Lanes];
+    std::fill(lanes, lanes + Lanes, value);
+    __m256i needle = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes));
+
+    std::uint32_t m = mask256(first, needle, false);
+    if (m != 0)
+        return first + ctz32(m) / sizeof(T);
+
+    const T* p = reinterpret_cast<const T*>((reinterpret_cast<std::uintptr_t>(first) + 32) & ~std::uintptr_t(31));
+    for (; last - p >= 2 * Lanes; p += 2 * Lanes) {
+        std::uint32_t m0 = mask256(p, needle, true);
+        std::uint32_t m1 = mask256(p + Lanes, needle, true);
+        if ((m0 | m1) != 0) {
+            std::uint64_t all = m0 | (static_cast<std::uint64_t>(m1) << 32);
+            return p + ctz64(all) / sizeof(T);
+        }
+    }
+    for (; last - p >= Lanes; p += Lanes) {
+        m = mask256(p, needle, true);
+        if (m != 0)
+            return p + ctz32(m) / sizeof(T);
+    }
+    if (p != last) {
+        const T* tail = last - Lanes;
+        m = mask256(tail, needle, false);
+        if (m != 0)
+            return tail + ctz32(m) / sizeof(T);
+    }
+    return last;
+}
+
+/* ---------------- AVX-512：64字节，比较结果直接是按元素的掩码 ---------------- */
+
+#define CPPNOTE_AVX512 __attribute__((target("avx512f,avx512bw")))
+
+CPPNOTE_AVX512 inline std::uint64_t eq512(__m512i a, __m512i b, LaneKind<1>) { return _mm512_cmpeq_epi8_mask(a, b); }
+CPPNOTE_AVX512 inline std::uint64_t eq512(__m512i a, __m512i b, LaneKind<2>) { return _mm512_cmpeq_epi16_mask(a, b); }
+CPPNOTE_AVX512 inline std::uint64_t eq512(__m512i a, __m512i b, LaneKind<4>) { return _mm512_cmpeq_epi32_mask(a, b); }
+CPPNOTE_AVX512 inline std::uint64_t eq512(__m512i a, __m512i b, LaneKind<8>) { return _mm512_cmpeq_epi64_mask(a, b); }
+CPPNOTE_AVX512 inline std::uint64_t eq512(__m512i a, __m512i b, LaneKind<-4>) {
+    return _mm512_cmp_ps_mask(_mm512_castsi512_ps(a), _mm512_castsi512_ps(b), _CMP_EQ_OQ);
+}
+CPPNOTE_AVX512 inline std::uint64_t eq512(__m512i a, __m512i b, LaneKind<-8>) {
+    return _mm512_cmp_pd_mask(_mm512_castsi512_pd(a), _mm512_castsi512_pd(b), _CMP_EQ_OQ);
+}
+
+template <typename T>
+CPPNOTE_AVX512 std::uint64_t mask512(const T* p, __m512i needle, bool aligned) {
+    __m512i v = aligned ? _mm512_load_si512(p) : _mm512_loadu_si512(p);
+    return eq512(v, needle, LaneKindOf<T>());
+}
+
+template <typename T>
+CPPNOTE_AVX512 const T* findAvx512(const T* first, const T* last, T value) {
+    constexpr std::ptrdiff_t Lanes = 64 / sizeof(T);
+    if (last - first < Lanes)
+        return findAvx2(first, last, value);
+
+    T lanes[Lanes];
+    std::fill(lanes, lanes + Lanes, value);
+    __m512i needle = _mm512_loadu_si512(lanes);
+
+    std::uint64_t m = mask512(first, needle, false);
+    if (m != 0)
+        return first + ctz64(m);
+
+    const T* p = reinterpret_cast<const T*>((reinterpret_cast<std::uintptr_t>(first) + 64) & ~std::uintptr_t(63));
+    for (; last - p >= Lanes; p += Lanes) {
+        m = mask512(p, needle, true);
+        if (m != 0)
+            return p + ctz64(m);
+    }
+    if (p != last) {
+        const T* tail = last - Lanes;
+        m = mask512(tail, needle, false);
+        if (m != 0)
+            return tail + ctz64(m);
+    }
+    return last;
+}
+
+#undef CPPNOTE_AVX512
+
+#endif // CPPNOTE_SIMD_X86
+
+template <typename T>
+using FindKernel = const T* (*)(const T*, const T*, T);
+
+/* 内核假定元素按自身宽度对齐，这样对齐到向量宽度之后仍然落在元素边界上 */
+template <typename T>
+const T* dispatchFind(FindKernel<T> kernel, const T* first, const T* last, T value) {
+    if (reinterpret_cast<std::uintptr_t>(first) % sizeof(T) != 0)
+        return scalarFind(first, last, value);
+    return kernel(first, last, value);
+}
+
+template <typename T>
+FindKernel<T> findKernel(SimdLevel level) noexcept {
+#if CPPNOTE_SIMD_X86
+    switch (level) {
+        case SimdLevel::AVX512: return &findAvx512<T>;
+        case SimdLevel::AVX2:   return &findAvx2<T>;
+        case SimdLevel::SSE2:   return &findSse2<T>;
+        default:                break;
+    }
+#else
+    (void)level;
+#endif
+    return &scalarFind<T>;
+}
+
+} // namespace detail
+
+/**
+ * 在[first, last)中查找value，指定指令集，主要给测试和基准使用
+ */
+template <typename T>
+const T* simdFindWith(SimdLevel level, const T* first, const T* last, T value) {
+    static_assert(IsSimdFindable<T>::value, "simdFind only supports arithmetic element types");
+    return detail::dispatchFind(detail::findKernel<T>(level), first, last, value);
+}
+
+/**
+ * 在[first, last)中查找value，第一次调用时选择当前CPU支持的最高指令集
+ */
+template <typename T>
+const T* simdFind(const T* first, const T* last, T value) {
+    static_assert(IsSimdFindable<T>::value, "simdFind only supports arithmetic element types");
+    static const detail::FindKernel<T> kernel = detail::findKernel<T>(detectSimdLevel());
+    return detail::dispatchFind(kernel, first, last, value);
+}
+
+/*
+ * 判断容器的元素是否连续存放。C++14没有contiguous_iterator的概念，只能按容器列举：
+ * std::vector（vector<bool>除外）、std::array、std::basic_string以及内建数组
+ */
+template <typename C>
+struct IsContiguousContainer : std::false_type {};
+
+template <typename T, typename A>
+struct IsContiguousContainer<std::vector<T, A>> : std::true_type {};
+
+template <typename A>
+struct IsContiguousContainer<std::vector<bool, A>> : std::false_type {};
+
+template <typename T, std::size_t N>
+struct IsContiguousContainer<std::array<T, N>> : std::true_type {};
+
+template <typename T, typename Tr, typename A>
+struct IsContiguousContainer<std::basic_string<T, Tr, A>> : std::true_type {};
+
+template <typename T, std::size_t N>
+struct IsContiguousContainer<T[N]> : std::true_type {};
+
+namespace detail {
+
+template <typename T, typename V>
+using UseSimdFind = std::integral_constant<bool, std::is_same<T, V>::value && IsSimdFindable<V>::value>;
+
+template <typename T, typename V>
+const T* contiguousFind(const T* first, const T* last, const V& value, std::true_type) {
+    return simdFind(first, last, value);
+}
+
+template <typename T, typename V>
+const T* contiguousFind(const T* first, const T* last, const V& value, std::false_type) {
+    return std::find(first, last, value);
+}
+
+template <typename C, typename V>
+auto containerFind(const C& c, const V& value, std::true_type) {
+    auto first = std::begin(c);
+    auto n = std::distance(first, std::end(c));
+    if (n == 0)
+        return first;
+    const V* data = &*first;
+    return first + (simdFind(data, data + n, value) - data);
+}
+
+template <typename C, typename V>
+auto containerFind(const C& c, const V& value, std::false_type) {
+    return std::find(std::begin(c), std::end(c), value);
+}
+
+} // namespace detail
+
+/**
+ * 在连续区间[first, last)中查找value，元素型别与value型别完全相同的算术类型走向量化内核，其余情况等价于std::find
+ */
+template <typename T, typename V>
+const T* contiguousFind(const T* first, const T* last, const V& value) {
+    return detail::contiguousFind(first, last, value, detail::UseSimdFind<T, V>());
+}
+
+/**
+ * 在整个容器中查找value并返回const_iterator。
+ * 连续容器且元素型别与value型别完全相同的算术类型走向量化内核，其余情况等价于std::find
+ */
+template <typename C, typename V>
+auto containerFind(const C& c, const V& value) {
+    using Elem = std::decay_t<decltype(*std::begin(c))>;
+    using UseSimd = std::integral_constant<bool, IsContiguousContainer<C>::value && detail::UseSimdFind<Elem, V>::value>;
+    return detail::containerFind(c, value, UseSimd());
+}
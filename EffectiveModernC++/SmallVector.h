@@ -0,0 +1,349 @@
+/**
+ * @file SmallVector.h
+ * @brief 带内联存储的vector：不超过N个元素时放在对象内部，不分配堆内存
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/*
+ * std::vector<int> v{1, 2, 3}即使只有3个元素，也要在堆上分配一次，再从initializer_list拷贝进去。
+ * 大多数序列都很短时，SmallVector<T, N>把前N个元素放在对象内部的缓冲区里：
+ * - size() <= N时不分配内存，构造、遍历、析构都不碰堆；超过N才搬到堆上，之后和std::vector一样按2倍增长
+ * - 支持大括号初始化。initializer_list的元素是const的，只能拷贝，这一点和std::vector相同，
+ *   但拷贝的目的地是内联缓冲区
+ * - emplace_back/emplace原地构造，元素可以是只能移动的类型（std::unique_ptr等）
+ * - 代价是对象本身变大（N * sizeof(T)），移动内联存储的SmallVector要逐个移动元素，是O(size())的；
+ *   迭代器在元素搬到堆上时失效，规则与std::vector相同
+ */
+template <typename T, std::size_t N>
+class SmallVector {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    SmallVector() noexcept : ptr(inlineData()) {}
+
+    explicit SmallVector(size_type n) : SmallVector() { resize(n); }
+
+    SmallVector(size_type n, const T& value) : SmallVector() { resize(n, value); }
+
+    template <typename It, typename = typename std::iterator_traits<It>::iterator_category>
+    SmallVector(It first, It last) : SmallVector() {
+        append(first, last, typename std::iterator_traits<It>::iterator_category());
+    }
+
+    SmallVector(std::initializer_list<T> init) : SmallVector(init.begin(), init.end()) {}
+
+    SmallVector(const SmallVector& other) : SmallVector(other.begin(), other.end()) {}
+
+    SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible<T>::value) : SmallVector() {
+        takeFrom(other);
+    }
+
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) {
+            clear();
+            append(other.begin(), other.end(), std::random_access_iterator_tag());
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept(std::is_nothrow_move_constructible<T>::value) {
+        if (this != &other) {
+            clear();
+            release();
+            ptr = inlineData();
+            cap = N;
+            takeFrom(other);
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(std::initializer_list<T> init) {
+        clear();
+        append(init.begin(), init.end(), std::random_access_iterator_tag());
+        return *this;
+    }
+
+    ~SmallVector() {
+        clear();
+        release();
+    }
+
+    void swap(SmallVector& other) {
+        if (!isInline() && !other.isInline()) {
+            std::swap(ptr, other.ptr);
+            std::swap(sz, other.sz);
+            std::swap(cap, other.cap);
+            return;
+        }
+        SmallVector tmp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    iterator begin() noexcept { return ptr; }
+    iterator end() noexcept { return ptr + sz; }
+    const_iterator begin() const noexcept { return ptr; }
+    const_iterator end() const noexcept { return ptr + sz; }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    T* data() noexcept { return ptr; }
+    const T* data() const noexcept { return ptr; }
+
+    size_type size() const noexcept { return sz; }
+    size_type capacity() const noexcept { return cap; }
+    bool empty() const noexcept { return sz == 0; }
+    static constexpr size_type inlineCapacity() noexcept { return N; }
+
+    /* 元素是否还在对象内部的缓冲区中 */
+    bool isInline() const noexcept { return ptr == inlineData(); }
+
+    T& operator[](size_type i) noexcept { return ptr[i]; }
+    const T& operator[](size_type i) const noexcept { return ptr[i]; }
+
+    T& at(size_type i) {
+        if (i >= sz)
+            throw std::out_of_range("SmallVector::at");
+        return ptr[i];
+    }
+
+    const T& at(size_type i) const {
+        if (i >= sz)
+            throw std::out_of_range("SmallVector::at");
+        return ptr[i];
+    }
+
+    T& front() noexcept { return ptr[0]; }
+    const T& front() const noexcept { return ptr[0]; }
+    T& back() noexcept { return ptr[sz - 1]; }
+    const T& back() const noexcept { return ptr[sz - 1]; }
+
+    void reserve(size_type n) {
+        if (n > cap)
+            regrow(n);
+    }
+
+    void resize(size_type n) {
+        reserve(n);
+        for (; sz < n; ++sz)
+            ::new (static_cast<void*>(ptr + sz)) T();
+        destroyTail(n);
+    }
+
+    void resize(size_type n, const T& value) {
+        if (n > cap) {
+            /* value可能引用自身的元素，先拷贝一份 */
+            T copy(value);
+            regrow(n);
+            for (; sz < n; ++sz)
+                ::new (static_cast<void*>(ptr + sz)) T(copy);
+        } else {
+            for (; sz < n; ++sz)
+                ::new (static_cast<void*>(ptr + sz)) T(value);
+        }
+        destroyTail(n);
+    }
+
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (sz == cap)
+            return growAndEmplaceBack(std::forward<Args>(args)...);
+        ::new (static_cast<void*>(ptr + sz)) T(std::forward<Args>(args)...);
+        return ptr[sz++];
+    }
+
+    void pop_back() noexcept { ptr[--sz].~T(); }
+
+    iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+    iterator insert(const_iterator pos, T&& value) { return emplace(pos, std::move(value)); }
+
+    template <typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args) {
+        size_type i = static_cast<size_type>(pos - begin());
+        if (i == sz) {
+            emplace_back(std::forward<Args>(args)...);
+            return begin() + i;
+        }
+        /* 参数可能引用容器中的元素，先构造好再搬动 */
+        T value(std::forward<Args>(args)...);
+        emplace_back(std::move(back()));
+        std::move_backward(begin() + i, end() - 2, end() - 1);
+        ptr[i] = std::move(value);
+        return begin() + i;
+    }
+
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        iterator f = begin() + (first - cbegin());
+        iterator l = begin() + (last - cbegin());
+        if (f != l)
+            destroyTail(static_cast<size_type>(std::move(l, end(), f) - begin()));
+        return f;
+    }
+
+    void clear() noexcept { destroyTail(0); }
+
+private:
+    T* inlineData() noexcept { return reinterpret_cast<T*>(&storage); }
+    const T* inlineData() const noexcept { return reinterpret_cast<const T*>(&storage); }
+
+    void destroyTail(size_type n) noexcept {
+        for (; sz > n; --sz)
+            ptr[sz - 1].~T();
+    }
+
+    void release() noexcept {
+        if (!isInline())
+            std::allocator<T>().deallocate(ptr, cap);
+    }
+
+    /* 把[src, src + n)搬到不重叠的dst；平凡可复制的元素直接memcpy */
+    static void relocateRange(T* dst, T* src, size_type n, std::true_type) {
+        if (n > 0)
+            std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), n * sizeof(T));
+    }
+
+    /*
+     * 和std::vector一样：移动构造可能抛异常而拷贝构造可用时改用拷贝；先构造完整个新区间再析构旧元素，
+     * 中途抛出异常时析构已经构造的部分，旧元素保持不变
+     */
+    static void relocateRange(T* dst, T* src, size_type n, std::false_type) {
+        size_type k = 0;
+        try {
+            for (; k < n; ++k)
+                ::new (static_cast<void*>(dst + k)) T(std::move_if_noexcept(src[k]));
+        } catch (...) {
+            while (k > 0)
+                dst[--k].~T();
+            throw;
+        }
+        for (k = 0; k < n; ++k)
+            src[k].~T();
+    }
+
+    static void relocateRange(T* dst, T* src, size_type n) {
+        relocateRange(dst, src, n, std::is_trivially_copyable<T>());
+    }
+
+    /* 元素全部搬到nb之后才释放旧缓冲区；搬移时抛出异常则自身不变，nb由调用方释放 */
+    void adopt(T* nb, size_type n) {
+        relocateRange(nb, ptr, sz);
+        release();
+        ptr = nb;
+        cap = n;
+    }
+
+    void regrow(size_type n) {
+        std::allocator<T> alloc;
+        T* nb = alloc.allocate(n);
+        try {
+            adopt(nb, n);
+        } catch (...) {
+            alloc.deallocate(nb, n);
+            throw;
+        }
+    }
+
+    size_type grownCapacity(size_type n) const noexcept { return std::max(n, cap * 2); }
+
+    /* 新元素先构造到新缓冲区，参数引用旧缓冲区中的元素时也是安全的 */
+    template <typename... Args>
+    T& growAndEmplaceBack(Args&&... args) {
+        size_type n = grownCapacity(sz + 1);
+        std::allocator<T> alloc;
+        T* nb = alloc.allocate(n);
+        try {
+            ::new (static_cast<void*>(nb + sz)) T(std::forward<Args>(args)...);
+        } catch (...) {
+            alloc.deallocate(nb, n);
+            throw;
+        }
+        try {
+            adopt(nb, n);
+        } catch (...) {
+            nb[sz].~T();
+            alloc.deallocate(nb, n);
+            throw;
+        }
+        return ptr[sz++];
+    }
+
+    template <typename It>
+    void append(It first, It last, std::input_iterator_tag) {
+        for (; first != last; ++first)
+            emplace_back(*first);
+    }
+
+    template <typename It>
+    void append(It first, It last, std::forward_iterator_tag) {
+        reserve(sz + static_cast<size_type>(std::distance(first, last)));
+        for (; first != last; ++first, ++sz)
+            ::new (static_cast<void*>(ptr + sz)) T(*first);
+    }
+
+    /* 调用前自身为空且使用内联存储：堆上的元素直接接管指针，内联的元素逐个移动 */
+    void takeFrom(SmallVector& other) {
+        if (!other.isInline()) {
+            ptr = other.ptr;
+            sz = other.sz;
+            cap = other.cap;
+            other.ptr = other.inlineData();
+            other.sz = 0;
+            other.cap = N;
+            return;
+        }
+        for (; sz < other.sz; ++sz)
+            ::new (static_cast<void*>(ptr + sz)) T(std::move(other.ptr[sz]));
+        other.clear();
+    }
+
+    std::aligned_storage_t<sizeof(T) * (N == 0 ? 1 : N), alignof(T)> storage;
+    T* ptr;
+    size_type sz = 0;
+    size_type cap = N;
+};
+
+template <typename T, std::size_t N>
+void swap(SmallVector<T, N>& a, SmallVector<T, N>& b) {
+    a.swap(b);
+}
+
+template <typename T, std::size_t N>
+bool operator==(const SmallVector<T, N>& a, const SmallVector<T, N>& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+template <typename T, std::size_t N>
+bool operator!=(const SmallVector<T, N>& a, const SmallVector<T, N>& b) {
+    return !(a == b);
+}
+
+template <typename T, std::size_t N>
+bool operator<(const SmallVector<T, N>& a, const SmallVector<T, N>& b) {
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+}
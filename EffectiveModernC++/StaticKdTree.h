@@ -0,0 +1,185 @@
+/**
+ * @file StaticKdTree.h
+ * @brief 可以在编译期构建的二维k-d树：索引放在只读数据区，运行期的最近邻和范围查询不分配内存
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <limits>
+
+/*
+ * 数据集在编译期就确定时（地理围栏、参考网格），可以让编译器把索引也建好：
+ * - 树是隐式的：区间[lo, hi)的根是中点mid = (lo + hi) / 2处的点，左右子树分别是[lo, mid)和[mid + 1, hi)，
+ *   第d层按x（d为偶数）或y（d为奇数）划分，不需要存储任何指针
+ * - 构建时对每个区间做一次快速选择，把中位数放到mid，总代价O(N log N)，能够在编译器的constexpr求值限制内完成
+ * - C++14中std::array的非const operator[]和std::swap、std::nth_element都不是constexpr的，
+ *   因此内部用自己的ConstexprArray并手写选择算法
+ * - 同一个构造函数在运行期调用就是普通的运行期构建，便于对比
+ *
+ * Point需要有constexpr的默认构造函数、拷贝赋值以及xValue()/yValue()
+ */
+
+template <typename T, std::size_t N>
+struct ConstexprArray {
+    T data[N == 0 ? 1 : N];
+
+    constexpr T& operator[](std::size_t i) { return data[i]; }
+    constexpr const T& operator[](std::size_t i) const { return data[i]; }
+    static constexpr std::size_t size() { return N; }
+};
+
+template <typename Point, std::size_t N>
+class StaticKdTree {
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    constexpr explicit StaticKdTree(const std::array<Point, N>& input) : points(), index() {
+        /* 构建时只重排下标，最后按下标把点放到树中的位置；constexpr求值中搬动整个Point的代价很高 */
+        for (std::size_t i = 0; i < N; ++i)
+            index[i] = i;
+        build(input, 0, N, 0);
+        for (std::size_t i = 0; i < N; ++i)
+            points[i] = input[index[i]];
+    }
+
+    static constexpr std::size_t size() { return N; }
+
+    /* 树中第i个位置上的点，以及它在原数组中的下标 */
+    constexpr const Point& point(std::size_t i) const { return points[i]; }
+    constexpr std::size_t originalIndex(std::size_t i) const { return index[i]; }
+
+    /**
+     * 离q最近的点在原数组中的下标，距离相同时返回原下标较小的；树为空时返回npos
+     */
+    constexpr std::size_t nearest(const Point& q) const {
+        Best best{std::numeric_limits<double>::infinity(), npos};
+        nearest(q, 0, N, 0, best);
+        return best.index;
+    }
+
+    /**
+     * 对落在闭区间[lo, hi]矩形内的每个点调用f(原下标, 点)
+     */
+    template <typename F>
+    void forEachInRange(const Point& lo, const Point& hi, F&& f) const {
+        range(lo, hi, 0, N, 0, f);
+    }
+
+    constexpr std::size_t countInRange(const Point& lo, const Point& hi) const {
+        Counter counter{0};
+        range(lo, hi, 0, N, 0, counter);
+        return counter.count;
+    }
+
+private:
+    struct Best {
+        double dist;
+        std::size_t index;
+    };
+
+    struct Counter {
+        std::size_t count;
+        constexpr void operator()(std::size_t, const Point&) { ++count; }
+    };
+
+    static constexpr double coord(const Point& p, unsigned axis) { return axis == 0 ? p.xValue() : p.yValue(); }
+
+    /* 按axis比较树中位置a和b上的点，坐标相同时按原下标，保证是全序 */
+    constexpr bool less(const std::array<Point, N>& input, std::size_t a, std::size_t b, unsigned axis) const {
+        double ca = coord(input[index[a]], axis), cb = coord(input[index[b]], axis);
+        return ca < cb || (ca == cb && index[a] < index[b]);
+    }
+
+    constexpr void swapAt(std::size_t a, std::size_t b) {
+        std::size_t i = index[a];
+        index[a] = index[b];
+        index[b] = i;
+    }
+
+    /* 快速选择：把[lo, hi)中按axis排第k的点放到k，左边都不大于它，右边都不小于它 */
+    constexpr void select(const std::array<Point, N>& input, std::size_t lo, std::size_t hi, std::size_t k,
+                          unsigned axis) {
+        while (hi - lo > 1) {
+            /* 三数取中作为枢轴，放到hi - 1 */
+            std::size_t mid = lo + (hi - lo) / 2;
+            if (less(input, mid, lo, axis))
+                swapAt(mid, lo);
+            if (less(input, hi - 1, lo, axis))
+                swapAt(hi - 1, lo);
+            if (less(input, mid, hi - 1, axis))
+                swapAt(mid, hi - 1);
+            std::size_t store = lo;
+            for (std::size_t i = lo; i < hi - 1; ++i) {
+                if (less(input, i, hi - 1, axis))
+                    swapAt(i, store++);
+            }
+            swapAt(store, hi - 1);
+            if (store == k)
+                return;
+            if (k < store)
+                hi = store;
+            else
+                lo = store + 1;
+        }
+    }
+
+    constexpr void build(const std::array<Point, N>& input, std::size_t lo, std::size_t hi, unsigned depth) {
+        if (hi - lo <= 1)
+            return;
+        std::size_t mid = lo + (hi - lo) / 2;
+        select(input, lo, hi, mid, depth % 2);
+        build(input, lo, mid, depth + 1);
+        build(input, mid + 1, hi, depth + 1);
+    }
+
+    constexpr void nearest(const Point& q, std::size_t lo, std::size_t hi, unsigned depth, Best& best) const {
+        if (lo >= hi)
+            return;
+        std::size_t mid = lo + (hi - lo) / 2;
+        const Point& p = points[mid];
+        double dx = p.xValue() - q.xValue(), dy = p.yValue() - q.yValue();
+        double d = dx * dx + dy * dy;
+        if (d < best.dist || (d == best.dist && index[mid] < best.index))
+            best = Best{d, index[mid]};
+
+        /* 先进入q所在的一侧，另一侧只有在分割线比当前最优距离更近时才需要看 */
+        double diff = coord(q, depth % 2) - coord(p, depth % 2);
+        bool leftFirst = diff < 0;
+        nearest(q, leftFirst ? lo : mid + 1, leftFirst ? mid : hi, depth + 1, best);
+        if (diff * diff <= best.dist)
+            nearest(q, leftFirst ? mid + 1 : lo, leftFirst ? hi : mid, depth + 1, best);
+    }
+
+    template <typename F>
+    constexpr void range(const Point& lo, const Point& hi, std::size_t b, std::size_t e, unsigned depth, F& f) const {
+        if (b >= e)
+            return;
+        std::size_t mid = b + (e - b) / 2;
+        const Point& p = points[mid];
+        if (p.xValue() >= lo.xValue() && p.xValue() <= hi.xValue() && p.yValue() >= lo.yValue() &&
+            p.yValue() <= hi.yValue())
+            f(index[mid], p);
+        unsigned axis = depth % 2;
+        if (coord(lo, axis) <= coord(p, axis))
+            range(lo, hi, b, mid, depth + 1, f);
+        if (coord(hi, axis) >= coord(p, axis))
+            range(lo, hi, mid + 1, e, depth + 1, f);
+    }
+
+    ConstexprArray<Point, N> points;
+    ConstexprArray<std::size_t, N> index;
+};
+
+template <typename Point, std::size_t N>
+constexpr std::size_t StaticKdTree<Point, N>::npos;
+
+/**
+ * 从std::array构建k-d树，用constexpr变量接收结果时整棵树在编译期建好
+ */
+template <typename Point, std::size_t N>
+constexpr StaticKdTree<Point, N> makeStaticKdTree(const std::array<Point, N>& points) {
+    return StaticKdTree<Point, N>(points);
+}
@@ -0,0 +1,195 @@
+/**
+ * @file StaticPow.h
+ * @brief 指数为编译期常量的pow<Exp>(x)：在编译期选出乘法链并展开；运行期指数通过跳转表分派到这些特化
+ * @date 2026/10/18
+ */
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "ConstexprMath.h"
+
+/*
+ * x^Exp需要的乘法次数取决于乘法链的选法：
+ * - 二进制法：偶数次幂取平方，奇数次幂再乘一次x，x^15需要6次乘法
+ * - 因子法：Exp = p·q时先求y = x^q再求y^p，x^15 = (x^3)^5只需要5次乘法
+ * 这里在编译期对每个指数比较两种拆法的乘法次数，选更少的那个，再用模板递归展开成直线代码。
+ * 对于浮点数，展开后的结果与std::pow可能在最后一位上有差别（乘法的舍入顺序不同）；
+ * 对于整数，和普通乘法一样不检查溢出，需要检查时使用ipow
+ */
+
+namespace detail {
+
+enum class PowStep { Zero, One, Square, MulX, Compose };
+
+constexpr unsigned smallestFactor(unsigned e) {
+    for (unsigned p = 3; p * p <= e; p += 2)
+        if (e % p == 0)
+            return p;
+    return e;
+}
+
+/* 按下面的拆法求x^e需要的乘法次数 */
+constexpr unsigned powCost(unsigned e) {
+    if (e <= 1)
+        return 0;
+    if (e % 2 == 0)
+        return powCost(e / 2) + 1;
+    unsigned p = smallestFactor(e);
+    unsigned viaMul = powCost(e - 1) + 1;
+    return p == e ? viaMul : (viaMul < powCost(p) + powCost(e / p) ? viaMul : powCost(p) + powCost(e / p));
+}
+
+constexpr PowStep powStep(unsigned e) {
+    if (e == 0)
+        return PowStep::Zero;
+    if (e == 1)
+        return PowStep::One;
+    if (e % 2 == 0)
+        return PowStep::Square;
+    unsigned p = smallestFactor(e);
+    return p != e && powCost(p) + powCost(e / p) < powCost(e - 1) + 1 ? PowStep::Compose : PowStep::MulX;
+}
+
+template <unsigned E, PowStep = powStep(E)>
+struct PowChain;
+
+template <unsigned E>
+struct PowChain<E, PowStep::Zero> {
+    template <typename T>
+    static constexpr T apply(T) { return T(1); }
+};
+
+template <unsigned E>
+struct PowChain<E, PowStep::One> {
+    template <typename T>
+    static constexpr T apply(T x) { return x; }
+};
+
+template <unsigned E>
+struct PowChain<E, PowStep::Square> {
+    template <typename T>
+    static constexpr T apply(T x) {
+        T y = PowChain<E / 2>::apply(x);
+        return y * y;
+    }
+};
+
+template <unsigned E>
+struct PowChain<E, PowStep::MulX> {
+    template <typename T>
+    static constexpr T apply(T x) { return x * PowChain<E - 1>::apply(x); }
+};
+
+template <unsigned E>
+struct PowChain<E, PowStep::Compose> {
+    static constexpr unsigned P = smallestFactor(E);
+
+    template <typename T>
+    static constexpr T apply(T x) { return PowChain<P>::apply(PowChain<E / P>::apply(x)); }
+};
+
+template <int Exp, typename T>
+constexpr T staticPow(T x, std::false_type /* Exp >= 0 */) {
+    return PowChain<static_cast<unsigned>(Exp)>::apply(x);
+}
+
+template <int Exp, typename T>
+constexpr T staticPow(T x, std::true_type /* Exp < 0 */) {
+    static_assert(std::is_floating_point<T>::value, "negative exponents require a floating-point base");
+    return T(1) / PowChain<static_cast<unsigned>(-Exp)>::apply(x);
+}
+
+} // namespace detail
+
+/**
+ * x的Exp次幂，展开为编译期选定的乘法链；负指数只支持浮点数
+ */
+template <int Exp, typename T>
+constexpr T pow(T x) {
+    static_assert(std::is_arithmetic<T>::value, "pow<Exp> requires an arithmetic type");
+    return detail::staticPow<Exp>(x, std::integral_constant<bool, (Exp < 0)>());
+}
+
+/* 编译期展开所需的乘法次数，便于和二进制法比较 */
+template <unsigned Exp>
+constexpr unsigned powMultiplications() {
+    return detail::powCost(Exp);
+}
+
+namespace detail {
+
+template <typename T>
+T powFallback(T x, int e, std::true_type /* floating */) {
+    return std::pow(x, static_cast<T>(e));
+}
+
+/* 整数的负指数和Item15的pow一样抛出std::domain_error */
+template <typename T>
+void checkPowExponent(int, std::true_type /* floating */) {}
+
+template <typename T>
+void checkPowExponent(int e, std::false_type /* integral */) {
+    if (e < 0)
+        throw std::domain_error("negative exponent");
+}
+
+template <typename T>
+T powFallback(T x, int e, std::false_type /* integral */) {
+    checkPowExponent<T>(e, std::false_type());
+    return ipow(x, static_cast<unsigned>(e));
+}
+
+template <typename T, std::size_t... I>
+constexpr auto powJumpTable(std::index_sequence<I...>) {
+    using Fn = T (*)(T);
+    return std::array<Fn, sizeof...(I)>{{&pow<static_cast<int>(I), T>...}};
+}
+
+/* 对整个数组求同一个指数的幂，循环体是展开的乘法链，编译器可以向量化 */
+template <int Exp, typename T>
+void powLoop(const T* in, T* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = pow<Exp>(in[i]);
+}
+
+template <typename T, std::size_t... I>
+constexpr auto powLoopTable(std::index_sequence<I...>) {
+    using Fn = void (*)(const T*, T*, std::size_t);
+    return std::array<Fn, sizeof...(I)>{{&powLoop<static_cast<int>(I), T>...}};
+}
+
+} // namespace detail
+
+/**
+ * 指数在[0, MaxExp]内时通过跳转表调用对应的pow<Exp>特化，范围之外退回std::pow（整数退回ipow）。
+ * 整数的指数为负时抛出std::domain_error
+ */
+template <int MaxExp = 32, typename T>
+T powDispatch(T x, int e) {
+    static constexpr auto table = detail::powJumpTable<T>(std::make_index_sequence<MaxExp + 1>());
+    if (static_cast<unsigned>(e) <= static_cast<unsigned>(MaxExp))
+        return table[e](x);
+    return detail::powFallback(x, e, std::is_floating_point<T>());
+}
+
+/**
+ * out[i] = in[i]^e。整个数组只分派一次，热循环中没有间接调用
+ */
+template <int MaxExp = 32, typename T>
+void powDispatch(const T* in, T* out, std::size_t n, int e) {
+    static constexpr auto table = detail::powLoopTable<T>(std::make_index_sequence<MaxExp + 1>());
+    if (static_cast<unsigned>(e) <= static_cast<unsigned>(MaxExp)) {
+        table[e](in, out, n);
+        return;
+    }
+    detail::checkPowExponent<T>(e, std::is_floating_point<T>());
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = detail::powFallback(in[i], e, std::is_floating_point<T>());
+}